@@ -3,11 +3,27 @@
 #include <ngl/AbstractVAO.h>
 #include <ngl/Obj.h>
 #include <ngl/Text.h>
+#include <ngl/Texture.h>
 #include "WindowParams.h"
+#include "FrameStats.h"
+#include "FrameGraph.h"
+#include "RenderScheduler.h"
+#include "InstancePool.h"
+#include "InputRecorder.h"
+#include "DepthPyramid.h"
+#include "HiZCuller.h"
+#include "ImpostorAtlas.h"
+#include "InstanceBuffer.h"
+#include "RadixSort.h"
+#include "GpuTimer.h"
+#include "MemoryRegistry.h"
+#include "TileStreamer.h"
+#include "StartupGraph.h"
+#include "CounterRandom.h"
 #include <QOpenGLWindow>
 #include <QTimer>
 #include <memory>
-#include <QElapsedTimer>
+#include <vector>
 
 //----------------------------------------------------------------------------------------------------------------------
 /// @file NGLScene.h
@@ -48,6 +64,84 @@ public:
   /// @brief this is called everytime we resize
   //----------------------------------------------------------------------------------------------------------------------
   void resizeGL(int _w, int _h) override;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief set the frame time above which a frame is counted as a stutter
+  /// @param[in] _ms the budget in ms
+  //----------------------------------------------------------------------------------------------------------------------
+  void setFrameBudget(float _ms);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief set how we schedule re-draws, see RenderScheduler
+  /// @param[in] _mode the mode to use
+  //----------------------------------------------------------------------------------------------------------------------
+  void setRenderMode(RenderScheduler::Mode _mode);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief set the number of trees, must be called before the window is shown
+  //----------------------------------------------------------------------------------------------------------------------
+  void setNumTrees(size_t _count) { m_numTrees = _count; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief how many trees are re-scaled each frame (0 for a static scene)
+  //----------------------------------------------------------------------------------------------------------------------
+  void setChangesPerFrame(size_t _count);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief re-upload all of the transforms once this fraction of them are dirty
+  //----------------------------------------------------------------------------------------------------------------------
+  void setFullUploadFraction(float _fraction) { m_trees.store().setFullUploadFraction(_fraction); }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief how many trees are removed and added each frame to benchmark the instance pool
+  //----------------------------------------------------------------------------------------------------------------------
+  void setChurnPerFrame(size_t _count);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief record the camera to a file (written on exit)
+  //----------------------------------------------------------------------------------------------------------------------
+  void recordInput(const std::string &_fileName);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief replay a recording, live input is overridden while replaying
+  /// @param[in] _fileName the recording
+  /// @param[in] _quitWhenDone exit the application after the last event
+  /// @returns false if the file could not be read
+  //----------------------------------------------------------------------------------------------------------------------
+  bool replayInput(const std::string &_fileName, bool _quitWhenDone);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief frustum and Hi-Z occlusion cull the trees on the GPU (needs GL 4.3)
+  //----------------------------------------------------------------------------------------------------------------------
+  void setCulling(bool _enable) { m_culling = _enable; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draw the trees beyond a distance as impostors (needs GL 4.3 as the split is done by the culling)
+  /// @param[in] _enable use impostors
+  /// @param[in] _distance the distance at which the fade to impostors starts
+  /// @param[in] _fade the width of the fade band
+  //----------------------------------------------------------------------------------------------------------------------
+  void setImpostors(bool _enable, float _distance = 350.0f, float _fade = 50.0f);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draw the trees front to back, they are only re-sorted once the eye has moved _threshold
+  /// (or trees were added / removed), ignored while the GPU culling / impostors are on
+  //----------------------------------------------------------------------------------------------------------------------
+  void setSorting(bool _enable, float _threshold = 1.0f);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief write the memory accounting (see MemoryRegistry) as JSON to a file on exit
+  //----------------------------------------------------------------------------------------------------------------------
+  void setMemoryReport(const std::string &_fileName) { m_memoryReport = _fileName; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief stream the forest from tiles in _dir rather than keeping it all resident, the tiles are
+  /// baked from the generated forest the first time, must be called before the window is shown
+  /// @param[in] _dir the tile directory
+  /// @param[in] _radius tiles closer than this to the eye are loaded
+  /// @param[in] _tileSize the tile width used when baking
+  /// @param[in] _budgetMB the most tree transforms to keep on the GPU
+  //----------------------------------------------------------------------------------------------------------------------
+  void setStreaming(const std::string &_dir, float _radius, float _tileSize, float _budgetMB);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draw progress frames while starting up (the default) or finish it all in initializeGL
+  //----------------------------------------------------------------------------------------------------------------------
+  void setProgressiveStartup(bool _enable) { m_progressiveStartup = _enable; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief write the start up stages to a file in the Chrome trace format once they are done
+  //----------------------------------------------------------------------------------------------------------------------
+  void setStartupTrace(const std::string &_fileName) { m_startupTrace = _fileName; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief compare the shader CounterRandom with the CPU one as a start up stage
+  //----------------------------------------------------------------------------------------------------------------------
+  void setCheckRandom(bool _enable) { m_checkRandom = _enable; }
 
 private:
   //----------------------------------------------------------------------------------------------------------------------
@@ -77,22 +171,22 @@ private:
   //----------------------------------------------------------------------------------------------------------------------
   std::unique_ptr<ngl::Text> m_text;
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief flag for the fps timer
+  /// @brief decides when we re-draw, replaces the old startTimer(0) loop
   //----------------------------------------------------------------------------------------------------------------------
-  int m_fpsTimer;
+  std::unique_ptr<RenderScheduler> m_scheduler;
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief the fps to draw
+  /// @brief per frame timing, replaces the old once a second fps counter
   //----------------------------------------------------------------------------------------------------------------------
-  int m_fps;
+  FrameStats m_frameStats;
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief number of frames for the fps counter
+  /// @brief rolling frame time graph drawn in the overlay
   //----------------------------------------------------------------------------------------------------------------------
-  int m_frames;
+  std::unique_ptr<FrameGraph> m_frameGraph;
+  GLuint m_textureID;
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief timer for re-draw
+  /// @brief the decoded texture waiting to be uploaded, only held during the start up
   //----------------------------------------------------------------------------------------------------------------------
-  QElapsedTimer m_timer;
-  GLuint m_textureID;
+  std::unique_ptr<ngl::Texture> m_textureImage;
 
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief the mesh with all the data in it
@@ -101,13 +195,157 @@ private:
   /// @brief the id for the texture buffer object
   GLuint m_tboID;
   //----------------------------------------------------------------------------------------------------------------------
-  /// do our morphing for the 3 meshes
+  /// @brief the tree transforms, only the changed ones are uploaded each frame, the handles are
+  /// kept so we can pick random trees to change or remove
+  //----------------------------------------------------------------------------------------------------------------------
+  InstancePool m_trees;
+  std::vector<InstancePool::Handle> m_handles;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the buffer generation the TBO is attached to
+  //----------------------------------------------------------------------------------------------------------------------
+  uint32_t m_tboGeneration = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the per tree values PerFragADS reads (see precomputeTrees), the VAO is empty as the
+  /// precompute only uses gl_VertexID
+  //----------------------------------------------------------------------------------------------------------------------
+  InstanceBuffer m_precomputed;
+  GLuint m_precomputedTBO = 0;
+  uint32_t m_precomputedGeneration = 0;
+  GLuint m_precomputeVAO = 0;
+  size_t m_numTrees = 5000;
+  size_t m_changesPerFrame = 0;
+  size_t m_churnPerFrame = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the number of churnTrees calls, the CounterRandom index for the next one
+  //----------------------------------------------------------------------------------------------------------------------
+  uint32_t m_churnUpdates = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief CPU time of the last update (churn + changes + upload)
+  //----------------------------------------------------------------------------------------------------------------------
+  float m_updateMs = 0.0f;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief input record / replay
+  //----------------------------------------------------------------------------------------------------------------------
+  InputRecorder m_input;
+  bool m_quitAfterReplay = false;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief GPU culling, last frame's visible trees are drawn into the pyramid as occluders
+  //----------------------------------------------------------------------------------------------------------------------
+  bool m_culling = false;
+  bool m_cullingSupported = false;
+  DepthPyramid m_pyramid;
+  HiZCuller m_culler;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the local bounds of the tree mesh for the culling
+  //----------------------------------------------------------------------------------------------------------------------
+  ngl::Vec3 m_boundsMin;
+  ngl::Vec3 m_boundsMax;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the far trees are drawn as quads textured from the atlas, see ImpostorAtlas
+  //----------------------------------------------------------------------------------------------------------------------
+  bool m_impostors = false;
+  float m_impostorDistance = 350.0f;
+  float m_impostorFade = 50.0f;
+  ImpostorAtlas m_atlas;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief front to back sorting, the sorted ids are drawn through the visibleIDs TBO
+  //----------------------------------------------------------------------------------------------------------------------
+  bool m_sorting = false;
+  bool m_sortDirty = true;
+  float m_sortThreshold = 1.0f;
+  ngl::Vec3 m_sortEye;
+  RadixSort m_sorter;
+  std::vector<uint32_t> m_sortKeys;
+  std::vector<uint32_t> m_sortedIDs;
+  InstanceBuffer m_sortedBuffer{GL_DYNAMIC_STORAGE_BIT, GL_DYNAMIC_DRAW, MemoryRegistry::Category::Culling};
+  GLuint m_sortedTBO = 0;
+  uint32_t m_sortedGeneration = 0;
+  float m_sortMs = 0.0f;
+  size_t m_sorts = 0;
+  size_t m_sortSkips = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief tile streaming, when active m_trees only holds the resident tiles and there is no
+  /// churn or re-scaling
+  //----------------------------------------------------------------------------------------------------------------------
+  TileStreamer m_streamer;
+  std::string m_streamDir;
+  float m_streamRadius = 300.0f;
+  float m_streamTileSize = 64.0f;
+  int64_t m_streamBudget = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief samples that passed the depth test drawing the trees, a measure of the overdraw
+  //----------------------------------------------------------------------------------------------------------------------
+  std::unique_ptr<GpuTimer> m_samplesPassed;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief where to write the memory JSON on exit, empty for none
+  //----------------------------------------------------------------------------------------------------------------------
+  std::string m_memoryReport;
+  bool m_progressiveStartup = true;
+  bool m_checkRandom = false;
+  std::string m_startupTrace;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the start up stages, the CPU ones use the members above from worker threads until done
+  //----------------------------------------------------------------------------------------------------------------------
+  StartupGraph m_startup;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief run some of the start up and draw a progress frame
+  /// @returns false once the start up is done and the scene can be drawn
+  //----------------------------------------------------------------------------------------------------------------------
+  bool startupFrame();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief report the start up once the last stage is done
+  //----------------------------------------------------------------------------------------------------------------------
+  void finishStartup();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief record or apply the replayed input state, called at the start of each frame
+  //----------------------------------------------------------------------------------------------------------------------
+  void syncInput();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief upload the trees and attach the TBO
   //----------------------------------------------------------------------------------------------------------------------
   void createTransformTBO();
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief method to load transform matrices to the shader
+  /// @brief place the trees or bake / start the tile streaming, CPU only so it can run on a worker thread
+  //----------------------------------------------------------------------------------------------------------------------
+  void prepareTrees();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief Poisson-disk place m_numTrees trees into m_trees
+  //----------------------------------------------------------------------------------------------------------------------
+  void placeTrees();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the eye in the space of the tree matrices
+  //----------------------------------------------------------------------------------------------------------------------
+  ngl::Vec3 treeSpaceEye() const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief remove / add m_churnPerFrame trees, re-scale m_changesPerFrame random trees and upload the changes
+  //----------------------------------------------------------------------------------------------------------------------
+  void updateTransforms();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the churn and re-scaling part of updateTransforms, not used while streaming
+  //----------------------------------------------------------------------------------------------------------------------
+  void churnTrees();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a tree at a random position with a random scale
+  //----------------------------------------------------------------------------------------------------------------------
+  static ngl::Mat4 randomTree(CounterRandom &io_random);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a random live tree handle index
+  //----------------------------------------------------------------------------------------------------------------------
+  size_t randomTreeIndex(CounterRandom &io_random) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief run TreePrecompute.glsl over every tree to write the per tree ModelViewProjection, UV
+  /// rotation and impostor fade for this frame's camera, the result is bound for PerFragADS
+  //----------------------------------------------------------------------------------------------------------------------
+  void precomputeTrees();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief build the pyramid from last frame's visible trees then cull and split the near / far
+  /// trees, the mesh VAO must be bound
+  //----------------------------------------------------------------------------------------------------------------------
+  void cullTrees();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief sort the trees by distance from the eye and upload the order if the eye has moved enough
   //----------------------------------------------------------------------------------------------------------------------
-  void loadMatricesToShader();
+  void sortTrees();
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief Qt Event called when a key is pressed
   /// @param [in] _event the Qt event to query for size etc
@@ -138,7 +376,6 @@ private:
   //----------------------------------------------------------------------------------------------------------------------
   void wheelEvent(QWheelEvent *_event) override;
 
-  void timerEvent(QTimerEvent *_event) override;
 private slots:
 };
 
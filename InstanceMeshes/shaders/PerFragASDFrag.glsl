@@ -1,12 +1,23 @@
-#version 410 core
-layout (location =0)out vec4 fragColour;
-in vec4 colour;
-in vec2 vertUV;
-uniform sampler2D tex;
-
-void main ()
-{
-  fragColour=texture(tex, vertUV.st);
-}
-
-
+#version 410 core
+layout (location =0)out vec4 fragColour;
+in vec4 colour;
+in vec2 vertUV;
+flat in float fade;
+uniform sampler2D tex;
+
+// screen door pattern for the impostor cross fade, the impostor keeps the pixels we drop
+float dither()
+{
+  return fract(52.9829189*fract(dot(gl_FragCoord.xy,vec2(0.06711056,0.00583715))));
+}
+
+void main ()
+{
+  if(dither()<fade)
+  {
+    discard;
+  }
+  fragColour=texture(tex, vertUV.st);
+}
+
+
@@ -1,34 +1,29 @@
-#version 410 core
-layout (location =0) in vec3 inVert;
-layout (location = 1) in vec3 inNormal;
-layout (location = 2) in vec2 inUV;
-
-uniform samplerBuffer TBO;
-uniform mat4 mouseTX;
-uniform mat4 VP;
-out vec2 vertUV;
-
-void main()
-{
-  // create a simple rotation matrix for the UV's
-  mat2 rot=mat2(cos(gl_InstanceID),-sin(gl_InstanceID),
-                sin(gl_InstanceID),cos(gl_InstanceID));
-  // modify the UV's so the meshes look different
-  vertUV=rot*inUV;
-  // build our tx matrix from the TBO
-  mat4 tx=mat4(texelFetch(TBO,gl_InstanceID*4+0),
-               texelFetch(TBO,gl_InstanceID*4+1),
-               texelFetch(TBO,gl_InstanceID*4+2),
-               texelFetch(TBO,gl_InstanceID*4+3));
-  // produce the final vertex
-  gl_Position=VP*mouseTX*tx*vec4(inVert,1.0);
-}
-
-
-
-
-
-
-
-
-
+#version 410 core
+layout (location =0) in vec3 inVert;
+layout (location = 1) in vec3 inNormal;
+layout (location = 2) in vec2 inUV;
+
+// the per tree values written by TreePrecompute.glsl, 5 texels per tree
+uniform samplerBuffer precomputed;
+// when culling the instances drawn are the compacted visible list
+uniform usamplerBuffer visibleIDs;
+uniform int useVisibleIDs;
+out vec2 vertUV;
+flat out float fade;
+
+void main()
+{
+  int id = useVisibleIDs != 0 ? int(texelFetch(visibleIDs,gl_InstanceID).r) : gl_InstanceID;
+  // the ModelViewProjection and UV rotation are worked out once per tree rather than per vertex
+  mat4 MVP=mat4(texelFetch(precomputed,id*5+0),
+                texelFetch(precomputed,id*5+1),
+                texelFetch(precomputed,id*5+2),
+                texelFetch(precomputed,id*5+3));
+  vec4 uvFade=texelFetch(precomputed,id*5+4);
+  // modify the UV's so the meshes look different
+  vertUV=mat2(uvFade.x,-uvFade.y,
+              uvFade.y,uvFade.x)*inUV;
+  fade=uvFade.z;
+  // produce the final vertex
+  gl_Position=MVP*vec4(inVert,1.0);
+}
@@ -0,0 +1,29 @@
+#version 410 core
+// run once per tree each frame with transform feedback (no rasterization), writes everything
+// PerFragASDVert.glsl needs that is the same for every vertex of a tree so the vertex shader
+// only does the one matrix multiply
+
+uniform samplerBuffer TBO;
+uniform mat4 mouseTX;
+uniform mat4 VP;
+uniform mat4 View;
+// distance band the far trees are cross faded to impostors over, y <= 0 for no impostors
+uniform vec2 lodRange;
+// recorded interleaved, 5 vec4's per tree
+out mat4 MVP;
+// the UV rotation (cos, sin), the impostor fade and a spare
+out vec4 uvFade;
+
+void main()
+{
+  int id = gl_VertexID;
+  mat4 tx=mat4(texelFetch(TBO,id*4+0),
+               texelFetch(TBO,id*4+1),
+               texelFetch(TBO,id*4+2),
+               texelFetch(TBO,id*4+3));
+  mat4 model=mouseTX*tx;
+  MVP=VP*model;
+  float fade = lodRange.y > 0.0 ? clamp((length((View*model[3]).xyz)-lodRange.x)/max(lodRange.y-lodRange.x,1e-4),0.0,1.0) : 0.0;
+  // rotate the UV's by the tree id so the meshes look different
+  uvFade=vec4(cos(float(id)),sin(float(id)),fade,0.0);
+}
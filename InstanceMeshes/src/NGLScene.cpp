@@ -2,57 +2,310 @@
 #include <QGuiApplication>
 
 #include "NGLScene.h"
+#include "ProgramCache.h"
+#include "PoissonDisk.h"
+#include "CounterRandom.h"
 #include <ngl/Transformation.h>
 #include <ngl/NGLInit.h>
 #include <ngl/VAOPrimitives.h>
 #include <ngl/ShaderLib.h>
-#include <ngl/Random.h>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
-constexpr size_t c_numTrees = 5000;
+#include <limits>
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief fixed seed so every run (and every replay) sees the same forest
+//----------------------------------------------------------------------------------------------------------------------
+constexpr unsigned int c_seed = 1234;
+constexpr auto c_precomputeProgram = "TreePrecompute";
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the CounterRandom stream for the churn, indexed by the update so each one is repeatable
+//----------------------------------------------------------------------------------------------------------------------
+constexpr uint32_t c_churnStream = 16;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief resolution of the forest density map the trees are placed with
+//----------------------------------------------------------------------------------------------------------------------
+constexpr size_t c_densitySize = 256;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the precomputed values are a mat4 and a vec4 per tree, read on this texture unit
+//----------------------------------------------------------------------------------------------------------------------
+constexpr GLsizeiptr c_precomputedBytes = 5 * 4 * sizeof(float);
+constexpr GLint c_precomputedUnit = 7;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief ms of GL start up work per progress frame
+//----------------------------------------------------------------------------------------------------------------------
+constexpr float c_startupBudgetMs = 8.0f;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief indices compared by --check-random
+//----------------------------------------------------------------------------------------------------------------------
+constexpr size_t c_randomCheckCount = 1 << 16;
 
 NGLScene::NGLScene()
 {
 
   setTitle("Instancing Meshes");
-  m_fpsTimer = startTimer(0);
-  m_fps = 0;
-  m_frames = 0;
-  m_timer.start();
+  m_scheduler = std::make_unique<RenderScheduler>(this, &m_frameStats);
+}
+
+ngl::Mat4 NGLScene::randomTree(CounterRandom &io_random)
+{
+  auto x = CounterRandom::signedUnit(io_random.next()) * 540;
+  auto z = CounterRandom::signedUnit(io_random.next()) * 540;
+  auto yScale = io_random.uniform() * 2.0f + 0.5f;
+  auto pos = ngl::Mat4::translate(x, 0.0, z);
+  auto scale = ngl::Mat4::scale(yScale, yScale, yScale);
+  return pos * scale;
+}
+
+size_t NGLScene::randomTreeIndex(CounterRandom &io_random) const
+{
+  return io_random.below(static_cast<uint32_t>(m_handles.size()));
+}
+
+void NGLScene::placeTrees()
+{
+  // the tree pool holds the position and scale as a mat4 for each tree
+  m_trees.clear();
+  m_trees.reserve(m_numTrees);
+  m_handles.clear();
+  m_handles.reserve(m_numTrees);
+  // Poisson-disk placement over a density map with clearings, the matrices are written straight
+  // into the pool rather than added one tree at a time (randomTree is still used for re-planting)
+  PoissonDisk::Settings placement;
+  placement.count = m_numTrees;
+  placement.seed = c_seed;
+  placement.density = PoissonDisk::clearings(c_densitySize, c_seed);
+  placement.densityWidth = placement.densityHeight = c_densitySize;
+  m_handles.resize(m_numTrees);
+  auto *matrices = m_trees.append(m_numTrees, m_handles.data());
+  auto stats = PoissonDisk::generate(placement, &matrices[0].m_m[0][0]);
+  // only short if the density map is nearly empty, drop the unused ones from the end
+  while (m_handles.size() > stats.placed)
+  {
+    m_trees.remove(m_handles.back());
+    m_handles.pop_back();
+  }
+  std::cout << "Placed " << stats.placed << " trees " << stats.radius << " apart in " << stats.tiles << " tiles on "
+            << WorkerPool::shared().size() << " threads, " << stats.sampleMs + stats.writeMs << " ms\n";
+}
+
+void NGLScene::prepareTrees()
+{
+  // when streaming the forest is only generated to bake the tiles the first time, after that the
+  // pool only holds the tiles the streamer has made resident
+  TileStreamer::Generation generation;
+  generation.count = m_numTrees;
+  generation.seed = c_seed;
+  generation.tileSize = m_streamTileSize;
+  auto bake = [&]()
+  {
+    placeTrees();
+    bool baked = TileStreamer::bake(m_streamDir, m_trees.store().data(), m_trees.size(), generation);
+    std::cout << (baked ? "Baked " : "Unable to bake ") << m_trees.size() << " trees into tiles in " << m_streamDir << "\n";
+    return baked;
+  };
+  bool streaming = !m_streamDir.empty() && (TileStreamer::baked(m_streamDir, generation) || bake()) && m_streamer.start(m_streamDir, m_streamRadius, m_streamBudget);
+  if (streaming)
+  {
+    m_trees.clear();
+    m_handles.clear();
+  }
+  else
+  {
+    placeTrees();
+  }
 }
 
 void NGLScene::createTransformTBO()
 {
-  // create a texture buffer to store the position and scale as a mat4 for each tree
-  GLuint tbo;
-  glGenBuffers(1, &tbo);
-  // resize vector
-  std::vector<ngl::Mat4> transforms(c_numTrees);
-  ngl::Vec3 tx;
-  ngl::Mat4 pos;
-  ngl::Mat4 scale;
-  // set random position and scale for each matrix
-  for (auto &t : transforms)
-  {
-    tx = ngl::Random::getRandomVec3() * 540;
-    auto yScale = ngl::Random::randomPositiveNumber(2.0f) + 0.5f;
-    pos = ngl::Mat4::translate(tx.m_x, 0.0, tx.m_z);
-    scale = ngl::Mat4::scale(yScale, yScale, yScale);
-    t = pos * scale;
-  }
-  // bind and fill TBO
-  glBindBuffer(GL_TEXTURE_BUFFER, tbo);
-  glBufferData(GL_TEXTURE_BUFFER, transforms.size() * sizeof(ngl::Mat4), &transforms[0].m_00, GL_STATIC_DRAW);
+  m_trees.store().upload();
   // attatch to texture ( Texture unit 0 in this case as using not others)
   glGenTextures(1, &m_tboID);
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_BUFFER, m_tboID);
   // Note GL_RGBA32F as using Mat4 -> 4* vec4 in size
-  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, tbo);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_trees.store().id());
+  m_tboGeneration = m_trees.store().generation();
+}
+
+void NGLScene::churnTrees()
+{
+  // churn, remove random trees then plant new ones, each removal only dirties the slot
+  // the last tree is moved into
+  CounterRandom random(c_seed, c_churnStream, m_churnUpdates++);
+  for (size_t i = 0; i < m_churnPerFrame && !m_handles.empty(); ++i)
+  {
+    auto index = randomTreeIndex(random);
+    m_trees.remove(m_handles[index]);
+    m_handles[index] = m_handles.back();
+    m_handles.pop_back();
+  }
+  // removals move trees about so the order has to be rebuilt
+  m_sortDirty = m_sortDirty || m_churnPerFrame > 0;
+  while (m_handles.size() < m_numTrees)
+  {
+    m_handles.push_back(m_trees.add(randomTree(random)));
+  }
+  // re-scale some random trees in place, the position is kept
+  for (size_t i = 0; i < m_changesPerFrame && !m_handles.empty(); ++i)
+  {
+    auto handle = m_handles[randomTreeIndex(random)];
+    const auto &current = m_trees.get(handle);
+    auto yScale = random.uniform() * 2.0f + 0.5f;
+    m_trees.set(handle, ngl::Mat4::translate(current.m_m[3][0], current.m_m[3][1], current.m_m[3][2]) * ngl::Mat4::scale(yScale, yScale, yScale));
+  }
+}
+
+ngl::Vec3 NGLScene::treeSpaceEye() const
+{
+  auto inverse = (m_view * m_mouseGlobalTX).inverse();
+  return ngl::Vec3(inverse.m_m[3][0], inverse.m_m[3][1], inverse.m_m[3][2]);
+}
+
+void NGLScene::setStreaming(const std::string &_dir, float _radius, float _tileSize, float _budgetMB)
+{
+  m_streamDir = _dir;
+  m_streamRadius = _radius;
+  m_streamTileSize = _tileSize;
+  m_streamBudget = static_cast<int64_t>(_budgetMB * 1048576.0f);
+}
+
+void NGLScene::updateTransforms()
+{
+  auto start = std::chrono::steady_clock::now();
+  if (m_streamer.active())
+  {
+    // tiles coming and going move trees about just like the churn
+    m_sortDirty = m_streamer.update(treeSpaceEye(), m_trees) || m_sortDirty;
+  }
+  else
+  {
+    churnTrees();
+  }
+  m_trees.store().upload();
+  m_updateMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_BUFFER, m_tboID);
+  // only re-attach if the store was re-allocated
+  if (m_trees.store().generation() != m_tboGeneration)
+  {
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_trees.store().id());
+    m_tboGeneration = m_trees.store().generation();
+  }
+}
+
+void NGLScene::setChangesPerFrame(size_t _count)
+{
+  m_changesPerFrame = _count;
+  // keep drawing in on demand mode while the trees are changing
+  m_scheduler->setAnimating(m_changesPerFrame > 0 || m_churnPerFrame > 0);
+}
+
+void NGLScene::setChurnPerFrame(size_t _count)
+{
+  m_churnPerFrame = _count;
+  m_scheduler->setAnimating(m_changesPerFrame > 0 || m_churnPerFrame > 0);
+}
+
+void NGLScene::setImpostors(bool _enable, float _distance, float _fade)
+{
+  m_impostors = _enable;
+  m_impostorDistance = _distance;
+  m_impostorFade = std::max(_fade, 0.0f);
+}
+
+void NGLScene::setSorting(bool _enable, float _threshold)
+{
+  m_sorting = _enable;
+  m_sortThreshold = _threshold;
+  m_sortDirty = true;
+}
+
+void NGLScene::recordInput(const std::string &_fileName)
+{
+  m_input.startRecording(_fileName);
+}
+
+bool NGLScene::replayInput(const std::string &_fileName, bool _quitWhenDone)
+{
+  if (!m_input.startReplay(_fileName))
+  {
+    return false;
+  }
+  m_quitAfterReplay = _quitWhenDone;
+  // keep drawing every frame so the events land on the recorded frames
+  m_scheduler->setAnimating(true);
+  return true;
+}
+
+void NGLScene::syncInput()
+{
+  m_input.beginFrame();
+  if (m_input.replaying())
+  {
+    InputRecorder::Values v;
+    if (m_input.value("camera", v))
+    {
+      m_win.spinXFace = static_cast<int>(v[0]);
+      m_win.spinYFace = static_cast<int>(v[1]);
+    }
+    if (m_input.value("position", v))
+    {
+      m_modelPos.set(v[0], v[1], v[2]);
+    }
+    if (m_input.value("trees", v))
+    {
+      m_changesPerFrame = static_cast<size_t>(v[0]);
+      m_churnPerFrame = static_cast<size_t>(v[1]);
+    }
+    if (m_input.finished() && m_quitAfterReplay)
+    {
+      QGuiApplication::exit(EXIT_SUCCESS);
+    }
+  }
+  else if (m_input.recording())
+  {
+    m_input.record("camera", {static_cast<float>(m_win.spinXFace), static_cast<float>(m_win.spinYFace)});
+    m_input.record("position", {m_modelPos.m_x, m_modelPos.m_y, m_modelPos.m_z});
+    m_input.record("trees", {static_cast<float>(m_changesPerFrame), static_cast<float>(m_churnPerFrame)});
+  }
 }
 
 NGLScene::~NGLScene()
 {
+  // a window closed while loading has to wait for the worker stages before anything is torn down
+  m_startup.cancel();
   std::cout << "Shutting down NGL, removing VAO's and Shaders\n";
+  // dump the full frame time distribution so we can look at the tail
+  m_frameStats.printSummary(std::cout);
+  m_frameStats.writeHistogram("frametimes.csv");
+  m_scheduler->printSummary(std::cout);
+  m_trees.store().printSummary(std::cout);
+  if (m_streamer.active())
+  {
+    m_streamer.printSummary(std::cout);
+  }
+  auto &memory = MemoryRegistry::shared();
+  memory.printSummary(std::cout);
+  if (!m_memoryReport.empty())
+  {
+    auto driver = MemoryRegistry::driverMemory();
+    if (!memory.writeJson(m_memoryReport, &driver))
+    {
+      std::cerr << "Unable to write memory report " << m_memoryReport << "\n";
+    }
+  }
+  memory.release(this);
+}
+
+void NGLScene::setFrameBudget(float _ms)
+{
+  m_frameStats.setBudget(_ms);
+}
+
+void NGLScene::setRenderMode(RenderScheduler::Mode _mode)
+{
+  m_scheduler->setMode(_mode);
 }
 
 void NGLScene::resizeGL(int _w, int _h)
@@ -80,58 +333,273 @@ void NGLScene::initializeGL()
   ngl::Vec3 to(0, 0, 0);
   ngl::Vec3 up(0, 1, 0);
 
-  // first we create a mesh from an obj passing in the obj file and texture
-  m_mesh = std::make_unique<ngl::Obj>("models/tree.obj");
-  m_mesh->createVAO();
-
   m_view = ngl::lookAt(from, to, up);
   // set the shape using FOV 45 Aspect Ratio based on Width and Height
   // The final two are near and far clipping planes of 0.5 and 10
   m_project = ngl::perspective(45.0f, 720.0f / 576.0f, 0.05f, 1350.0f);
-  // we are creating a shader called PerFragADS
-  ngl::ShaderLib::createShaderProgram("PerFragADS");
-  // now we are going to create empty shaders for Frag and Vert
-  ngl::ShaderLib::attachShader("PerFragADSVertex", ngl::ShaderType::VERTEX);
-  ngl::ShaderLib::attachShader("PerFragADSFragment", ngl::ShaderType::FRAGMENT);
-  // attach the source
-  ngl::ShaderLib::loadShaderSource("PerFragADSVertex", "shaders/PerFragASDVert.glsl");
-  ngl::ShaderLib::loadShaderSource("PerFragADSFragment", "shaders/PerFragASDFrag.glsl");
-  // compile the shaders
-  ngl::ShaderLib::compileShader("PerFragADSVertex");
-  ngl::ShaderLib::compileShader("PerFragADSFragment");
-  // add them to the program
-  ngl::ShaderLib::attachShaderToProgram("PerFragADS", "PerFragADSVertex");
-  ngl::ShaderLib::attachShaderToProgram("PerFragADS", "PerFragADSFragment");
-
-  // now we have associated this data we can link the shader
-  ngl::ShaderLib::linkProgramObject("PerFragADS");
-  // and make it active ready to load values
-  ngl::ShaderLib::use("PerFragADS");
-
   glEnable(GL_DEPTH_TEST); // for removal of hidden surfaces
 
-  createTransformTBO();
-  // load a texture into texture Unit 1
-  ngl::Texture t("models/ratGrid.png");
-  t.setMultiTexture(1);
-  m_textureID = t.setTextureGL();
-  ngl::ShaderLib::setUniform("tex", 1);
-  ngl::ShaderLib::setUniform("TBO", 0);
+  // the rest runs as a graph, the text comes first so the progress frames can show it then the
+  // obj, texture and forest are loaded on worker threads while the programs compile
+  using Kind = StartupGraph::Kind;
+  m_startup.add("text", Kind::Gl, {},
+                [this]()
+                {
+                  m_samplesPassed = std::make_unique<GpuTimer>(GL_SAMPLES_PASSED);
+                  m_text = std::make_unique<ngl::Text>("fonts/Arial.ttf", 16);
+                  MemoryRegistry::shared().set(MemoryRegistry::Category::Text, this, MemoryRegistry::textBytes(16));
+                  m_text->setScreenSize(width(), height());
+                  m_frameGraph = std::make_unique<FrameGraph>(10, 10, 300, 80);
+                });
+  // first we create a mesh from an obj passing in the obj file and texture
+  auto parse = m_startup.add("parse obj", Kind::Cpu, {}, [this]() { m_mesh = std::make_unique<ngl::Obj>("models/tree.obj"); });
+  auto decode = m_startup.add("decode texture", Kind::Cpu, {}, [this]() { m_textureImage = std::make_unique<ngl::Texture>("models/ratGrid.png"); });
+  auto place = m_startup.add("place trees", Kind::Cpu, {}, [this]() { prepareTrees(); });
+  auto programs = m_startup.add("programs", Kind::Gl, {},
+                                [this]()
+                                {
+                                  // we are creating a shader called PerFragADS, the ProgramCache loads the binary from the last
+                                  // run if nothing has changed otherwise it compiles and links the sources, either way the
+                                  // program is left active ready to load values
+                                  ProgramCache::shared().build({"PerFragADS",
+                                                                {{ngl::ShaderType::VERTEX, ProgramCache::readSource("shaders/PerFragASDVert.glsl")},
+                                                                 {ngl::ShaderType::FRAGMENT, ProgramCache::readSource("shaders/PerFragASDFrag.glsl")}},
+                                                                {},
+                                                                {}});
+
+                                  // the per tree work PerFragADS used to repeat for every vertex, one point per tree with the
+                                  // outputs interleaved into m_precomputed
+                                  ProgramCache::shared().build({c_precomputeProgram,
+                                                                {{ngl::ShaderType::VERTEX, ProgramCache::readSource("shaders/TreePrecompute.glsl")}},
+                                                                {"MVP", "uvFade"},
+                                                                {}});
+                                  ngl::ShaderLib::setUniform("TBO", 0);
+                                  glGenVertexArrays(1, &m_precomputeVAO);
+                                  glGenTextures(1, &m_precomputedTBO);
+                                  ngl::ShaderLib::use("PerFragADS");
+                                  ngl::ShaderLib::setUniform("tex", 1);
+                                  ngl::ShaderLib::setUniform("precomputed", c_precomputedUnit);
+                                  ngl::ShaderLib::setUniform("visibleIDs", 3);
+                                  ngl::ShaderLib::setUniform("useVisibleIDs", 0);
+                                });
+  auto mesh = m_startup.add("mesh upload", Kind::Gl, {parse},
+                            [this]()
+                            {
+                              m_mesh->createVAO();
+                              // ngl::Obj packs uv, normal and position (8 floats) per vertex
+                              MemoryRegistry::shared().set(MemoryRegistry::Category::Meshes, this,
+                                                           static_cast<int64_t>(m_mesh->getMeshSize() * 8 * sizeof(float)));
+                              // an analytic estimate counted from the shader source, not a measurement. A mat4 x mat4 is 64
+                              // multiply-adds and a mat4 x vec4 16. The old vertex shader built VP*mouseTX*tx (two mat4
+                              // products), View*model for the fade (another) and did 3 mat4 x vec4 plus the UV rotation trig,
+                              // TreePrecompute.glsl now does all of that once per tree and the vertex shader one mat4 x vec4
+                              constexpr size_t c_mat4Mat4 = 64;
+                              constexpr size_t c_mat4Vec4 = 16;
+                              constexpr size_t c_oldMads = 3 * c_mat4Mat4 + 3 * c_mat4Vec4;
+                              constexpr size_t c_mads = c_mat4Vec4;
+                              std::cout << "Tree vertex transform " << c_mads << " multiply-adds per vertex (was " << c_oldMads
+                                        << " + 2 trig, estimated from the shaders), " << (c_oldMads - c_mads) * m_mesh->getMeshSize()
+                                        << " fewer per tree\n";
+                            });
+  auto trees = m_startup.add("tree upload", Kind::Gl, {place}, [this]() { createTransformTBO(); });
+  auto texture = m_startup.add("texture upload", Kind::Gl, {decode},
+                               [this]()
+                               {
+                                 // load a texture into texture Unit 1
+                                 m_textureImage->setMultiTexture(1);
+                                 m_textureID = m_textureImage->setTextureGL();
+                                 MemoryRegistry::shared().set(MemoryRegistry::Category::Textures, this,
+                                                              MemoryRegistry::textureBytes(static_cast<GLsizei>(m_textureImage->getWidth()),
+                                                                                           static_cast<GLsizei>(m_textureImage->getHeight()), 4, 0));
+                                 m_textureImage.reset();
+                               });
+  m_startup.add("culling", Kind::Gl, {programs, mesh, trees, texture},
+                [this]()
+                {
+                  m_cullingSupported = HiZCuller::supported();
+                  if (m_cullingSupported)
+                  {
+                    m_pyramid.initialize();
+                    // when streaming the budget caps the resident trees rather than the count
+                    size_t maxTrees = m_streamer.active() ? static_cast<size_t>(m_streamBudget) / sizeof(ngl::Mat4) : m_numTrees;
+                    m_culler.initialize(static_cast<GLuint>(std::min<size_t>(maxTrees, std::numeric_limits<GLuint>::max())));
+                    auto bbox = m_mesh->getBBox();
+                    m_boundsMin.set(bbox.minX(), bbox.minY(), bbox.minZ());
+                    m_boundsMax.set(bbox.maxX(), bbox.maxY(), bbox.maxZ());
+                    m_atlas.initialize();
+                    m_atlas.bake([this]() { m_mesh->draw(); }, m_textureID, m_boundsMin, m_boundsMax);
+                  }
+                  else if (m_culling || m_impostors)
+                  {
+                    std::cerr << "GPU culling and impostors need OpenGL 4.3, drawing everything\n";
+                    m_culling = false;
+                    m_impostors = false;
+                  }
+                });
+  if (m_checkRandom)
+  {
+    m_startup.add("check random", Kind::Gl, {}, []() { CounterRandom::checkGpu(std::cout, c_randomCheckCount); });
+  }
+  if (m_progressiveStartup)
+  {
+    m_startup.pump(c_startupBudgetMs);
+  }
+  else
+  {
+    m_startup.finish();
+    finishStartup();
+  }
+}
 
-  m_text = std::make_unique<ngl::Text>("fonts/Arial.ttf", 16);
-  m_text->setScreenSize(width(), height());
+bool NGLScene::startupFrame()
+{
+  if (m_startup.pump(c_startupBudgetMs))
+  {
+    finishStartup();
+    return false;
+  }
+  m_startup.markFirstFrame();
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  glViewport(0, 0, m_win.width, m_win.height);
+  if (m_text)
+  {
+    m_text->setColour(1, 1, 0);
+    m_text->renderText(10, 700, fmt::format("starting {}/{} stages {:.0f}ms {}", m_startup.finishedStages(), m_startup.stages(),
+                                            m_startup.elapsedMs(), m_startup.running()));
+  }
+  // keep the frames coming whatever the render mode until it is done
+  m_scheduler->markDirty();
+  return true;
 }
 
-void NGLScene::loadMatricesToShader()
+void NGLScene::finishStartup()
 {
+  m_startup.printTrace(std::cout);
+  if (!m_startupTrace.empty() && !m_startup.writeTrace(m_startupTrace))
+  {
+    std::cerr << "Unable to write start up trace " << m_startupTrace << "\n";
+  }
+  // how long the programs took to build and what the binary cache saved
+  ProgramCache::shared().printSummary(std::cout);
+  // the mesh programs are left active for the first frame as they were before the graph
   ngl::ShaderLib::use("PerFragADS");
+  // the progress frames aren't part of the frame times
+  m_frameStats.resetTick();
+}
+
+void NGLScene::precomputeTrees()
+{
+  ngl::ShaderLib::use(c_precomputeProgram);
   // loading this to shader each frame as it is the mouse that changes
   ngl::ShaderLib::setUniform("mouseTX", m_mouseGlobalTX);
   ngl::ShaderLib::setUniform("VP", m_project * m_view);
+  ngl::ShaderLib::setUniform("View", m_view);
+  ngl::ShaderLib::setUniform("lodRange", m_impostorDistance, m_impostors ? m_impostorDistance + m_impostorFade : 0.0f);
+  auto count = static_cast<GLsizei>(m_trees.size());
+  if (count == 0)
+  {
+    // nothing resident yet while streaming
+    ngl::ShaderLib::use("PerFragADS");
+    return;
+  }
+  m_precomputed.resize(count * c_precomputedBytes);
+  // the tree TBO is still on unit 0 from updateTransforms
+  glEnable(GL_RASTERIZER_DISCARD);
+  glBindVertexArray(m_precomputeVAO);
+  glBindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_precomputed.id(), 0, m_precomputed.size());
+  glBeginTransformFeedback(GL_POINTS);
+  glDrawArrays(GL_POINTS, 0, count);
+  glEndTransformFeedback();
+  glDisable(GL_RASTERIZER_DISCARD);
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+  glBindVertexArray(0);
+  glActiveTexture(GL_TEXTURE0 + c_precomputedUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, m_precomputedTBO);
+  if (m_precomputed.generation() != m_precomputedGeneration)
+  {
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_precomputed.id());
+    m_precomputedGeneration = m_precomputed.generation();
+  }
+  ngl::ShaderLib::use("PerFragADS");
+}
+
+void NGLScene::cullTrees()
+{
+  bool occlusion = m_culling && m_culler.hasCulled();
+  if (occlusion)
+  {
+    // draw what was visible last frame with this frame's camera as the occluders, depth only
+    m_pyramid.bindOccluderTarget();
+    ngl::ShaderLib::use("PerFragADS");
+    ngl::ShaderLib::setUniform("useVisibleIDs", 1);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_BUFFER, m_culler.visibleTBO());
+    m_culler.draw();
+    m_pyramid.build();
+  }
+  m_culler.setLodRange(m_impostorDistance, m_impostors ? m_impostorDistance + m_impostorFade : 0.0f);
+  m_culler.setOrder(m_sorting ? m_sortedTBO : 0);
+  m_culler.cull(m_tboID, static_cast<GLuint>(m_trees.size()), static_cast<GLuint>(m_mesh->getMeshSize()), m_project, m_view * m_mouseGlobalTX,
+                m_boundsMin, m_boundsMax, occlusion ? &m_pyramid : nullptr);
+}
+
+void NGLScene::sortTrees()
+{
+  // the eye in the space of the tree matrices, the order only depends on where it is
+  auto eye = treeSpaceEye();
+  size_t count = m_trees.size();
+  if (!m_sortDirty && m_sortedIDs.size() == count && (eye - m_sortEye).length() < m_sortThreshold)
+  {
+    ++m_sortSkips;
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  m_sortKeys.resize(count);
+  m_sortedIDs.resize(count);
+  const ngl::Mat4 *trees = m_trees.store().data();
+  auto &pool = WorkerPool::shared();
+  size_t tasks = std::clamp<size_t>(count / RadixSort::c_minPerTask, 1, pool.size());
+  pool.run(tasks,
+           [&](size_t _task)
+           {
+             for (size_t i = count * _task / tasks; i < count * (_task + 1) / tasks; ++i)
+             {
+               float dx = trees[i].m_m[3][0] - eye.m_x;
+               float dy = trees[i].m_m[3][1] - eye.m_y;
+               float dz = trees[i].m_m[3][2] - eye.m_z;
+               m_sortKeys[i] = RadixSort::floatKey(dx * dx + dy * dy + dz * dz);
+               m_sortedIDs[i] = static_cast<uint32_t>(i);
+             }
+           });
+  m_sorter.sort(m_sortKeys, m_sortedIDs, pool);
+  m_sortedBuffer.resize(static_cast<GLsizeiptr>(count * sizeof(uint32_t)));
+  glBindBuffer(GL_ARRAY_BUFFER, m_sortedBuffer.id());
+  glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(count * sizeof(uint32_t)), m_sortedIDs.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  if (m_sortedTBO == 0)
+  {
+    glGenTextures(1, &m_sortedTBO);
+  }
+  if (m_sortedBuffer.generation() != m_sortedGeneration)
+  {
+    glBindTexture(GL_TEXTURE_BUFFER, m_sortedTBO);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, m_sortedBuffer.id());
+    m_sortedGeneration = m_sortedBuffer.generation();
+  }
+  m_sortEye = eye;
+  m_sortDirty = false;
+  ++m_sorts;
+  m_sortMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
 void NGLScene::paintGL()
 {
+  if (!m_startup.finished() && startupFrame())
+  {
+    return;
+  }
+  m_scheduler->beginFrame();
+  syncInput();
   // clear the screen and depth buffer
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   glViewport(0, 0, m_win.width, m_win.height);
@@ -144,22 +612,100 @@ void NGLScene::paintGL()
   m_mouseGlobalTX.m_m[3][0] = m_modelPos.m_x;
   m_mouseGlobalTX.m_m[3][1] = m_modelPos.m_y;
   m_mouseGlobalTX.m_m[3][2] = m_modelPos.m_z;
-  ++m_frames;
 
+  updateTransforms();
+  // the per tree matrices for the occluder and main passes
+  precomputeTrees();
   // draw the mesh
   m_mesh->bindVAO();
-  loadMatricesToShader();
+  // the impostors use the culling to split the near and far trees
+  bool gpuLists = m_culling || m_impostors;
+  if (m_sorting)
+  {
+    // front to back so the depth test rejects more of the hidden trees, with the GPU lists the
+    // cull tests the trees in this order so the visible list keeps it
+    sortTrees();
+  }
+  if (gpuLists)
+  {
+    cullTrees();
+  }
+  ngl::ShaderLib::use("PerFragADS");
 
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_BUFFER, m_tboID);
   glActiveTexture(GL_TEXTURE1);
   glBindTexture(GL_TEXTURE_2D, m_textureID);
 
-  glDrawArraysInstanced(GL_TRIANGLES, 0, m_mesh->getMeshSize(), c_numTrees);
+  m_samplesPassed->begin();
+  if (gpuLists)
+  {
+    // only the visible trees, the count comes from the cull so nothing is read back
+    ngl::ShaderLib::setUniform("useVisibleIDs", 1);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_BUFFER, m_culler.visibleTBO());
+    m_culler.draw();
+  }
+  else if (m_sorting)
+  {
+    ngl::ShaderLib::setUniform("useVisibleIDs", 1);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_BUFFER, m_sortedTBO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, m_mesh->getMeshSize(), static_cast<GLsizei>(m_sortedIDs.size()));
+  }
+  else
+  {
+    ngl::ShaderLib::setUniform("useVisibleIDs", 0);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, m_mesh->getMeshSize(), static_cast<GLsizei>(m_trees.size()));
+  }
   m_mesh->unbindVAO();
+  if (m_impostors)
+  {
+    m_atlas.use(m_culler.farTBO(), m_project, m_view * m_mouseGlobalTX, m_impostorDistance, m_impostorDistance + m_impostorFade);
+    m_culler.drawFar();
+    glBindVertexArray(0);
+  }
+  m_samplesPassed->end();
 
   m_text->setColour(1, 1, 0);
-  m_text->renderText(10, 700, fmt::format("{} instances {} fps", c_numTrees, m_fps));
+  auto stats = m_frameStats.summary();
+  m_text->renderText(10, 700, fmt::format("{} instances {:.0f} fps", m_trees.size(), stats.mean > 0.0f ? 1000.0f / stats.mean : 0.0f));
+  m_text->renderText(10, 680, fmt::format("frame ms p50 {:.2f} p95 {:.2f} p99 {:.2f} max {:.2f} stutters {} (> {:.1f}ms)",
+                                          stats.p50, stats.p95, stats.p99, stats.max, stats.stutters, m_frameStats.budget()));
+  auto pacing = m_scheduler->report();
+  m_text->renderText(10, 660, fmt::format("{} mode cpu {:.0f}% pacing {:.2f}ms +/- {:.2f}ms (R toggles on demand)",
+                                          RenderScheduler::modeName(m_scheduler->mode()), pacing.cpuPercent, pacing.intervalMs, pacing.jitterMs));
+  const auto &upload = m_trees.store().stats();
+  m_text->renderText(10, 640, fmt::format("{} trees changed {} churned per frame, update {:.2f}ms uploaded {} ranges {:.1f}KB{}", m_changesPerFrame,
+                                          m_churnPerFrame, m_updateMs, upload.lastRanges, upload.lastBytes / 1024.0f, upload.lastFull ? " (full)" : ""));
+  if (gpuLists)
+  {
+    const auto &cull = m_culler.stats();
+    // the impostor split runs the cull shader, without --culling it still frustum culls
+    m_text->renderText(10, 620, fmt::format("culling (C) {} meshes {} impostors (I) {} frustum culled {} occluded {} pyramid {:.2f}ms cull {:.2f}ms",
+                                            m_culling ? "frustum + occlusion" : "frustum (impostor pass)", cull.visible, cull.impostors, cull.frustumCulled, cull.occluded,
+                                            m_pyramid.gpuMs(), m_culler.gpuMs()));
+  }
+  m_text->renderText(10, 600, fmt::format("sorting (O) {} {:.2f}ms sorted {} skipped {} samples passed {:.2f}M", m_sorting ? "on" : "off", m_sortMs,
+                                          m_sorts, m_sortSkips,
+                                          m_samplesPassed->latestValue() / 1.0e6f));
+  auto gpu = MemoryRegistry::shared().usage(MemoryRegistry::Pool::GPU);
+  auto cpu = MemoryRegistry::shared().usage(MemoryRegistry::Pool::CPU);
+  auto driver = MemoryRegistry::driverMemory();
+  m_text->renderText(10, 560, fmt::format("memory GPU {:.1f}MB (peak {:.1f}) CPU {:.1f}MB (peak {:.1f}) driver free {}", gpu.current / 1048576.0,
+                                          gpu.peak / 1048576.0, cpu.current / 1048576.0, cpu.peak / 1048576.0,
+                                          driver.availableKB >= 0 ? fmt::format("{}MB", driver.availableKB / 1024) : std::string("n/a")));
+  if (m_streamer.active())
+  {
+    const auto &streaming = m_streamer.stats();
+    m_text->renderText(10, 540, fmt::format("streaming {}/{} tiles {:.1f}/{:.1f}MB queued {} loads {} evictions {} latency {:.1f}ms mean {:.1f}ms max {:.1f}ms",
+                                            streaming.resident, streaming.tiles, streaming.residentBytes / 1048576.0, m_streamer.budget() / 1048576.0,
+                                            streaming.queued, streaming.loads, streaming.evictions, streaming.lastLatencyMs,
+                                            streaming.loads > 0 ? streaming.totalLatencyMs / streaming.loads : 0.0, streaming.maxLatencyMs));
+  }
+  if (m_input.mode() != InputRecorder::Mode::Off)
+  {
+    m_text->renderText(10, 580, fmt::format("{} input frame {}", m_input.recording() ? "recording" : "replaying", m_input.frame()));
+  }
+  m_frameGraph->draw(m_frameStats, width(), height());
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -168,6 +714,11 @@ void NGLScene::keyPressEvent(QKeyEvent *_event)
 {
   // this method is called every time the main window recives a key event.
   // we then switch on the key value and set the camera in the GLWindow
+  // only quitting makes sense until the start up has made everything the keys change
+  if (!m_startup.finished() && _event->key() != Qt::Key_Escape)
+  {
+    return;
+  }
   switch (_event->key())
   {
   // escape key to quite
@@ -182,6 +733,23 @@ void NGLScene::keyPressEvent(QKeyEvent *_event)
   case Qt::Key_N:
     showNormal();
     break;
+  // toggle between on demand re-draws and the mode we started in (continuous or benchmark)
+  case Qt::Key_R:
+    m_scheduler->toggleOnDemand();
+    break;
+
+  // toggle the GPU culling
+  case Qt::Key_C:
+    m_culling = !m_culling && m_cullingSupported;
+    break;
+  // toggle the impostors for the far trees
+  case Qt::Key_I:
+    m_impostors = !m_impostors && m_cullingSupported;
+    break;
+  // toggle front to back sorting
+  case Qt::Key_O:
+    setSorting(!m_sorting, m_sortThreshold);
+    break;
 
   case Qt::Key_W:
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -194,20 +762,5 @@ void NGLScene::keyPressEvent(QKeyEvent *_event)
     break;
   }
   // finally update the GLWindow and re-draw
-  update();
-}
-
-void NGLScene::timerEvent(QTimerEvent *_event)
-{
-  if (_event->timerId() == m_fpsTimer)
-  {
-    if (m_timer.elapsed() > 1000.0)
-    {
-      m_fps = m_frames;
-      m_frames = 0;
-      m_timer.restart();
-    }
-  }
-  // re-draw GL
-  update();
+  m_scheduler->markDirty();
 }
@@ -20,7 +20,7 @@ void NGLScene::mouseMoveEvent(QMouseEvent *_event)
     m_win.spinYFace += static_cast<int>(0.5f * diffx);
     m_win.origX = position.x();
     m_win.origY = position.y();
-    update();
+    m_scheduler->markDirty();
   }
   // right mouse translate code
   else if (m_win.translate && _event->buttons() == Qt::RightButton)
@@ -31,7 +31,7 @@ void NGLScene::mouseMoveEvent(QMouseEvent *_event)
     m_win.origYPos = position.y();
     m_modelPos.m_x += INCREMENT * diffX;
     m_modelPos.m_y -= INCREMENT * diffY;
-    update();
+    m_scheduler->markDirty();
   }
 }
 
@@ -91,5 +91,5 @@ void NGLScene::wheelEvent(QWheelEvent *_event)
   {
     m_modelPos.m_z -= ZOOM;
   }
-  update();
+  m_scheduler->markDirty();
 }
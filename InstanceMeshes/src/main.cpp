@@ -2,14 +2,100 @@
 basic OpenGL demo modified from http://qt-project.org/doc/qt-5.0/qtgui/openglwindow.html
 ****************************************************************************/
 #include <QtGui/QGuiApplication>
+#include <QCommandLineParser>
 #include <iostream>
 #include "NGLScene.h"
+#include "ProgramCache.h"
+#include "BatchTransform.h"
+#include "PoissonDisk.h"
+#include "CounterRandom.h"
 
 
 
 int main(int argc, char **argv)
 {
   QGuiApplication app(argc, argv);
+  // command line options for benchmarking
+  QCommandLineParser parser;
+  parser.addHelpOption();
+  QCommandLineOption budgetOption("frame-budget", "frame time in ms above which a frame counts as a stutter", "ms", "16.67");
+  parser.addOption(budgetOption);
+  QCommandLineOption modeOption("render-mode", "continuous (vsync), ondemand (only on input) or benchmark (uncapped)", "mode", "continuous");
+  parser.addOption(modeOption);
+  QCommandLineOption treesOption("trees", "number of tree instances", "count", "5000");
+  parser.addOption(treesOption);
+  QCommandLineOption changesOption("changes", "number of trees re-scaled each frame", "count", "0");
+  parser.addOption(changesOption);
+  QCommandLineOption fullUploadOption("full-upload", "fraction of dirty trees above which all of the transforms are re-uploaded", "fraction", "0.25");
+  parser.addOption(fullUploadOption);
+  QCommandLineOption churnOption("churn", "number of trees removed and re-planted each frame", "count", "0");
+  parser.addOption(churnOption);
+  QCommandLineOption recordOption("record", "record the camera changes to a file", "file");
+  parser.addOption(recordOption);
+  QCommandLineOption replayOption("replay", "replay a recording on the same frame schedule", "file");
+  parser.addOption(replayOption);
+  QCommandLineOption quitOption("quit-after-replay", "exit once the replay has finished");
+  parser.addOption(quitOption);
+  QCommandLineOption cullOption("cull", "frustum and Hi-Z occlusion cull the trees on the GPU (C toggles)");
+  parser.addOption(cullOption);
+  QCommandLineOption impostorOption("impostors", "draw the far trees as camera facing impostors (I toggles)");
+  parser.addOption(impostorOption);
+  QCommandLineOption impostorDistanceOption("impostor-distance", "distance at which trees start to fade to impostors", "distance", "350");
+  parser.addOption(impostorDistanceOption);
+  QCommandLineOption impostorFadeOption("impostor-fade", "width of the mesh to impostor cross fade", "distance", "50");
+  parser.addOption(impostorFadeOption);
+  QCommandLineOption sortOption("sort", "draw the trees front to back (O toggles)");
+  parser.addOption(sortOption);
+  QCommandLineOption sortThresholdOption("sort-threshold", "distance the eye moves before the trees are re-sorted", "distance", "1.0");
+  parser.addOption(sortThresholdOption);
+  QCommandLineOption memoryOption("memory-report", "write the CPU / GPU memory accounting as JSON on exit", "file");
+  parser.addOption(memoryOption);
+  QCommandLineOption noProgramCacheOption("no-program-cache", "always compile the shaders rather than loading the cached program binaries");
+  parser.addOption(noProgramCacheOption);
+  QCommandLineOption programCacheOption("program-cache", "directory for the cached program binaries", "dir", "programcache");
+  parser.addOption(programCacheOption);
+  QCommandLineOption streamOption("stream", "stream the forest from tiles in dir (baked from the generated forest the first time)", "dir");
+  parser.addOption(streamOption);
+  QCommandLineOption streamRadiusOption("stream-radius", "tiles closer than this to the eye are loaded", "distance", "300");
+  parser.addOption(streamRadiusOption);
+  QCommandLineOption streamTileOption("stream-tile", "tile width used when baking", "size", "64");
+  parser.addOption(streamTileOption);
+  QCommandLineOption streamBudgetOption("stream-budget", "GPU memory for the resident tree transforms", "MB", "16");
+  parser.addOption(streamBudgetOption);
+  QCommandLineOption benchmarkTransformsOption("benchmark-transforms", "time the batch matrix kernels against ngl::Mat4 for count instances and exit",
+                                               "count");
+  parser.addOption(benchmarkTransformsOption);
+  QCommandLineOption benchmarkPlacementOption("benchmark-placement", "time the Poisson-disk tree placement for count trees and exit", "count");
+  parser.addOption(benchmarkPlacementOption);
+  QCommandLineOption benchmarkRandomOption("benchmark-random", "check and time the counter random kernels for count indices and exit", "count");
+  parser.addOption(benchmarkRandomOption);
+  QCommandLineOption startupTraceOption("startup-trace", "write the start up stages as a Chrome trace", "file");
+  parser.addOption(startupTraceOption);
+  QCommandLineOption blockingStartupOption("blocking-startup", "finish the start up in initializeGL rather than showing progress frames");
+  parser.addOption(blockingStartupOption);
+  QCommandLineOption checkRandomOption("check-random", "check the shader counter random numbers match the CPU at start up");
+  parser.addOption(checkRandomOption);
+  parser.process(app);
+  if (parser.isSet(benchmarkTransformsOption))
+  {
+    // CPU only so there is no window or GL context
+    BatchTransform::benchmark(std::cout, parser.value(benchmarkTransformsOption).toUInt());
+    return EXIT_SUCCESS;
+  }
+  if (parser.isSet(benchmarkPlacementOption))
+  {
+    PoissonDisk::benchmark(std::cout, parser.value(benchmarkPlacementOption).toUInt());
+    return EXIT_SUCCESS;
+  }
+  if (parser.isSet(benchmarkRandomOption))
+  {
+    CounterRandom::benchmark(std::cout, parser.value(benchmarkRandomOption).toUInt());
+    return EXIT_SUCCESS;
+  }
+  // the programs are built in initializeGL so the cache is set up before the window
+  ProgramCache::shared().setEnabled(!parser.isSet(noProgramCacheOption));
+  ProgramCache::shared().setDirectory(parser.value(programCacheOption).toStdString());
+  auto renderMode = RenderScheduler::modeFromName(parser.value(modeOption).toStdString());
   // create an OpenGL format specifier
   QSurfaceFormat format;
   // set the number of samples for multisampling
@@ -29,10 +115,44 @@ int main(int argc, char **argv)
   format.setProfile(QSurfaceFormat::CoreProfile);
   // now set the depth buffer to 24 bits
   format.setDepthBufferSize(24);
+  // benchmark mode runs uncapped, the others are paced by vsync
+  format.setSwapInterval(RenderScheduler::swapInterval(renderMode));
   // now we are going to create our scene window
   NGLScene window;
   // and set the OpenGL format
   window.setFormat(format);
+  window.setFrameBudget(parser.value(budgetOption).toFloat());
+  window.setRenderMode(renderMode);
+  window.setNumTrees(parser.value(treesOption).toUInt());
+  window.setChangesPerFrame(parser.value(changesOption).toUInt());
+  window.setFullUploadFraction(parser.value(fullUploadOption).toFloat());
+  window.setChurnPerFrame(parser.value(churnOption).toUInt());
+  window.setCulling(parser.isSet(cullOption));
+  window.setSorting(parser.isSet(sortOption), parser.value(sortThresholdOption).toFloat());
+  window.setImpostors(parser.isSet(impostorOption), parser.value(impostorDistanceOption).toFloat(), parser.value(impostorFadeOption).toFloat());
+  if (parser.isSet(streamOption))
+  {
+    window.setStreaming(parser.value(streamOption).toStdString(), parser.value(streamRadiusOption).toFloat(), parser.value(streamTileOption).toFloat(),
+                        parser.value(streamBudgetOption).toFloat());
+  }
+  if (parser.isSet(memoryOption))
+  {
+    window.setMemoryReport(parser.value(memoryOption).toStdString());
+  }
+  if (parser.isSet(startupTraceOption))
+  {
+    window.setStartupTrace(parser.value(startupTraceOption).toStdString());
+  }
+  window.setProgressiveStartup(!parser.isSet(blockingStartupOption));
+  window.setCheckRandom(parser.isSet(checkRandomOption));
+  if (parser.isSet(recordOption))
+  {
+    window.recordInput(parser.value(recordOption).toStdString());
+  }
+  if (parser.isSet(replayOption) && !window.replayInput(parser.value(replayOption).toStdString(), parser.isSet(quitOption)))
+  {
+    return EXIT_FAILURE;
+  }
   // we can now query the version to see if it worked
   std::cout<<"Profile is "<<format.majorVersion()<<" "<<format.minorVersion()<<"\n";
   // set the window size
@@ -2,6 +2,7 @@
 basic OpenGL demo modified from http://qt-project.org/doc/qt-5.0/qtgui/openglwindow.html
 ****************************************************************************/
 #include <QtGui/QGuiApplication>
+#include <QCommandLineParser>
 #include <iostream>
 #include "NGLScene.h"
 
@@ -10,6 +11,11 @@ basic OpenGL demo modified from http://qt-project.org/doc/qt-5.0/qtgui/openglwin
 int main(int argc, char **argv)
 {
   QGuiApplication app(argc, argv);
+  // the options are shared by all of the cube demos, see CubeScene::addOptions
+  QCommandLineParser parser;
+  parser.addHelpOption();
+  CubeScene::addOptions(parser);
+  parser.process(app);
   // create an OpenGL format specifier
   QSurfaceFormat format;
   // set the number of samples for multisampling
@@ -33,6 +39,10 @@ int main(int argc, char **argv)
   NGLScene window;
   // and set the OpenGL format
   window.setFormat(format);
+  if (!window.applyOptions(parser))
+  {
+    return EXIT_FAILURE;
+  }
   // we can now query the version to see if it worked
   std::cout<<"Profile is "<<format.majorVersion()<<" "<<format.minorVersion()<<"\n";
   // set the window size
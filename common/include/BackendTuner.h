@@ -0,0 +1,95 @@
+#ifndef BACKENDTUNER_H_
+#define BACKENDTUNER_H_
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "InstanceRenderer.h"
+//----------------------------------------------------------------------------------------------------------------------
+/// @file BackendTuner.h
+/// @brief startup calibration to pick the fastest instancing backend for this GPU / driver
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class BackendTuner
+/// @brief which backend is fastest varies a lot between drivers so this draws the scene with every
+/// backend and matrix encoding for a fixed number of frames into an offscreen FBO and picks the one
+/// with the lowest median frame time. Each measured frame is finished (glFinish) so the time covers
+/// both the CPU submission (the UBO batches) and the GPU work, the GPU time is reported as well.
+/// The decision is cached in a text file keyed on GL_RENDERER, GL_VERSION, the instance count and
+/// the scene settings that change which backend wins (the caller describes them) so later launches
+/// of the same setup skip the calibration and a different setup is calibrated again.
+//----------------------------------------------------------------------------------------------------------------------
+
+class BackendTuner
+{
+public:
+  struct Choice
+  {
+    InstanceRenderer::Backend backend = InstanceRenderer::Backend::TBO;
+    InstanceRenderer::Encoding encoding = InstanceRenderer::Encoding::Mat4;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief median times for one candidate
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Timing
+  {
+    Choice choice;
+    float frameMs = 0.0f;
+    float gpuMs = 0.0f;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draws one frame of the scene with the given choice, the FBO and viewport are already set
+  //----------------------------------------------------------------------------------------------------------------------
+  using DrawFunction = std::function<void(const Choice &)>;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ctor
+  /// @param[in] _cacheFile the file to store decisions in
+  //----------------------------------------------------------------------------------------------------------------------
+  explicit BackendTuner(std::string _cacheFile = "instancing_tune.txt");
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief set how many frames are drawn per candidate
+  /// @param[in] _warmup frames drawn before measuring (shader / driver warm up)
+  /// @param[in] _measured frames measured
+  //----------------------------------------------------------------------------------------------------------------------
+  void setFrames(int _warmup, int _measured);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief return the cached choice for this setup or run the calibration and cache the result,
+  /// must be called with a valid GL context
+  /// @param[in] _instances the number of instances being drawn (part of the cache key)
+  /// @param[in] _settings the other settings the timings depend on e.g. "views 1 prepass 0" (part of the
+  /// cache key, no tabs)
+  /// @param[in] _draw draws a frame
+  /// @param[in] _force ignore the cache and re-calibrate
+  //----------------------------------------------------------------------------------------------------------------------
+  Choice tune(GLuint _instances, const std::string &_settings, const DrawFunction &_draw, bool _force = false);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief true if the last tune came from the cache
+  //----------------------------------------------------------------------------------------------------------------------
+  bool fromCache() const { return m_fromCache; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the measurements from the last calibration (empty if cached)
+  //----------------------------------------------------------------------------------------------------------------------
+  const std::vector<Timing> &timings() const { return m_timings; }
+  void printSummary(std::ostream &_out) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the cache key for the current context
+  //----------------------------------------------------------------------------------------------------------------------
+  static std::string cacheKey(GLuint _instances, const std::string &_settings);
+
+private:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draw the frames for one candidate and return its medians
+  //----------------------------------------------------------------------------------------------------------------------
+  Timing measure(const Choice &_choice, const DrawFunction &_draw) const;
+  bool loadCached(const std::string &_key, Choice &o_choice) const;
+  void storeCached(const std::string &_key, const Choice &_choice) const;
+  std::string m_cacheFile;
+  int m_warmupFrames = 10;
+  int m_measuredFrames = 30;
+  bool m_fromCache = false;
+  Choice m_choice;
+  std::vector<Timing> m_timings;
+};
+
+#endif
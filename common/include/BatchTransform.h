@@ -0,0 +1,88 @@
+#ifndef BATCHTRANSFORM_H_
+#define BATCHTRANSFORM_H_
+#include <ngl/Mat4.h>
+#include <ngl/Vec3.h>
+#include <cstddef>
+#include <iosfwd>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file BatchTransform.h
+/// @brief SIMD kernels for building and transforming many instance matrices at once
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class BatchTransform
+/// @brief building each matrix with ngl::Mat4::translate(...) * ngl::Mat4::scale(...) costs two
+/// full matrix constructions and a 64 multiply product per instance. These kernels work on whole
+/// arrays instead: compose builds T * R * S from SoA position / quaternion / scale arrays, multiply
+/// pre-multiplies every matrix by one matrix and transformBounds gives the world AABB of a local
+/// box for each matrix. There are AVX2 (+FMA), SSE2 and scalar versions of each, the best one the
+/// CPU supports is picked at run time (setIsa can force a lower one). The matrices are 16 floats
+/// column major per instance, the same layout as ngl::Mat4 so &matrices[0].m_m[0][0] of a
+/// std::vector<ngl::Mat4> can be passed directly. The kernels are single threaded, split the
+/// arrays into ranges to run them on a WorkerPool.
+//----------------------------------------------------------------------------------------------------------------------
+
+class BatchTransform
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the kernel set in use
+  //----------------------------------------------------------------------------------------------------------------------
+  enum class Isa
+  {
+    Scalar,
+    SSE2,
+    AVX2
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the SoA input to compose, every array holds count values. The rotation is a unit
+  /// quaternion, leave the pointers null for no rotation
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Transforms
+  {
+    const float *px = nullptr;
+    const float *py = nullptr;
+    const float *pz = nullptr;
+    const float *qx = nullptr;
+    const float *qy = nullptr;
+    const float *qz = nullptr;
+    const float *qw = nullptr;
+    const float *sx = nullptr;
+    const float *sy = nullptr;
+    const float *sz = nullptr;
+    size_t count = 0;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the best kernel set this CPU (and build) supports
+  //----------------------------------------------------------------------------------------------------------------------
+  static Isa supported();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the kernel set in use, defaults to supported(), anything higher is clamped to it
+  //----------------------------------------------------------------------------------------------------------------------
+  static Isa isa();
+  static void setIsa(Isa _isa);
+  static const char *isaName(Isa _isa);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief build translate * rotate * scale for each instance
+  /// @param[in] _transforms the SoA input
+  /// @param[out] o_matrices 16 floats per instance
+  //----------------------------------------------------------------------------------------------------------------------
+  static void compose(const Transforms &_transforms, float *o_matrices);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief o_matrices[i] = _lhs * _matrices[i], o_matrices can be _matrices
+  //----------------------------------------------------------------------------------------------------------------------
+  static void multiply(const ngl::Mat4 &_lhs, const float *_matrices, size_t _count, float *o_matrices);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the axis aligned bounds of the box _min / _max transformed by each matrix
+  /// @param[out] o_min the minimum corners, 4 floats per instance (w is padding)
+  /// @param[out] o_max the maximum corners, 4 floats per instance (w is padding)
+  //----------------------------------------------------------------------------------------------------------------------
+  static void transformBounds(const float *_matrices, size_t _count, const ngl::Vec3 &_min, const ngl::Vec3 &_max, float *o_min, float *o_max);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief time each kernel set against the equivalent ngl::Mat4 loop for a number of instances
+  /// and check they give the same answers, leaves the kernel set as it was
+  //----------------------------------------------------------------------------------------------------------------------
+  static void benchmark(std::ostream &_out, size_t _count);
+};
+
+#endif
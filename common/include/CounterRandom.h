@@ -0,0 +1,85 @@
+#ifndef COUNTERRANDOM_H_
+#define COUNTERRANDOM_H_
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file CounterRandom.h
+/// @brief counter based random numbers (Philox4x32-10) that give the same bits on the CPU and GPU
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class CounterRandom
+/// @brief rather than stepping a shared state (ngl::Random) every value is a pure function of a
+/// key and a counter. The key is (seed, stream) and the counter is (index, draw) so any instance's
+/// random values can be worked out on its own, in any order, on any thread, or in a shader from
+/// gl_VertexID with shaders/CounterRandom.glsl (#include "CounterRandom.glsl"). Each call gives a
+/// block of 4 32 bit words, draw picks the next block when an instance needs more than 4 values.
+/// The stream separates unrelated uses of the same seed. unit() turns the top 24 bits into a float
+/// in [0, 1) with no rounding so the CPU and GLSL floats are identical too. fill() works out many
+/// consecutive indices at once with the AVX2 / SSE2 / scalar kernel set BatchTransform picked, the
+/// object form is a sequence (draw 0, 1, 2 ...) for code that wants one value after another.
+//----------------------------------------------------------------------------------------------------------------------
+
+class CounterRandom
+{
+public:
+  using Block = std::array<uint32_t, 4>;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the 4 words for one key and counter
+  //----------------------------------------------------------------------------------------------------------------------
+  static Block block(uint32_t _seed, uint32_t _stream, uint32_t _index, uint32_t _draw = 0);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief [0, 1) from the top 24 bits, exact so it matches counterUnit in the shader
+  //----------------------------------------------------------------------------------------------------------------------
+  static float unit(uint32_t _bits) { return static_cast<float>(_bits >> 8) * (1.0f / 16777216.0f); }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief [-1, 1)
+  //----------------------------------------------------------------------------------------------------------------------
+  static float signedUnit(uint32_t _bits) { return unit(_bits) * 2.0f - 1.0f; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the blocks for indices _first to _first + _count - 1
+  /// @param[out] o_bits 4 words per index, index major (the same order as block)
+  //----------------------------------------------------------------------------------------------------------------------
+  static void fill(uint32_t _seed, uint32_t _stream, uint32_t _draw, uint32_t _first, size_t _count, uint32_t *o_bits);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief fill with each word converted by unit()
+  /// @param[out] o_values 4 floats per index
+  //----------------------------------------------------------------------------------------------------------------------
+  static void fillUnit(uint32_t _seed, uint32_t _stream, uint32_t _draw, uint32_t _first, size_t _count, float *o_values);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a sequence for one index, each block is the next draw
+  //----------------------------------------------------------------------------------------------------------------------
+  CounterRandom(uint32_t _seed, uint32_t _stream, uint32_t _index = 0) : m_seed(_seed), m_stream(_stream), m_index(_index) {}
+  uint32_t next();
+  float uniform() { return unit(next()); }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief [0, _n) by a multiply and shift (Lemire) rather than a modulo
+  //----------------------------------------------------------------------------------------------------------------------
+  uint32_t below(uint32_t _n) { return static_cast<uint32_t>((static_cast<uint64_t>(next()) * _n) >> 32); }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief run shaders/CounterRandomCheck.glsl over _count indices with transform feedback and
+  /// compare the words with fill, needs a current GL context
+  /// @returns true if every word matched
+  //----------------------------------------------------------------------------------------------------------------------
+  static bool checkGpu(std::ostream &_out, size_t _count);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief check the known answers and that every kernel set gives the same words, then time them
+  /// against the std::mt19937 ngl::Random is built on
+  //----------------------------------------------------------------------------------------------------------------------
+  static void benchmark(std::ostream &_out, size_t _count);
+
+private:
+  uint32_t m_seed;
+  uint32_t m_stream;
+  uint32_t m_index;
+  uint32_t m_draw = 0;
+  Block m_block = {};
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief words left in m_block
+  //----------------------------------------------------------------------------------------------------------------------
+  unsigned m_left = 0;
+};
+
+#endif
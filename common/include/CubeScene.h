@@ -0,0 +1,327 @@
+#ifndef CUBESCENE_H_
+#define CUBESCENE_H_
+#include <ngl/Mat4.h>
+#include <ngl/Text.h>
+#include <QOpenGLWindow>
+#include <QCommandLineParser>
+#include <array>
+#include <memory>
+#include "WindowParams.h"
+#include "FrameStats.h"
+#include "FrameGraph.h"
+#include "RenderScheduler.h"
+#include "InstanceGenerator.h"
+#include "InstanceRenderer.h"
+#include "InputRecorder.h"
+#include "MemoryRegistry.h"
+#include "GpuTimer.h"
+#include "ViewSet.h"
+#include "StartupGraph.h"
+//----------------------------------------------------------------------------------------------------------------------
+/// @file CubeScene.h
+/// @brief the textured cube cloud scene shared by the TBO, UBO and Divisor demos
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class CubeScene
+/// @brief draws up to a million (setMaxInstances for more) textured cubes, the matrices are
+/// generated on the GPU each frame by the InstanceGenerator and then drawn by one of the InstanceRenderer backends. All of the
+/// backends are created up front so they can be switched (keys 1,2,3) on identical data, the
+/// demos just choose which one to start with. The matrix encoding can be switched with E and
+/// setAutoTune picks the fastest backend / encoding for this GPU at startup (see BackendTuner).
+/// G switches between generating the matrices on the GPU and streaming them from the CPU.
+/// The camera, instance count and backend can be recorded to a file and replayed (InputRecorder).
+/// P adds a depth pre-pass before the textured pass, each pass is timed on the GPU.
+/// The memory of every resource is tracked (MemoryRegistry) and shown in the overlay, setMemoryReport
+/// writes it as JSON on exit.
+/// V cycles the number of views (setViews), the cloud is seen from cameras spaced around it in a
+/// grid of viewports, all of the views are drawn by one instanced draw (see ViewSet).
+/// The start up runs as a StartupGraph, the points and texture are made on worker threads while
+/// the programs compile and frames showing the progress are drawn until everything is ready.
+/// The command line options are the same for every demo, addOptions / applyOptions declare and
+/// apply them so a demo's main only picks the starting backend.
+//----------------------------------------------------------------------------------------------------------------------
+
+class CubeScene : public QOpenGLWindow
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ctor
+  /// @param[in] _title the window title
+  /// @param[in] _backend the backend to start with
+  //----------------------------------------------------------------------------------------------------------------------
+  CubeScene(const char *_title, InstanceRenderer::Backend _backend);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief dtor must close down ngl and release OpenGL resources
+  //----------------------------------------------------------------------------------------------------------------------
+  ~CubeScene() override;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the initialize class is called once when the window is created and we have a valid GL context
+  /// use this to setup any default GL stuff
+  //----------------------------------------------------------------------------------------------------------------------
+  void initializeGL() override;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief this is called everytime we want to draw the scene
+  //----------------------------------------------------------------------------------------------------------------------
+  void paintGL() override;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief this is called everytime we resize
+  //----------------------------------------------------------------------------------------------------------------------
+  void resizeGL(int _w, int _h) override;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief add the command line options every cube demo takes
+  //----------------------------------------------------------------------------------------------------------------------
+  static void addOptions(QCommandLineParser &io_parser);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief set up the scene and the program cache from the processed options, must be called
+  /// after setFormat and before the window is shown as the render mode sets the swap interval
+  /// @returns false if a replay was asked for and could not be read
+  //----------------------------------------------------------------------------------------------------------------------
+  bool applyOptions(const QCommandLineParser &_parser);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief set the frame time above which a frame is counted as a stutter
+  /// @param[in] _ms the budget in ms
+  //----------------------------------------------------------------------------------------------------------------------
+  void setFrameBudget(float _ms);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief set how we schedule re-draws, see RenderScheduler
+  /// @param[in] _mode the mode to use
+  //----------------------------------------------------------------------------------------------------------------------
+  void setRenderMode(RenderScheduler::Mode _mode);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief switch the instancing backend, the instance data is left untouched
+  /// @param[in] _backend the backend to draw with
+  //----------------------------------------------------------------------------------------------------------------------
+  void setBackend(InstanceRenderer::Backend _backend);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief switch the layout of the instance matrices, they are re-generated on the next frame
+  /// @param[in] _encoding the encoding to use
+  //----------------------------------------------------------------------------------------------------------------------
+  void setEncoding(InstanceRenderer::Encoding _encoding);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief set the size of the point cloud (1M by default), must be called before the window is shown
+  /// and before setNumInstances. Past the driver limits the instances are drawn in chunks
+  //----------------------------------------------------------------------------------------------------------------------
+  void setMaxInstances(GLuint _count);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief set the number of instances to draw (clamped to the max)
+  //----------------------------------------------------------------------------------------------------------------------
+  void setNumInstances(GLuint _count);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief choose where the matrices are computed, see InstanceGenerator::Source
+  /// @param[in] _source the source to use
+  /// @param[in] _regions the number of frames of ring space for the Stream source
+  //----------------------------------------------------------------------------------------------------------------------
+  void setSource(InstanceGenerator::Source _source, GLuint _regions = 3);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief calibrate the backend / encoding in initializeGL, this overrides setBackend / setEncoding
+  /// @param[in] _enable run the tuner
+  /// @param[in] _force ignore any cached decision
+  //----------------------------------------------------------------------------------------------------------------------
+  void setAutoTune(bool _enable, bool _force = false);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draw the instances depth only first then textured with GL_EQUAL depth testing
+  //----------------------------------------------------------------------------------------------------------------------
+  void setDepthPrepass(bool _enable);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief how the generator stores the point cloud, must be called before the window is shown
+  //----------------------------------------------------------------------------------------------------------------------
+  void setPointFormat(InstanceGenerator::PointFormat _format) { m_generator.setPointFormat(_format); }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the number of views to draw, 1 is the normal single camera (clamped to ViewSet::maxViews
+  /// once the GL context exists)
+  //----------------------------------------------------------------------------------------------------------------------
+  void setViews(GLuint _views);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief write the memory accounting as JSON to a file on exit
+  //----------------------------------------------------------------------------------------------------------------------
+  void setMemoryReport(const std::string &_fileName) { m_memoryReport = _fileName; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draw progress frames while starting up (the default) or finish it all in initializeGL
+  //----------------------------------------------------------------------------------------------------------------------
+  void setProgressiveStartup(bool _enable) { m_progressiveStartup = _enable; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief write the start up stages to a file in the Chrome trace format once they are done
+  //----------------------------------------------------------------------------------------------------------------------
+  void setStartupTrace(const std::string &_fileName) { m_startupTrace = _fileName; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief compare the shader CounterRandom with the CPU one as a start up stage
+  //----------------------------------------------------------------------------------------------------------------------
+  void setCheckRandom(bool _enable) { m_checkRandom = _enable; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief record the input driven state to a file (written on exit)
+  //----------------------------------------------------------------------------------------------------------------------
+  void recordInput(const std::string &_fileName);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief replay a recording, live input is overridden while replaying
+  /// @param[in] _fileName the recording
+  /// @param[in] _quitWhenDone exit the application after the last event
+  /// @returns false if the file could not be read
+  //----------------------------------------------------------------------------------------------------------------------
+  bool replayInput(const std::string &_fileName, bool _quitWhenDone);
+
+protected:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief generate the matrices and draw the instances, the viewport must already be set
+  /// @param[in] _backend the backend to draw with
+  /// @param[in] _encoding the matrix encoding to generate
+  /// @param[in] _timed time each pass, this can't be used inside another GL_TIME_ELAPSED query
+  //----------------------------------------------------------------------------------------------------------------------
+  void drawInstances(InstanceRenderer::Backend _backend, InstanceRenderer::Encoding _encoding, bool _timed = false);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief record or apply the replayed input state, called at the start of each frame
+  //----------------------------------------------------------------------------------------------------------------------
+  void syncInput();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief update the number of instances to draw
+  //----------------------------------------------------------------------------------------------------------------------
+  void incInstances();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief decrease the number of instances to draw
+  //----------------------------------------------------------------------------------------------------------------------
+  void decInstances();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief create a cube and stuff it into a VBO on the GPU
+  /// @param[in] _scale a scale factor for the unit vertices
+  //----------------------------------------------------------------------------------------------------------------------
+  void createCube(GLfloat _scale);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief load the texture image into m_textureData, CPU only so it can run on a worker thread
+  //----------------------------------------------------------------------------------------------------------------------
+  void decodeTexture();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief upload the decoded texture
+  //----------------------------------------------------------------------------------------------------------------------
+  void loadTexture();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief run some of the start up and draw a progress frame
+  /// @returns false once the start up is done and the scene can be drawn
+  //----------------------------------------------------------------------------------------------------------------------
+  bool startupFrame();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief report the start up once the last stage is done
+  //----------------------------------------------------------------------------------------------------------------------
+  void finishStartup();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief Qt Event called when a key is pressed
+  /// @param [in] _event the Qt event to query for size etc
+  //----------------------------------------------------------------------------------------------------------------------
+  void keyPressEvent(QKeyEvent *_event) override;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief this method is called every time a mouse is moved
+  /// @param _event the Qt Event structure
+  //----------------------------------------------------------------------------------------------------------------------
+  void mouseMoveEvent(QMouseEvent *_event) override;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief this method is called everytime the mouse button is pressed
+  /// inherited from QObject and overridden here.
+  /// @param _event the Qt Event structure
+  //----------------------------------------------------------------------------------------------------------------------
+  void mousePressEvent(QMouseEvent *_event) override;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief this method is called everytime the mouse button is released
+  /// inherited from QObject and overridden here.
+  /// @param _event the Qt Event structure
+  //----------------------------------------------------------------------------------------------------------------------
+  void mouseReleaseEvent(QMouseEvent *_event) override;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief this method is called everytime the mouse wheel is moved
+  /// inherited from QObject and overridden here.
+  /// @param _event the Qt Event structure
+  //----------------------------------------------------------------------------------------------------------------------
+  void wheelEvent(QWheelEvent *_event) override;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the windows params such as mouse and rotations etc
+  //----------------------------------------------------------------------------------------------------------------------
+  WinParams m_win;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief used to store the global mouse transforms
+  //----------------------------------------------------------------------------------------------------------------------
+  ngl::Mat4 m_mouseGlobalTX;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief Our Camera
+  //----------------------------------------------------------------------------------------------------------------------
+  ngl::Mat4 m_view;
+  ngl::Mat4 m_project;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the model position for mouse movement
+  //----------------------------------------------------------------------------------------------------------------------
+  ngl::Vec3 m_modelPos;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief class for text rendering
+  //----------------------------------------------------------------------------------------------------------------------
+  std::unique_ptr<ngl::Text> m_text;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the texture ID for the box texture
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint m_textureName = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the RGB texels from decodeTexture waiting for loadTexture
+  //----------------------------------------------------------------------------------------------------------------------
+  std::vector<unsigned char> m_textureData;
+  int m_textureWidth = 0;
+  int m_textureHeight = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief polygon draw mode
+  //----------------------------------------------------------------------------------------------------------------------
+  GLenum m_polyMode = GL_FILL;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief decides when we re-draw
+  //----------------------------------------------------------------------------------------------------------------------
+  std::unique_ptr<RenderScheduler> m_scheduler;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief per frame timing
+  //----------------------------------------------------------------------------------------------------------------------
+  FrameStats m_frameStats;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief rolling frame time graph drawn in the overlay
+  //----------------------------------------------------------------------------------------------------------------------
+  std::unique_ptr<FrameGraph> m_frameGraph;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief VAO id for our box
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint m_vaoID = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief generates the instance matrices each frame
+  //----------------------------------------------------------------------------------------------------------------------
+  InstanceGenerator m_generator;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief all of the backends, indexed by InstanceRenderer::Backend
+  //----------------------------------------------------------------------------------------------------------------------
+  std::array<std::unique_ptr<InstanceRenderer>, 3> m_renderers;
+  InstanceRenderer::Backend m_backend;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief startup calibration flags
+  //----------------------------------------------------------------------------------------------------------------------
+  bool m_autoTune = false;
+  bool m_forceTune = false;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief input record / replay
+  //----------------------------------------------------------------------------------------------------------------------
+  InputRecorder m_input;
+  bool m_quitAfterReplay = false;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the optional depth pre-pass and the GPU time of each pass
+  //----------------------------------------------------------------------------------------------------------------------
+  bool m_depthPrepass = false;
+  std::unique_ptr<GpuTimer> m_depthTimer;
+  std::unique_ptr<GpuTimer> m_colourTimer;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the view matrices / viewports for multi view drawing
+  //----------------------------------------------------------------------------------------------------------------------
+  ViewSet m_viewSet;
+  GLuint m_views = 1;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief where to write the memory JSON on exit, empty for none
+  //----------------------------------------------------------------------------------------------------------------------
+  std::string m_memoryReport;
+  bool m_progressiveStartup = true;
+  bool m_checkRandom = false;
+  std::string m_startupTrace;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the start up stages, the CPU ones use the members above from worker threads until done
+  //----------------------------------------------------------------------------------------------------------------------
+  StartupGraph m_startup;
+};
+
+#endif
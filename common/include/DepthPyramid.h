@@ -0,0 +1,63 @@
+#ifndef DEPTHPYRAMID_H_
+#define DEPTHPYRAMID_H_
+#include <ngl/Types.h>
+#include "GpuTimer.h"
+#include <memory>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file DepthPyramid.h
+/// @brief a hierarchical Z (Hi-Z) depth pyramid for occlusion culling
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class DepthPyramid
+/// @brief owns a small power of 2 depth target for an occluder pre-pass and a R32F mip chain built
+/// from it by shaders/HiZDownsample.glsl, each texel holds the furthest depth of the area it covers.
+/// The size is fixed (independent of the window) as the occluders only need to be coarse.
+/// Usage : bindOccluderTarget(), draw the occluders depth only, build(), then test with HiZCuller
+//----------------------------------------------------------------------------------------------------------------------
+
+class DepthPyramid
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ctor
+  /// @param[in] _width the width of level 0, must be a power of 2
+  /// @param[in] _height the height of level 0, must be a power of 2
+  //----------------------------------------------------------------------------------------------------------------------
+  DepthPyramid(GLsizei _width = 512, GLsizei _height = 256);
+  ~DepthPyramid();
+  DepthPyramid(const DepthPyramid &) = delete;
+  DepthPyramid &operator=(const DepthPyramid &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief create the shader and textures, needs GL 4.3 for the compute shader
+  //----------------------------------------------------------------------------------------------------------------------
+  void initialize();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief bind and clear the occluder depth target, the current framebuffer / viewport are saved
+  //----------------------------------------------------------------------------------------------------------------------
+  void bindOccluderTarget();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief restore the framebuffer and build the pyramid from the occluder depth
+  //----------------------------------------------------------------------------------------------------------------------
+  void build();
+  GLuint texture() const { return m_pyramid; }
+  int levels() const { return m_levels; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief GPU time of the occluder pass and the pyramid build
+  //----------------------------------------------------------------------------------------------------------------------
+  float gpuMs() const { return m_gpuMs; }
+
+private:
+  GLsizei m_width;
+  GLsizei m_height;
+  int m_levels = 1;
+  GLuint m_fbo = 0;
+  GLuint m_depth = 0;
+  GLuint m_pyramid = 0;
+  GLint m_savedFBO = 0;
+  GLint m_savedViewport[4] = {0, 0, 0, 0};
+  std::unique_ptr<GpuTimer> m_timer;
+  float m_gpuMs = 0.0f;
+};
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef DIVISORINSTANCERENDERER_H_
+#define DIVISORINSTANCERENDERER_H_
+#include "InstanceRenderer.h"
+//----------------------------------------------------------------------------------------------------------------------
+/// @file DivisorInstanceRenderer.h
+/// @brief Divisor instancing backend
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class DivisorInstanceRenderer
+/// @brief feeds the matrices to the vertex shader as 4 (3 for affine) vec4 attributes with a divisor of 1
+//----------------------------------------------------------------------------------------------------------------------
+
+class DivisorInstanceRenderer : public InstanceRenderer
+{
+public:
+  void initialize() override;
+  void draw(const Mesh &_mesh, const InstanceData &_data, const ngl::Mat4 &_project, Pass _pass = Pass::Colour) override;
+  Backend backend() const override { return Backend::Divisor; }
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef FENCEWAITSTATS_H_
+#define FENCEWAITSTATS_H_
+#include <cstdint>
+#include <vector>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file FenceWaitStats.h
+/// @brief waits on the fence of a ring buffer region and keeps the wait statistics
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class FenceWaitStats
+/// @brief InstanceStream waits on a GL sync before re-writing a region, this does the waiting and
+/// the accounting through the small Fence interface so it needs no GL and can be tested with fake
+/// fences. A fence that is already signalled isn't a wait, one that is still pending is blocked on
+/// and timed, the count, total, max and which region it was are recorded.
+//----------------------------------------------------------------------------------------------------------------------
+
+class FenceWaitStats
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a fence as the accounting sees it
+  //----------------------------------------------------------------------------------------------------------------------
+  class Fence
+  {
+  public:
+    virtual ~Fence() = default;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief true if the GPU is already past the fence, must not block
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual bool signalled() = 0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief block until the GPU is past the fence
+    //----------------------------------------------------------------------------------------------------------------------
+    virtual void block() = 0;
+  };
+  struct Stats
+  {
+    uint64_t frames = 0;
+    uint64_t waits = 0;
+    double totalWaitMs = 0.0;
+    float maxWaitMs = 0.0f;
+    float lastWaitMs = 0.0f;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the region of the last wait (-1 for none) and the waits on each region
+    //----------------------------------------------------------------------------------------------------------------------
+    int lastWaitRegion = -1;
+    std::vector<uint64_t> regionWaits;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief count a frame written to the ring
+  //----------------------------------------------------------------------------------------------------------------------
+  void frame() { ++m_stats.frames; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief make sure the GPU is done with a region before it is written
+  /// @param[in] _region the region the fence guards
+  /// @param[in] _fence its fence
+  /// @returns the time blocked in ms, 0 if the fence was already signalled
+  //----------------------------------------------------------------------------------------------------------------------
+  float wait(unsigned _region, Fence &_fence);
+  const Stats &stats() const { return m_stats; }
+  void reset() { m_stats = Stats(); }
+
+private:
+  Stats m_stats;
+};
+
+#endif
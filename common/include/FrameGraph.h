@@ -0,0 +1,47 @@
+#ifndef FRAMEGRAPH_H_
+#define FRAMEGRAPH_H_
+#include <ngl/AbstractVAO.h>
+#include <memory>
+#include "FrameStats.h"
+//----------------------------------------------------------------------------------------------------------------------
+/// @file FrameGraph.h
+/// @brief draws a rolling graph of frame times as part of the text overlay
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class FrameGraph
+/// @brief draws the FrameStats history as a line strip with the stutter budget as a horizontal
+/// line, must be created once we have a valid GL context
+//----------------------------------------------------------------------------------------------------------------------
+
+class FrameGraph
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ctor, position and size are in window co-ordinates from the bottom left
+  /// @param[in] _x,_y the bottom left of the graph
+  /// @param[in] _width,_height the size of the graph, one pixel per frame in x
+  /// @param[in] _maxMs the frame time mapped to the top of the graph (longer frames are clamped)
+  //----------------------------------------------------------------------------------------------------------------------
+  FrameGraph(int _x, int _y, int _width, int _height, float _maxMs = 50.0f);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draw the graph
+  /// @param[in] _stats the stats to draw
+  /// @param[in] _screenWidth,_screenHeight the current window size
+  //----------------------------------------------------------------------------------------------------------------------
+  void draw(const FrameStats &_stats, int _screenWidth, int _screenHeight);
+
+private:
+  int m_x;
+  int m_y;
+  int m_width;
+  int m_height;
+  float m_maxMs;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief line strip for the frame times and lines for the budget / axis
+  //----------------------------------------------------------------------------------------------------------------------
+  std::unique_ptr<ngl::AbstractVAO> m_graphVAO;
+  std::unique_ptr<ngl::AbstractVAO> m_budgetVAO;
+};
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef FRAMESTATS_H_
+#define FRAMESTATS_H_
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file FrameStats.h
+/// @brief per-frame timing recorder shared by all of the instancing demos
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class FrameStats
+/// @brief records the time of every frame into a fixed size lock-free ring buffer so we can
+/// report rolling percentiles (tail latency) rather than a once a second fps average. A full
+/// histogram of every frame since start up is also kept so the whole distribution can be
+/// dumped when the demo exits. There is a single writer (the GUI / render thread) any other
+/// thread may read the stats at any time.
+//----------------------------------------------------------------------------------------------------------------------
+
+class FrameStats
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief number of frames kept for the rolling stats, must be a power of 2
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr size_t c_historySize = 1024;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief width of each histogram bin in ms, and the number of bins (anything larger goes in the last bin)
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr float c_binWidth = 0.1f;
+  static constexpr size_t c_numBins = 1000;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief rolling stats over the last c_historySize frames, all times in ms
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Summary
+  {
+    float p50 = 0.0f;
+    float p95 = 0.0f;
+    float p99 = 0.0f;
+    float max = 0.0f;
+    float mean = 0.0f;
+    size_t frames = 0;
+    size_t stutters = 0;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ctor
+  /// @param[in] _budgetMs frames taking longer than this are counted as a stutter (default 60Hz)
+  //----------------------------------------------------------------------------------------------------------------------
+  explicit FrameStats(float _budgetMs = 1000.0f / 60.0f);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief call once at the start of each frame, the time since the previous call is recorded
+  //----------------------------------------------------------------------------------------------------------------------
+  void tick();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief add a frame time directly
+  /// @param[in] _ms the frame time in ms
+  //----------------------------------------------------------------------------------------------------------------------
+  void addFrame(float _ms);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief forget the previous tick, use when rendering has been paused so the gap isn't counted as a frame
+  //----------------------------------------------------------------------------------------------------------------------
+  void resetTick();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief set / get the stutter budget in ms
+  //----------------------------------------------------------------------------------------------------------------------
+  void setBudget(float _ms);
+  float budget() const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief calculate the rolling percentiles over the ring buffer
+  //----------------------------------------------------------------------------------------------------------------------
+  Summary summary() const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief copy the most recent frame times (oldest first) for graphing
+  /// @param[out] _out array to fill
+  /// @param[in] _count max number of frames to copy
+  /// @returns the number of frames copied
+  //----------------------------------------------------------------------------------------------------------------------
+  size_t history(float *_out, size_t _count) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief total frames / stutters since start up
+  //----------------------------------------------------------------------------------------------------------------------
+  uint64_t totalFrames() const;
+  uint64_t totalStutters() const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief percentile over every frame since start up, this is taken from the histogram so
+  /// is only accurate to c_binWidth
+  /// @param[in] _p the percentile in the range [0-1]
+  //----------------------------------------------------------------------------------------------------------------------
+  float totalPercentile(float _p) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief print a summary of the full run to _out
+  //----------------------------------------------------------------------------------------------------------------------
+  void printSummary(std::ostream &_out) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief write the full distribution as csv (bin start ms, count)
+  /// @param[in] _fname the file to write
+  /// @returns true on success
+  //----------------------------------------------------------------------------------------------------------------------
+  bool writeHistogram(std::string_view _fname) const;
+
+private:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the ring buffer of frame times, m_head is the total number of frames written
+  //----------------------------------------------------------------------------------------------------------------------
+  std::array<std::atomic<float>, c_historySize> m_ring;
+  std::atomic<uint64_t> m_head{0};
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief histogram of every frame since start up
+  //----------------------------------------------------------------------------------------------------------------------
+  std::array<std::atomic<uint32_t>, c_numBins> m_histogram;
+  std::atomic<uint64_t> m_stutters{0};
+  std::atomic<float> m_maxFrame{0.0f};
+  std::atomic<float> m_budget;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief time of the previous tick, only touched by the writer
+  //----------------------------------------------------------------------------------------------------------------------
+  std::chrono::steady_clock::time_point m_lastTick;
+  bool m_haveTick = false;
+};
+
+#endif
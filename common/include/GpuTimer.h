@@ -1,57 +1,68 @@
-#ifndef WINDOWPARAMS_H_
-#define WINDOWPARAMS_H_
+#ifndef GPUTIMER_H_
+#define GPUTIMER_H_
+#include <ngl/Types.h>
+#include <array>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file GpuTimer.h
+/// @brief measures GPU time with GL_TIME_ELAPSED queries
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class GpuTimer
+/// @brief wraps a small ring of GL_TIME_ELAPSED query objects, only one timer can be active at once
+/// (a GL rule) so the timers can't be nested. elapsedMs() waits for the last begin / end which is
+/// fine for calibration, in the render loop use latestMs() which never stalls and returns the most
+/// recent result the GPU has finished (a few frames behind). The same ring works for any other
+/// query target with a single result (e.g. GL_SAMPLES_PASSED), read it with latestValue().
+//----------------------------------------------------------------------------------------------------------------------
 
-struct WinParams
+class GpuTimer
 {
+public:
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief used to store the x rotation mouse value
-  //----------------------------------------------------------------------------------------------------------------------
-  int spinXFace = 0;
-  //----------------------------------------------------------------------------------------------------------------------
-  /// @brief used to store the y rotation mouse value
-  //----------------------------------------------------------------------------------------------------------------------
-  int spinYFace = 0;
-  //----------------------------------------------------------------------------------------------------------------------
-  /// @brief flag to indicate if the mouse button is pressed when dragging
+  /// @brief the queries are created here so a GL context must be current
+  /// @param[in] _target the query target
   //----------------------------------------------------------------------------------------------------------------------
-  bool rotate = false;
+  explicit GpuTimer(GLenum _target = GL_TIME_ELAPSED);
+  ~GpuTimer();
+  GpuTimer(const GpuTimer &) = delete;
+  GpuTimer &operator=(const GpuTimer &) = delete;
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief flag to indicate if the Right mouse button is pressed when dragging
+  /// @brief start / stop timing the GL commands issued between them
   //----------------------------------------------------------------------------------------------------------------------
-  bool translate = false;
+  void begin();
+  void end();
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief the previous x mouse value
+  /// @brief true once the result of the last begin / end is ready
   //----------------------------------------------------------------------------------------------------------------------
-  int origX = 0;
+  bool available() const;
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief the previous y mouse value
+  /// @brief the time in ms between the last begin / end, waits for the GPU if not available
   //----------------------------------------------------------------------------------------------------------------------
-  int origY = 0;
+  float elapsedMs();
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief the previous x mouse value for Position changes
+  /// @brief the most recent finished result in ms, does not wait
   //----------------------------------------------------------------------------------------------------------------------
-  int origXPos = 0;
+  float latestMs();
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief the previous y mouse value for Position changes
+  /// @brief the most recent finished result as returned by GL (ns for the timer), does not wait
   //----------------------------------------------------------------------------------------------------------------------
-  int origYPos = 0;
+  GLuint64 latestValue();
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief window width
+  /// @brief number of queries in flight before begin has to wait for the oldest
   //----------------------------------------------------------------------------------------------------------------------
-  int width = 1024;
+  static constexpr size_t c_numQueries = 4;
+
+private:
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief window height
+  /// @brief read a pending query into m_latest
   //----------------------------------------------------------------------------------------------------------------------
-  int height = 720;
+  void collect(size_t _index);
+  std::array<GLuint, c_numQueries> m_queries = {};
+  std::array<bool, c_numQueries> m_pending = {};
+  size_t m_current = 0;
+  GLenum m_target;
+  GLuint64 m_latest = 0;
 };
 
-//----------------------------------------------------------------------------------------------------------------------
-/// @brief the increment for x/y translation with mouse movement
-//----------------------------------------------------------------------------------------------------------------------
-constexpr float INCREMENT = 0.1f;
-//----------------------------------------------------------------------------------------------------------------------
-/// @brief the increment for the wheel zoom
-//----------------------------------------------------------------------------------------------------------------------
-constexpr float ZOOM = 1.0f;
-
 #endif
@@ -0,0 +1,106 @@
+#ifndef HIZCULLER_H_
+#define HIZCULLER_H_
+#include <ngl/Mat4.h>
+#include <ngl/Vec3.h>
+#include <array>
+#include <memory>
+#include "DepthPyramid.h"
+#include "GpuTimer.h"
+//----------------------------------------------------------------------------------------------------------------------
+/// @file HiZCuller.h
+/// @brief GPU frustum and Hi-Z occlusion culling of instances
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class HiZCuller
+/// @brief runs shaders/HiZCull.glsl over a TBO of per instance model matrices, testing the projected
+/// bounds of each against the frustum and a DepthPyramid. The visible instance ids are appended to a
+/// buffer (exposed as a R32UI TBO so the vertex shader can use visible[gl_InstanceID]) and the count
+/// goes straight into a DrawArraysIndirectCommand so nothing is read back to draw. The culled counts
+/// are read back a few frames late so they never stall. With a LOD range set the survivors are split
+/// by distance into a near (mesh) list and a far (impostor) list, both are kept in the fade band.
+//----------------------------------------------------------------------------------------------------------------------
+
+class HiZCuller
+{
+public:
+  struct Stats
+  {
+    GLuint tested = 0;
+    GLuint visible = 0;
+    GLuint frustumCulled = 0;
+    GLuint occluded = 0;
+    GLuint impostors = 0;
+  };
+  HiZCuller() = default;
+  ~HiZCuller();
+  HiZCuller(const HiZCuller &) = delete;
+  HiZCuller &operator=(const HiZCuller &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief create the shader and buffers, needs GL 4.3
+  /// @param[in] _maxInstances the most instances that will be culled
+  //----------------------------------------------------------------------------------------------------------------------
+  void initialize(GLuint _maxInstances);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief true if the context has compute shaders (GL 4.3)
+  //----------------------------------------------------------------------------------------------------------------------
+  static bool supported();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief cull the instances
+  /// @param[in] _instances the TBO texture holding a mat4 per instance
+  /// @param[in] _count the number of instances
+  /// @param[in] _numVerts the vertex count for the draw command
+  /// @param[in] _project the projection
+  /// @param[in] _view the view (including any global transform)
+  /// @param[in] _boundsMin _boundsMax the local bounds of the mesh
+  /// @param[in] _pyramid the pyramid to test against or nullptr to only frustum cull
+  //----------------------------------------------------------------------------------------------------------------------
+  void cull(GLuint _instances, GLuint _count, GLuint _numVerts, const ngl::Mat4 &_project, const ngl::Mat4 &_view, const ngl::Vec3 &_boundsMin,
+            const ngl::Vec3 &_boundsMax, const DepthPyramid *_pyramid);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief split the visible instances by view distance, beyond _near they go in the far list and
+  /// beyond _far they are only in the far list, _far <= 0 puts everything in the near list
+  //----------------------------------------------------------------------------------------------------------------------
+  void setLodRange(float _near, float _far);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief test the instances in the order of a TBO of ids (e.g. sorted front to back) so the lists
+  /// come out close to that order, 0 tests them by index. Each list is appended to atomically so the
+  /// order is only kept as far as the GPU runs the work groups in order
+  //----------------------------------------------------------------------------------------------------------------------
+  void setOrder(GLuint _ids) { m_order = _ids; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draw the visible (near) instances of the last cull, the mesh VAO and program must be bound
+  //----------------------------------------------------------------------------------------------------------------------
+  void draw() const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draw the far instances as 4 vertex triangle strips, a VAO and the impostor program must be bound
+  //----------------------------------------------------------------------------------------------------------------------
+  void drawFar() const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the TBO textures of visible (near) and far ids
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint visibleTBO() const { return m_visibleTBO; }
+  GLuint farTBO() const { return m_farTBO; }
+  bool hasCulled() const { return m_frame > 0; }
+  const Stats &stats() const { return m_stats; }
+  float gpuMs() const { return m_gpuMs; }
+
+private:
+  static constexpr size_t c_readbackLatency = 3;
+  GLuint m_visible = 0;
+  GLuint m_visibleTBO = 0;
+  GLuint m_far = 0;
+  GLuint m_farTBO = 0;
+  float m_lodNear = 0.0f;
+  float m_lodFar = 0.0f;
+  GLuint m_order = 0;
+  GLuint m_command = 0;
+  std::array<GLuint, c_readbackLatency> m_readback = {};
+  std::array<GLuint, c_readbackLatency> m_readbackTested = {};
+  uint64_t m_frame = 0;
+  Stats m_stats;
+  std::unique_ptr<GpuTimer> m_timer;
+  float m_gpuMs = 0.0f;
+};
+
+#endif
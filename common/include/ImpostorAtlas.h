@@ -0,0 +1,72 @@
+#ifndef IMPOSTORATLAS_H_
+#define IMPOSTORATLAS_H_
+#include <ngl/Mat4.h>
+#include <ngl/Vec3.h>
+#include <functional>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file ImpostorAtlas.h
+/// @brief pre-rendered views of a mesh used to draw distant instances as camera facing quads
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class ImpostorAtlas
+/// @brief bakes a mesh from a ring of views around its Y axis into a colour + depth atlas (one square
+/// tile per view), the impostor shader then draws each far instance as an upright quad facing the
+/// camera textured with the closest view, the baked depth is used to write a per pixel depth so the
+/// impostors intersect the meshes / each other properly. Instances in the fade band are cross faded
+/// with a screen door dither against the mesh (see the lodRange uniform in the mesh shader).
+//----------------------------------------------------------------------------------------------------------------------
+
+class ImpostorAtlas
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draws the mesh once, the bake program is active with the MVP uniform set
+  //----------------------------------------------------------------------------------------------------------------------
+  using DrawFunction = std::function<void()>;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ctor
+  /// @param[in] _views the number of views around the Y axis
+  /// @param[in] _viewSize the size in pixels of each view
+  //----------------------------------------------------------------------------------------------------------------------
+  ImpostorAtlas(int _views = 16, GLsizei _viewSize = 128);
+  ~ImpostorAtlas();
+  ImpostorAtlas(const ImpostorAtlas &) = delete;
+  ImpostorAtlas &operator=(const ImpostorAtlas &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief create the bake and draw programs
+  //----------------------------------------------------------------------------------------------------------------------
+  void initialize();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief render the views of the mesh into the atlas
+  /// @param[in] _draw draws the mesh (position attribute 0, UV attribute 2)
+  /// @param[in] _texture the colour texture of the mesh
+  /// @param[in] _boundsMin _boundsMax the local bounds of the mesh
+  //----------------------------------------------------------------------------------------------------------------------
+  void bake(const DrawFunction &_draw, GLuint _texture, const ngl::Vec3 &_boundsMin, const ngl::Vec3 &_boundsMax);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief make the impostor program and atlas current ready for a 4 vertex triangle strip per instance,
+  /// the instance matrix TBO must be on unit 0
+  /// @param[in] _ids the TBO texture of instance ids to draw
+  /// @param[in] _project the projection
+  /// @param[in] _view the view (including any global transform)
+  /// @param[in] _near _far the fade band, see HiZCuller::setLodRange
+  //----------------------------------------------------------------------------------------------------------------------
+  void use(GLuint _ids, const ngl::Mat4 &_project, const ngl::Mat4 &_view, float _near, float _far);
+  GLuint colourTexture() const { return m_colour; }
+  GLuint depthTexture() const { return m_depth; }
+  int views() const { return m_views; }
+
+private:
+  int m_views;
+  int m_columns;
+  GLsizei m_viewSize;
+  GLuint m_colour = 0;
+  GLuint m_depth = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the impostors are drawn without any vertex data but core profile still needs a VAO
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint m_vao = 0;
+};
+
+#endif
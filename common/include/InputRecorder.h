@@ -0,0 +1,101 @@
+#ifndef INPUTRECORDER_H_
+#define INPUTRECORDER_H_
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file InputRecorder.h
+/// @brief record / replay of the scene state driven by input so benchmark runs see identical views
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class InputRecorder
+/// @brief rather than raw Qt events (which depend on window size, timing etc) the scenes record the
+/// state the input drives (camera spin / position, instance count, backend) as named channels of up
+/// to 4 floats. When recording a channel is written whenever its value changes, tagged with the frame
+/// number and the time. When replaying the events are applied by frame number, not time, so the same
+/// state changes happen on the same frames however fast the machine is.
+/// File format, one event per line : frame timeMs channel v0 [v1 v2 v3]
+//----------------------------------------------------------------------------------------------------------------------
+
+class InputRecorder
+{
+public:
+  enum class Mode
+  {
+    Off,
+    Record,
+    Replay
+  };
+  using Values = std::array<float, 4>;
+  struct Event
+  {
+    uint64_t frame = 0;
+    float timeMs = 0.0f;
+    std::string channel;
+    uint32_t count = 0;
+    Values values = {};
+  };
+  InputRecorder() = default;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the recording is written here
+  //----------------------------------------------------------------------------------------------------------------------
+  ~InputRecorder();
+  InputRecorder(const InputRecorder &) = delete;
+  InputRecorder &operator=(const InputRecorder &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief start recording, the file is written when the recorder is destroyed (or save is called)
+  //----------------------------------------------------------------------------------------------------------------------
+  void startRecording(std::string _fileName);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief load a recording to replay
+  /// @returns false if the file could not be read
+  //----------------------------------------------------------------------------------------------------------------------
+  bool startReplay(const std::string &_fileName);
+  Mode mode() const { return m_mode; }
+  bool recording() const { return m_mode == Mode::Record; }
+  bool replaying() const { return m_mode == Mode::Replay; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief call once at the start of each frame, when replaying this applies the events for the frame
+  //----------------------------------------------------------------------------------------------------------------------
+  void beginFrame();
+  uint64_t frame() const { return m_frame; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief when recording add an event if the channel has changed since it was last recorded
+  //----------------------------------------------------------------------------------------------------------------------
+  void record(std::string_view _channel, std::initializer_list<float> _values);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief when replaying get the current value of a channel
+  /// @returns false if nothing has been recorded for the channel yet
+  //----------------------------------------------------------------------------------------------------------------------
+  bool value(std::string_view _channel, Values &o_values) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief true once a replay has passed its last event
+  //----------------------------------------------------------------------------------------------------------------------
+  bool finished() const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief write the recording
+  //----------------------------------------------------------------------------------------------------------------------
+  bool save() const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+  Mode m_mode = Mode::Off;
+  std::string m_fileName;
+  std::vector<Event> m_events;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the current (replay) or last recorded (record) value of each channel
+  //----------------------------------------------------------------------------------------------------------------------
+  std::map<std::string, Event, std::less<>> m_state;
+  size_t m_cursor = 0;
+  uint64_t m_frame = 0;
+  bool m_started = false;
+  Clock::time_point m_start;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef INSTANCEBUFFER_H_
+#define INSTANCEBUFFER_H_
+#include <ngl/Types.h>
+#include <cstdint>
+#include "MemoryRegistry.h"
+//----------------------------------------------------------------------------------------------------------------------
+/// @file InstanceBuffer.h
+/// @brief a GL buffer with reserved capacity for instance data
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class InstanceBuffer
+/// @brief changing the instance count used to re-allocate the buffer with glBufferData each time which
+/// churns driver allocations and stalls the pipeline. This keeps a capacity that grows geometrically
+/// so most resizes only change the active size, shrinking never re-allocates. Where available
+/// (GL 4.4 or ARB_buffer_storage) the store is immutable (glBufferStorage) so a re-allocation is a
+/// new buffer name, otherwise glBufferData is used. generation() changes on every re-allocation so
+/// anything attached to the store (e.g. a TBO) knows to re-attach. The capacity is reported to the
+/// MemoryRegistry under the category given at construction.
+//----------------------------------------------------------------------------------------------------------------------
+
+class InstanceBuffer
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ctor, no GL calls are made until the first resize
+  /// @param[in] _storageFlags the glBufferStorage flags (e.g. GL_DYNAMIC_STORAGE_BIT), 0 for GPU only data
+  /// @param[in] _usage the glBufferData usage when immutable storage is not available
+  /// @param[in] _category what the memory is counted as
+  //----------------------------------------------------------------------------------------------------------------------
+  explicit InstanceBuffer(GLbitfield _storageFlags = 0, GLenum _usage = GL_DYNAMIC_COPY,
+                          MemoryRegistry::Category _category = MemoryRegistry::Category::Matrices);
+  ~InstanceBuffer();
+  InstanceBuffer(const InstanceBuffer &) = delete;
+  InstanceBuffer &operator=(const InstanceBuffer &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief set the active size, only re-allocates (losing the contents) if it is over the capacity
+  /// @param[in] _bytes the size in bytes
+  /// @returns true if the buffer was re-allocated
+  //----------------------------------------------------------------------------------------------------------------------
+  bool resize(GLsizeiptr _bytes);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief make sure there is at least this much capacity without changing the size
+  //----------------------------------------------------------------------------------------------------------------------
+  bool reserve(GLsizeiptr _bytes);
+  GLuint id() const { return m_id; }
+  GLsizeiptr size() const { return m_size; }
+  GLsizeiptr capacity() const { return m_capacity; }
+  uint32_t generation() const { return m_generation; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief true if glBufferStorage can be used in the current context
+  //----------------------------------------------------------------------------------------------------------------------
+  static bool immutableStorageSupported();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief capacity grows by this factor (or to the requested size if bigger)
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr float c_growth = 1.5f;
+
+private:
+  void allocate(GLsizeiptr _bytes);
+  GLuint m_id = 0;
+  GLsizeiptr m_size = 0;
+  GLsizeiptr m_capacity = 0;
+  uint32_t m_generation = 0;
+  GLbitfield m_storageFlags;
+  GLenum m_usage;
+  MemoryRegistry::Category m_category;
+};
+
+#endif
@@ -0,0 +1,195 @@
+#ifndef INSTANCEGENERATOR_H_
+#define INSTANCEGENERATOR_H_
+#include <ngl/Mat4.h>
+#include <ngl/Vec3.h>
+#include <memory>
+#include <vector>
+#include "InstanceBuffer.h"
+#include "InstanceRenderer.h"
+#include "InstanceStream.h"
+//----------------------------------------------------------------------------------------------------------------------
+/// @file InstanceGenerator.h
+/// @brief generates the per instance matrices for the cube demos on the GPU
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class InstanceGenerator
+/// @brief creates a cloud of points (a sort of supertorus distribution) and each frame runs the
+/// transform feedback shader (shaders/feedback.glsl) over them to produce a ModelView matrix per
+/// instance. The same points are used whatever backend draws them, each point only depends on its
+/// index through a CounterRandom with a fixed seed so every run sees the same cloud, the points
+/// are made in parallel and the shader can make the same cloud itself (PointFormat::Generated). The matrices can be written in either InstanceRenderer::Encoding.
+/// The matrices can also be computed on the CPU (the same maths as the shader) and streamed to the
+/// GPU through an InstanceStream, this is the path to use for CPU simulated transforms.
+/// The points can be stored quantized to the bounds of the cloud (see PointFormat) to cut the
+/// memory / bandwidth of the feedback input, the CPU path uses the same dequantized points.
+/// Large instance sets are split into chunks sized from the driver limits (see InstanceLimits),
+/// the feedback source writes each chunk to its own buffer and the stream source splits its region.
+//----------------------------------------------------------------------------------------------------------------------
+
+class InstanceGenerator
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief where the matrices are computed
+  /// Feedback : on the GPU with transform feedback into an InstanceBuffer
+  /// Stream   : on the CPU and written to a persistent mapped InstanceStream
+  //----------------------------------------------------------------------------------------------------------------------
+  enum class Source
+  {
+    Feedback,
+    Stream
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief how the points are stored in the feedback input buffer
+  /// Float   : 3 floats (12 bytes)
+  /// Unorm16 : 3 unsigned shorts normalized to the bounds of the cloud (6 bytes)
+  /// Packed  : GL_UNSIGNED_INT_2_10_10_10_REV normalized to the bounds (4 bytes)
+  /// Generated : nothing is stored, feedback.glsl works each point out from gl_VertexID with
+  /// CounterRandom.glsl (0 bytes, the CPU copy matches to the precision of the trig)
+  //----------------------------------------------------------------------------------------------------------------------
+  enum class PointFormat
+  {
+    Float,
+    Unorm16,
+    Packed,
+    Generated
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the size of the point buffer and how far the quantized points are from the originals
+  //----------------------------------------------------------------------------------------------------------------------
+  struct PointStats
+  {
+    size_t bytes = 0;
+    double maxError = 0.0;
+    double meanError = 0.0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the largest extent of the cloud, to put the errors in context
+    //----------------------------------------------------------------------------------------------------------------------
+    double extent = 0.0;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ctor
+  /// @param[in] _maxInstances the number of points to create
+  //----------------------------------------------------------------------------------------------------------------------
+  explicit InstanceGenerator(GLuint _maxInstances);
+  ~InstanceGenerator();
+  InstanceGenerator(const InstanceGenerator &) = delete;
+  InstanceGenerator &operator=(const InstanceGenerator &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief create the shader and point data, must be called with a valid GL context, the same
+  /// as createPrograms, createPoints then uploadPoints
+  //----------------------------------------------------------------------------------------------------------------------
+  void initialize();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the steps of initialize so they can be run as separate start up stages, only
+  /// createPoints is CPU work and can run on another thread (before uploadPoints)
+  //----------------------------------------------------------------------------------------------------------------------
+  void createPrograms();
+  void createPoints();
+  void uploadPoints();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief set the number of instances to generate, the matrix buffer is re-sized on the next generate
+  /// which only re-allocates if it grows past the current capacity
+  //----------------------------------------------------------------------------------------------------------------------
+  void setNumInstances(GLuint _count);
+  GLuint numInstances() const { return m_instances; }
+  GLuint maxInstances() const { return m_maxInstances; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the size of the point cloud, must be set before initialize
+  //----------------------------------------------------------------------------------------------------------------------
+  void setMaxInstances(GLuint _maxInstances);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief set the matrix layout to write, the matrix buffer is re-sized on the next generate
+  //----------------------------------------------------------------------------------------------------------------------
+  void setEncoding(InstanceRenderer::Encoding _encoding);
+  InstanceRenderer::Encoding encoding() const { return m_encoding; }
+  void setSource(Source _source) { m_source = _source; }
+  Source source() const { return m_source; }
+  static const char *sourceName(Source _source);
+  static Source sourceFromName(std::string_view _name);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the point storage, must be set before initialize
+  //----------------------------------------------------------------------------------------------------------------------
+  void setPointFormat(PointFormat _format) { m_pointFormat = _format; }
+  PointFormat pointFormat() const { return m_pointFormat; }
+  const PointStats &pointStats() const { return m_pointStats; }
+  static const char *pointFormatName(PointFormat _format);
+  static PointFormat pointFormatFromName(std::string_view _name);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the ring used by the Stream source, for the fence statistics / number of regions
+  //----------------------------------------------------------------------------------------------------------------------
+  InstanceStream &stream() { return m_stream; }
+  const InstanceStream &stream() const { return m_stream; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief run the feedback pass
+  /// @param[in] _view the camera view matrix (baked into the output), the identity gives model
+  /// space matrices for multi view drawing and projection * view gives the ModelViewProjection
+  /// (see InstanceRenderer::bakesProjection)
+  /// @param[in] _mouse the global mouse rotation
+  //----------------------------------------------------------------------------------------------------------------------
+  void generate(const ngl::Mat4 &_view, const ngl::Mat4 &_mouse);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief call once all of the draws using chunks() have been issued, fences the stream region
+  //----------------------------------------------------------------------------------------------------------------------
+  void endFrame();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the matrices produced by the last generate, one entry per chunk to be drawn in turn
+  //----------------------------------------------------------------------------------------------------------------------
+  const std::vector<InstanceRenderer::InstanceData> &chunks() const { return m_chunks; }
+
+private:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief quantize m_points into the current format, m_points is replaced by the dequantized
+  /// values so the CPU path sees what the shader sees
+  /// @param[out] o_data the bytes for the point buffer
+  //----------------------------------------------------------------------------------------------------------------------
+  void quantizePoints(std::vector<unsigned char> &o_data);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief create the feedback program for an encoding
+  //----------------------------------------------------------------------------------------------------------------------
+  void createProgram(InstanceRenderer::Encoding _encoding);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the CPU version of shaders/feedback.glsl
+  /// @param[out] o_data where to write the matrices in the current encoding
+  //----------------------------------------------------------------------------------------------------------------------
+  void computeMatrices(float *o_data, const ngl::Mat4 &_view, const ngl::Mat4 &_mouse) const;
+  GLuint m_maxInstances;
+  GLuint m_instances;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief VAO and buffer for the point data, the CPU copy is used by the Stream source
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint m_dataVAO = 0;
+  GLuint m_dataBuffer = 0;
+  std::vector<ngl::Vec3> m_points;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the quantized points from createPoints waiting for uploadPoints
+  //----------------------------------------------------------------------------------------------------------------------
+  std::vector<unsigned char> m_pointData;
+  PointFormat m_pointFormat = PointFormat::Float;
+  PointStats m_pointStats;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief dequantize as pointMin + value * pointScale, 0 and 1 for Float
+  //----------------------------------------------------------------------------------------------------------------------
+  ngl::Vec3 m_pointMin;
+  ngl::Vec3 m_pointScale{1.0f, 1.0f, 1.0f};
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the matrix buffers written by the transform feedback, one per chunk (any extra are kept
+  /// for when the count grows again)
+  //----------------------------------------------------------------------------------------------------------------------
+  std::vector<std::unique_ptr<InstanceBuffer>> m_matrices;
+  bool m_updateBuffer = true;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the instances in each chunk and the chunks of the last generate
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint m_chunkInstances = 0;
+  std::vector<InstanceRenderer::InstanceData> m_chunks;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the ring the Stream source writes to
+  //----------------------------------------------------------------------------------------------------------------------
+  InstanceStream m_stream;
+  Source m_source = Source::Feedback;
+  InstanceRenderer::Encoding m_encoding = InstanceRenderer::Encoding::Mat4;
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef INSTANCELIMITS_H_
+#define INSTANCELIMITS_H_
+#include <ngl/Types.h>
+#include "InstanceRenderer.h"
+#include <iosfwd>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file InstanceLimits.h
+/// @brief the driver limits that bound how many instances can go in one buffer / texture / draw
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class InstanceLimits
+/// @brief the limits are queried once (with a current GL context) and used to split large instance
+/// sets into chunks. A chunk is one matrix buffer that can be attached to a single samplerBuffer
+/// (GL_MAX_TEXTURE_BUFFER_SIZE texels), is no bigger than c_maxChunkBytes (some drivers fail single
+/// allocations of 2GB or more) and starts on a TBO / UBO offset alignment, so every backend can draw
+/// it whole. printReport shows the limits and the chunking chosen for a number of instances.
+//----------------------------------------------------------------------------------------------------------------------
+
+class InstanceLimits
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the largest buffer we allocate for one chunk
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr GLint64 c_maxChunkBytes = GLint64(1) << 30;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the limits for the current context, queried on the first call
+  //----------------------------------------------------------------------------------------------------------------------
+  static const InstanceLimits &get();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the number of instances in each chunk for an encoding (the last chunk holds the rest)
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint chunkInstances(InstanceRenderer::Encoding _encoding) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the most instances a single samplerBuffer can address for an encoding
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint tboInstances(InstanceRenderer::Encoding _encoding) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the most instances one uniform block binding can hold for an encoding, bounded by
+  /// GL_MAX_UNIFORM_BLOCK_SIZE and the vertex uniform storage and rounded down so every batch
+  /// starts on the UBO offset alignment. The UBO shader array is sized from this
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint uboInstances(InstanceRenderer::Encoding _encoding) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the number of chunks needed for a number of instances
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint numChunks(GLuint _instances, InstanceRenderer::Encoding _encoding) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief print the limits and the chunking of both encodings for a number of instances
+  //----------------------------------------------------------------------------------------------------------------------
+  void printReport(std::ostream &_out, GLuint _instances) const;
+
+  GLint majorVersion = 0;
+  GLint minorVersion = 0;
+  GLint maxTextureBufferSize = 0;
+  GLint textureBufferOffsetAlignment = 1;
+  GLint maxUniformBlockSize = 0;
+  GLint uniformBufferOffsetAlignment = 1;
+  GLint maxCombinedVertexUniformComponents = 0;
+  GLint maxVertexAttribs = 0;
+  GLint maxViewports = 1;
+  GLint maxTransformFeedbackInterleavedComponents = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief only queried with GL 4.3, 0 otherwise
+  //----------------------------------------------------------------------------------------------------------------------
+  GLint64 maxShaderStorageBlockSize = 0;
+  GLint maxComputeWorkGroupCount = 0;
+
+private:
+  InstanceLimits() = default;
+  void query();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief round a number of instances down so the next one starts on the TBO and UBO alignments
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint alignedCount(GLint64 _instances, GLuint _stride) const;
+};
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef INSTANCEPOOL_H_
+#define INSTANCEPOOL_H_
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "InstanceStore.h"
+//----------------------------------------------------------------------------------------------------------------------
+/// @file InstancePool.h
+/// @brief dynamic add / remove of instances with stable handles
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class InstancePool
+/// @brief the instances are kept densely packed in an InstanceStore so they can always be drawn with
+/// one instanced draw of size(). Removing swaps the last instance into the hole so only that one
+/// slot is dirtied, a handle indirection table keeps the handles given out by add valid as things
+/// move. Handles carry a generation so a handle to a removed instance is detected (and ignored)
+/// even after its slot has been re-used. add, remove and set are all O(1).
+//----------------------------------------------------------------------------------------------------------------------
+
+class InstancePool
+{
+public:
+  struct Handle
+  {
+    uint32_t slot = std::numeric_limits<uint32_t>::max();
+    uint32_t generation = 0;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ctor
+  /// @param[in] _fullUploadFraction passed on to the InstanceStore
+  //----------------------------------------------------------------------------------------------------------------------
+  explicit InstancePool(float _fullUploadFraction = 0.25f);
+  InstancePool(const InstancePool &) = delete;
+  InstancePool &operator=(const InstancePool &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief add an instance at the end of the packed array
+  //----------------------------------------------------------------------------------------------------------------------
+  Handle add(const ngl::Mat4 &_tx);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief add _count instances in one go, write their matrices through the returned pointer
+  /// @param[out] o_handles receives a handle per instance in packed order
+  //----------------------------------------------------------------------------------------------------------------------
+  ngl::Mat4 *append(size_t _count, Handle *o_handles);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief remove an instance by moving the last one into its place
+  /// @returns false if the handle was not valid
+  //----------------------------------------------------------------------------------------------------------------------
+  bool remove(Handle _handle);
+  bool valid(Handle _handle) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief replace an instance's matrix
+  /// @returns false (and changes nothing) if the handle was not valid
+  //----------------------------------------------------------------------------------------------------------------------
+  bool set(Handle _handle, const ngl::Mat4 &_tx);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief access by handle, the handle must be valid (asserted in debug builds)
+  //----------------------------------------------------------------------------------------------------------------------
+  const ngl::Mat4 &get(Handle _handle) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief where the instance currently is in the packed array (e.g. to match gl_InstanceID)
+  //----------------------------------------------------------------------------------------------------------------------
+  size_t index(Handle _handle) const { return m_slotToIndex[_handle.slot]; }
+  size_t size() const { return m_store.size(); }
+  void reserve(size_t _count);
+  void clear();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the packed data, upload() it each frame before drawing
+  //----------------------------------------------------------------------------------------------------------------------
+  InstanceStore &store() { return m_store; }
+  const InstanceStore &store() const { return m_store; }
+
+private:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief take a free slot or make a new one and point it at the next packed index
+  //----------------------------------------------------------------------------------------------------------------------
+  Handle allocate();
+  InstanceStore m_store;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief handle slot -> packed index and packed index -> handle slot
+  //----------------------------------------------------------------------------------------------------------------------
+  std::vector<uint32_t> m_slotToIndex;
+  std::vector<uint32_t> m_indexToSlot;
+  std::vector<uint32_t> m_generations;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief slots of removed instances ready for re-use
+  //----------------------------------------------------------------------------------------------------------------------
+  std::vector<uint32_t> m_freeSlots;
+};
+
+#endif
@@ -0,0 +1,182 @@
+#ifndef INSTANCERENDERER_H_
+#define INSTANCERENDERER_H_
+#include <ngl/Mat4.h>
+#include "ShaderDefines.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file InstanceRenderer.h
+/// @brief common interface for the different ways of getting per instance matrices to the vertex shader
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class InstanceRenderer
+/// @brief each backend owns its own shader programs and knows how to bind a buffer of matrices
+/// (one per instance) so that the same data can be drawn by any of them. The scene can switch
+/// backend at any time without re-generating the instance data. The matrices can be stored as a
+/// full ngl::Mat4 or as the 3 rows of an affine matrix, each backend has a program for both.
+/// With setViews the matrices are treated as model (world) space and every instance is drawn
+/// once per view in the same instanced draw, the view projections come from a ViewSet and a
+/// geometry shader routes each copy to its viewport / layer (gl_ViewportIndex / gl_Layer).
+//----------------------------------------------------------------------------------------------------------------------
+
+class InstanceRenderer
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the backends we support
+  /// TBO     : matrices fetched from a samplerBuffer using gl_InstanceID
+  /// UBO     : matrices bound in batches with glBindBufferRange to a uniform block
+  /// Divisor : matrices fed as vertex attributes with glVertexAttribDivisor
+  //----------------------------------------------------------------------------------------------------------------------
+  enum class Backend
+  {
+    TBO,
+    UBO,
+    Divisor
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief how the matrices are laid out in the buffer
+  /// Mat4   : a column major ngl::Mat4 (64 bytes)
+  /// Affine : the first 3 rows of the matrix as vec4's (48 bytes), the last row is always 0,0,0,1
+  //----------------------------------------------------------------------------------------------------------------------
+  enum class Encoding
+  {
+    Mat4,
+    Affine
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief which program variant to draw with
+  /// Colour : the full shader, textured
+  /// Depth  : position only (the vertex shader is built with DEPTH_ONLY and the fragment shader is
+  ///          empty) for a depth pre-pass, gl_Position is invariant so a following Colour pass can
+  ///          depth test with GL_EQUAL
+  //----------------------------------------------------------------------------------------------------------------------
+  enum class Pass
+  {
+    Colour,
+    Depth
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the instance matrices to draw, generation must change each time the buffer storage
+  /// is re-allocated so backends that attach to the store (TBO) know to re-attach. The data starts
+  /// at offset bytes into the buffer which must be a multiple of the TBO / UBO offset alignment
+  //----------------------------------------------------------------------------------------------------------------------
+  struct InstanceData
+  {
+    GLuint buffer = 0;
+    GLintptr offset = 0;
+    GLuint count = 0;
+    uint32_t generation = 0;
+    Encoding encoding = Encoding::Mat4;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the mesh to draw for each instance, the VAO must have the position at attribute 0
+  /// and the UV at attribute 1
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Mesh
+  {
+    GLuint vao = 0;
+    GLsizei numVerts = 0;
+  };
+  virtual ~InstanceRenderer() = default;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief create the shaders etc, must be called with a valid GL context
+  //----------------------------------------------------------------------------------------------------------------------
+  virtual void initialize() = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draw all of the instances, the texture to use must be bound to unit 1
+  /// @param[in] _mesh the mesh to draw
+  /// @param[in] _data the per instance matrices (ModelView, ModelViewProjection if bakesProjection)
+  /// @param[in] _project the projection matrix, not used if it is baked into the matrices
+  /// @param[in] _pass the program variant to use
+  //----------------------------------------------------------------------------------------------------------------------
+  virtual void draw(const Mesh &_mesh, const InstanceData &_data, const ngl::Mat4 &_project, Pass _pass = Pass::Colour) = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief which backend this is
+  //----------------------------------------------------------------------------------------------------------------------
+  virtual Backend backend() const = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief create a backend
+  //----------------------------------------------------------------------------------------------------------------------
+  static std::unique_ptr<InstanceRenderer> create(Backend _backend);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief helpers for the overlay / command line
+  //----------------------------------------------------------------------------------------------------------------------
+  static const char *backendName(Backend _backend);
+  static Backend backendFromName(std::string_view _name);
+  static const char *encodingName(Encoding _encoding);
+  static Encoding encodingFromName(std::string_view _name);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the size in bytes of one instance in the buffer
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr GLuint stride(Encoding _encoding) { return _encoding == Encoding::Affine ? 48 : 64; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief true if the matrices for this encoding / view mode must already include the projection.
+  /// A Mat4 can hold the full ModelViewProjection so the generator multiplies it in once per
+  /// instance and the vertex shader does a single matrix vector multiply, an Affine matrix can't
+  /// hold a projection and multi view needs model space matrices so those apply it per vertex
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr bool bakesProjection(Encoding _encoding, bool _multiView) { return _encoding == Encoding::Mat4 && !_multiView; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the defines shared by every program variant, MATRIX_AFFINE for the affine encoding,
+  /// DEPTH_ONLY for the depth pass, MULTI_VIEW / MAX_VIEWS for multi view and MATRIX_PROJECTED if
+  /// bakesProjection, this lets one file hold all of the variants
+  //----------------------------------------------------------------------------------------------------------------------
+  static ShaderDefines shaderDefines(Encoding _encoding, Pass _pass = Pass::Colour, bool _multiView = false);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief read a shader source file with the shaderDefines added after the #version line
+  /// @returns the source to give to the ProgramCache
+  //----------------------------------------------------------------------------------------------------------------------
+  static std::string shaderSource(std::string_view _file, Encoding _encoding, Pass _pass = Pass::Colour, bool _multiView = false);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the ShaderLib name of a program for a given encoding / pass / view mode
+  //----------------------------------------------------------------------------------------------------------------------
+  static std::string programName(std::string_view _name, Encoding _encoding, Pass _pass = Pass::Colour, bool _multiView = false);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draw every instance once per view (0 for the normal single view with the view baked
+  /// into the matrices), the ViewSet must be bound when drawing
+  //----------------------------------------------------------------------------------------------------------------------
+  void setViews(GLuint _views) { m_views = _views; }
+  GLuint views() const { return m_views; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the texture unit the backends expect the colour texture on
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr GLint c_textureUnit = 1;
+
+protected:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief build a program from a backend vertex shader and the common fragment shader through
+  /// the ProgramCache, the vertex and geometry shaders get the shaderDefines, BACKEND_<name> and
+  /// anything the backend adds in addDefines
+  /// @param[in] _name the name of the program in the ShaderLib, see programName
+  /// @param[in] _vertex the vertex shader file
+  /// @param[in] _encoding the matrix encoding the program reads
+  /// @param[in] _pass the pass, the Depth pass uses an empty fragment shader
+  /// @param[in] _multiView add the multi view geometry shader and bind the view block
+  //----------------------------------------------------------------------------------------------------------------------
+  void createProgram(std::string_view _name, std::string_view _vertex, Encoding _encoding, Pass _pass, bool _multiView) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief add backend specific defines (e.g. sizes from the driver limits) for an encoding
+  //----------------------------------------------------------------------------------------------------------------------
+  virtual void addDefines(ShaderDefines &, Encoding) const {}
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief use the program for the data / pass / current view mode and set the projection or
+  /// number of views
+  /// @returns the name of the program
+  //----------------------------------------------------------------------------------------------------------------------
+  std::string useProgram(std::string_view _name, const InstanceData &_data, const ngl::Mat4 &_project, Pass _pass) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief both passes for iterating over the programs
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr Pass c_passes[2] = {Pass::Colour, Pass::Depth};
+  static constexpr bool c_viewModes[2] = {false, true};
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the number of views, 0 for single view
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint m_views = 0;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef INSTANCESTORE_H_
+#define INSTANCESTORE_H_
+#include <ngl/Mat4.h>
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include <vector>
+#include "InstanceBuffer.h"
+//----------------------------------------------------------------------------------------------------------------------
+/// @file InstanceStore.h
+/// @brief CPU side instance matrices mirrored to a GL buffer with dirty range uploads
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class InstanceStore
+/// @brief keeps a ngl::Mat4 per instance on the CPU and records which index ranges have been
+/// modified since the last upload. upload() sorts and coalesces the ranges (small gaps are merged
+/// as one bigger glBufferSubData is cheaper than several small ones) and only sends those, unless
+/// more than the full upload fraction of the store is dirty in which case it is sent in one go.
+/// This suits a few hundred changes a frame out of hundreds of thousands of instances.
+//----------------------------------------------------------------------------------------------------------------------
+
+class InstanceStore
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief upload statistics, last* are for the most recent upload
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Stats
+  {
+    uint64_t uploads = 0;
+    uint64_t fullUploads = 0;
+    uint64_t ranges = 0;
+    uint64_t bytes = 0;
+    size_t lastRanges = 0;
+    size_t lastBytes = 0;
+    bool lastFull = false;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ranges closer than this (in instances) are merged into one upload
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr size_t c_mergeGap = 4;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ctor, no GL calls are made until the first upload
+  /// @param[in] _fullUploadFraction re-upload everything once this fraction of the store is dirty
+  //----------------------------------------------------------------------------------------------------------------------
+  explicit InstanceStore(float _fullUploadFraction = 0.25f);
+  ~InstanceStore();
+  InstanceStore(const InstanceStore &) = delete;
+  InstanceStore &operator=(const InstanceStore &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief change the number of instances, everything is marked dirty
+  //----------------------------------------------------------------------------------------------------------------------
+  void resize(size_t _count);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief append an instance, only the new one is marked dirty
+  //----------------------------------------------------------------------------------------------------------------------
+  void push_back(const ngl::Mat4 &_tx);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief drop the last instance, nothing is marked dirty as the GPU copy is just drawn shorter
+  //----------------------------------------------------------------------------------------------------------------------
+  void pop_back();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief append _count instances to be filled in through the returned pointer, only the new
+  /// range is marked dirty
+  //----------------------------------------------------------------------------------------------------------------------
+  ngl::Mat4 *append(size_t _count);
+  void reserve(size_t _count) { m_data.reserve(_count); }
+  size_t size() const { return m_data.size(); }
+  const ngl::Mat4 &operator[](size_t _index) const { return m_data[_index]; }
+  const ngl::Mat4 *data() const { return m_data.data(); }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief set one instance and mark it dirty
+  //----------------------------------------------------------------------------------------------------------------------
+  void set(size_t _index, const ngl::Mat4 &_tx);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief write access to a range, the range is marked dirty
+  //----------------------------------------------------------------------------------------------------------------------
+  ngl::Mat4 *modify(size_t _first, size_t _count);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief record a modified range
+  //----------------------------------------------------------------------------------------------------------------------
+  void markDirty(size_t _first, size_t _count);
+  void markAllDirty();
+  void setFullUploadFraction(float _fraction) { m_fullUploadFraction = _fraction; }
+  float fullUploadFraction() const { return m_fullUploadFraction; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief send the dirty ranges to the GPU, call once per frame before drawing
+  /// @returns true if anything was uploaded
+  //----------------------------------------------------------------------------------------------------------------------
+  bool upload();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the GL buffer, generation changes when it is re-allocated
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint id() const { return m_buffer.id(); }
+  uint32_t generation() const { return m_buffer.generation(); }
+  const Stats &stats() const { return m_stats; }
+  void printSummary(std::ostream &_out) const;
+
+private:
+  std::vector<ngl::Mat4> m_data;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief dirty [first, end) ranges in the order they were marked
+  //----------------------------------------------------------------------------------------------------------------------
+  std::vector<std::pair<size_t, size_t>> m_dirty;
+  bool m_allDirty = true;
+  float m_fullUploadFraction;
+  InstanceBuffer m_buffer;
+  Stats m_stats;
+};
+
+#endif
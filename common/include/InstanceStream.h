@@ -0,0 +1,98 @@
+#ifndef INSTANCESTREAM_H_
+#define INSTANCESTREAM_H_
+#include <ngl/Types.h>
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "FenceWaitStats.h"
+//----------------------------------------------------------------------------------------------------------------------
+/// @file InstanceStream.h
+/// @brief a persistent mapped ring buffer for instance data written by the CPU every frame
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class InstanceStream
+/// @brief the buffer is split into N regions (3 by default) and mapped once with
+/// GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT. Each frame the CPU writes the next region while the
+/// GPU is still drawing from the previous ones (so with 3 regions we write frame N+2 while frame N is
+/// drawn). A fence is placed after the draws that read a region and waited on before it is written
+/// again, the time spent waiting is recorded (FenceWaitStats) so we can see if the ring is deep enough.
+/// Without GL 4.4 / ARB_buffer_storage it falls back to orphaning the buffer and glBufferSubData.
+/// Usage each frame : ptr=map(bytes), write, unmap(), draw from id() / offset(), fence()
+//----------------------------------------------------------------------------------------------------------------------
+
+class InstanceStream
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief fence wait statistics
+  //----------------------------------------------------------------------------------------------------------------------
+  using Stats = FenceWaitStats::Stats;
+  static constexpr GLuint c_maxRegions = 8;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ctor, no GL calls are made until the first map
+  /// @param[in] _regions the number of frames of ring space (clamped to 1 - c_maxRegions)
+  //----------------------------------------------------------------------------------------------------------------------
+  explicit InstanceStream(GLuint _regions = 3);
+  ~InstanceStream();
+  InstanceStream(const InstanceStream &) = delete;
+  InstanceStream &operator=(const InstanceStream &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief change the number of regions, the buffer is re-created on the next map
+  //----------------------------------------------------------------------------------------------------------------------
+  void setRegions(GLuint _regions);
+  GLuint regions() const { return m_regions; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief move to the next region, waiting for the GPU to be done with it
+  /// @param[in] _bytes the amount of data to be written, the regions grow if needed
+  /// @returns where to write the data
+  //----------------------------------------------------------------------------------------------------------------------
+  void *map(GLsizeiptr _bytes);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief done writing, this is a no-op for the persistent mapping (it is coherent)
+  //----------------------------------------------------------------------------------------------------------------------
+  void unmap();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief place the fence for the current region, call after the draws that read it
+  //----------------------------------------------------------------------------------------------------------------------
+  void fence();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the buffer and byte offset of the current region
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint id() const { return m_id; }
+  GLintptr offset() const { return m_persistent ? static_cast<GLintptr>(m_current) * m_regionSize : 0; }
+  uint32_t generation() const { return m_generation; }
+  bool persistent() const { return m_persistent; }
+  const Stats &stats() const { return m_waits.stats(); }
+  void resetStats() { m_waits.reset(); }
+  void printSummary(std::ostream &_out) const;
+
+private:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief (re)create the buffer with regions of at least _bytes
+  //----------------------------------------------------------------------------------------------------------------------
+  void allocate(GLsizeiptr _bytes);
+  void release();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief wait for the fence on a region and delete it
+  //----------------------------------------------------------------------------------------------------------------------
+  void wait(GLuint _region);
+  GLuint m_regions;
+  GLuint m_current = 0;
+  GLuint m_id = 0;
+  GLsizeiptr m_regionSize = 0;
+  GLsizeiptr m_writeSize = 0;
+  uint32_t m_generation = 0;
+  bool m_persistent = false;
+  bool m_reallocate = false;
+  char *m_mapped = nullptr;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief used by the fallback path
+  //----------------------------------------------------------------------------------------------------------------------
+  std::vector<char> m_staging;
+  std::array<GLsync, c_maxRegions> m_fences = {};
+  FenceWaitStats m_waits;
+};
+
+#endif
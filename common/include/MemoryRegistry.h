@@ -0,0 +1,114 @@
+#ifndef MEMORYREGISTRY_H_
+#define MEMORYREGISTRY_H_
+#include <ngl/Types.h>
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file MemoryRegistry.h
+/// @brief accounting of the GPU and large CPU allocations of a demo
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class MemoryRegistry
+/// @brief every GL buffer / texture allocation and large CPU staging buffer reports its size here
+/// against an owner (the object that holds it) and a category, so we can see where the memory of a
+/// process goes. The current and peak bytes are kept per category and per pool (GPU / CPU), the
+/// driver's own view is added from GL_NVX_gpu_memory_info or GL_ATI_meminfo when present.
+/// Usage : set(category, this, bytes) on each (re)allocation and release(this) in the dtor
+//----------------------------------------------------------------------------------------------------------------------
+
+class MemoryRegistry
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief what the memory is used for, all but CpuStaging are in the GPU pool
+  //----------------------------------------------------------------------------------------------------------------------
+  enum class Category
+  {
+    Points,
+    Matrices,
+    Stream,
+    Culling,
+    Textures,
+    Meshes,
+    Text,
+    Uniforms,
+    CpuStaging
+  };
+  static constexpr size_t c_numCategories = 9;
+  enum class Pool
+  {
+    GPU,
+    CPU
+  };
+  struct Usage
+  {
+    int64_t current = 0;
+    int64_t peak = 0;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief what the driver reports, the values are in KB and -1 if not known
+  //----------------------------------------------------------------------------------------------------------------------
+  struct DriverMemory
+  {
+    const char *source = "none";
+    int64_t totalKB = -1;
+    int64_t availableKB = -1;
+  };
+  MemoryRegistry() = default;
+  MemoryRegistry(const MemoryRegistry &) = delete;
+  MemoryRegistry &operator=(const MemoryRegistry &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the registry used by all of the common classes
+  //----------------------------------------------------------------------------------------------------------------------
+  static MemoryRegistry &shared();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief set the bytes an owner holds in a category (replacing any previous size, 0 removes it)
+  //----------------------------------------------------------------------------------------------------------------------
+  void set(Category _category, const void *_owner, int64_t _bytes);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief remove everything an owner holds
+  //----------------------------------------------------------------------------------------------------------------------
+  void release(const void *_owner);
+  Usage usage(Category _category) const;
+  Usage usage(Pool _pool) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief query the driver, needs a current GL context
+  //----------------------------------------------------------------------------------------------------------------------
+  static DriverMemory driverMemory();
+  static const char *categoryName(Category _category);
+  static Pool pool(Category _category) { return _category == Category::CpuStaging ? Pool::CPU : Pool::GPU; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the size of a 2D texture with a number of mip levels (0 for a full chain)
+  //----------------------------------------------------------------------------------------------------------------------
+  static int64_t textureBytes(GLsizei _width, GLsizei _height, int _bytesPerTexel, int _levels = 1);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief an estimate of an ngl::Text font, it doesn't expose its glyph textures so this assumes
+  /// one power of 2 RGBA texture per printable ASCII character
+  //----------------------------------------------------------------------------------------------------------------------
+  static int64_t textBytes(int _fontSize);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a human readable table and a JSON object of all of the categories / pools, the driver
+  /// values are only added if _driver is given (they need the GL context)
+  //----------------------------------------------------------------------------------------------------------------------
+  void printSummary(std::ostream &_out) const;
+  void writeJson(std::ostream &_out, const DriverMemory *_driver = nullptr) const;
+  bool writeJson(const std::string &_fileName, const DriverMemory *_driver = nullptr) const;
+
+private:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief add a change to a category and its pool, updating the peaks
+  //----------------------------------------------------------------------------------------------------------------------
+  void apply(Category _category, int64_t _delta);
+  mutable std::mutex m_mutex;
+  std::map<std::pair<const void *, Category>, int64_t> m_entries;
+  std::array<Usage, c_numCategories> m_categories = {};
+  std::array<Usage, 2> m_pools = {};
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef POISSONDISK_H_
+#define POISSONDISK_H_
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file PoissonDisk.h
+/// @brief multi-threaded Poisson-disk placement of instances over a square
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class PoissonDisk
+/// @brief places instances on the XZ plane so no two are closer than a minimum distance, which
+/// avoids the clumps and overlaps of uniform random positions. The square is covered by a grid of
+/// cells r / sqrt(2) across (so each cell holds at most one point) and the cells are grouped into
+/// tiles. Each tile throws darts into its cells in a random order and keeps the ones that are not
+/// within r of a point already placed. Tiles that share an edge or corner are never run at the
+/// same time: the tiles are split into four phases by the parity of their x / z index and the
+/// tiles in one phase run in parallel on the shared WorkerPool, so a tile can read its neighbours'
+/// cells without locking and points across a tile boundary are still kept apart. Each tile has
+/// its own CounterRandom sequence indexed by the tile so the result is the same for any thread count.
+/// A density map thins the cells (1 is fully packed, 0 is a clearing) and each instance gets a
+/// random uniform scale. The radius is worked out from the count wanted and the surplus points
+/// are thinned away so exactly that many are written, straight into the instance matrices.
+//----------------------------------------------------------------------------------------------------------------------
+
+class PoissonDisk
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief what to place and where
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Settings
+  {
+    size_t count = 0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the points cover [-extent, extent] in x and z at y = 0
+    //----------------------------------------------------------------------------------------------------------------------
+    float extent = 540.0f;
+    float minScale = 0.5f;
+    float maxScale = 2.5f;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief darts thrown at each cell before it is left empty
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned attempts = 8;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the tiles are tileCells x tileCells grid cells, at least 2 so only neighbouring
+    /// tiles are ever read
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned tileCells = 32;
+    uint32_t seed = 1234;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief densityWidth x densityHeight values in [0, 1] stretched over the square (row 0 at
+    /// -extent z), sampled bilinearly at each cell, empty means fully packed everywhere
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<float> density;
+    size_t densityWidth = 0;
+    size_t densityHeight = 0;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief what the last generate did
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Stats
+  {
+    size_t placed = 0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief points found before thinning down to the count
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t sampled = 0;
+    size_t tiles = 0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the minimum distance between points and how many radii were tried to get enough
+    //----------------------------------------------------------------------------------------------------------------------
+    float radius = 0.0f;
+    unsigned passes = 0;
+    double sampleMs = 0.0;
+    double writeMs = 0.0;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief place _settings.count instances
+  /// @param[out] o_matrices 16 floats (a translate * scale ngl::Mat4) per instance
+  /// @returns placed is the number written, only less than the count if it can't be reached even
+  /// with a small radius (e.g. the density map is nearly all zero)
+  //----------------------------------------------------------------------------------------------------------------------
+  static Stats generate(const Settings &_settings, float *o_matrices);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a _size x _size smooth value noise map with clearings, for Settings::density
+  //----------------------------------------------------------------------------------------------------------------------
+  static std::vector<float> clearings(size_t _size, uint32_t _seed);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief time generate for _count instances and check the spacing, CPU only
+  //----------------------------------------------------------------------------------------------------------------------
+  static void benchmark(std::ostream &_out, size_t _count);
+};
+
+#endif
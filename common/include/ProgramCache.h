@@ -0,0 +1,149 @@
+#ifndef PROGRAMCACHE_H_
+#define PROGRAMCACHE_H_
+#include <ngl/ShaderLib.h>
+#include "ShaderDefines.h"
+#include <map>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file ProgramCache.h
+/// @brief an on disk cache of linked GL program binaries
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class ProgramCache
+/// @brief builds the ngl::ShaderLib programs from their full source text. The first build compiles
+/// and links as usual and stores glGetProgramBinary in the cache directory, later runs create the
+/// program and load it with glProgramBinary instead. The file name is a hash of the sources, the
+/// feedback varyings / attribute bindings and the GL vendor / renderer / version so any change
+/// (or a driver update) is a miss, a binary the driver rejects falls back to compiling. The
+/// compile time is stored with each binary so the summary can report the startup time saved.
+/// Within a run each variant (program name plus define set) is only built once, asking for it
+/// again makes it current or puts its binary back if another define set of the name replaced it.
+/// Needs GL 4.1 (or ARB_get_program_binary) and a driver with at least one binary format,
+/// otherwise everything is compiled.
+//----------------------------------------------------------------------------------------------------------------------
+
+class ProgramCache
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief one shader of a program, the ShaderLib name is the program name plus the stage name
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Stage
+  {
+    ngl::ShaderType type;
+    std::string source;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief everything that goes into the link
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Program
+  {
+    std::string name;
+    std::vector<Stage> stages;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief transform feedback outputs, recorded GL_INTERLEAVED_ATTRIBS
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<std::string> varyings;
+    std::vector<std::pair<GLuint, std::string>> attributes;
+  };
+  struct Stats
+  {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t rejected = 0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief builds of a variant that already existed
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t reused = 0;
+    double loadMs = 0.0;
+    double compileMs = 0.0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief what the hits took to compile when they were stored
+    //----------------------------------------------------------------------------------------------------------------------
+    double hitCompileMs = 0.0;
+  };
+  ProgramCache() = default;
+  ProgramCache(const ProgramCache &) = delete;
+  ProgramCache &operator=(const ProgramCache &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the cache used by all of the common classes
+  //----------------------------------------------------------------------------------------------------------------------
+  static ProgramCache &shared();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief turn the cache off (always compile) or change where the binaries go
+  //----------------------------------------------------------------------------------------------------------------------
+  void setEnabled(bool _enabled) { m_enabled = _enabled; }
+  void setDirectory(std::string _directory) { m_directory = std::move(_directory); }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief load or compile / link a program, it is left in use with its uniforms registered
+  /// @returns false if the same variant was already built this run and has just been made current
+  //----------------------------------------------------------------------------------------------------------------------
+  bool build(const Program &_program);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief read a shader file adding _defines straight after the #version line, a line
+  /// #include "file" is replaced by that file (from the same directory) as GLSL has no includes
+  //----------------------------------------------------------------------------------------------------------------------
+  static std::string readSource(std::string_view _file, const std::string &_defines = "");
+  static std::string readSource(std::string_view _file, const ShaderDefines &_defines) { return readSource(_file, _defines.text()); }
+  const Stats &stats() const { return m_stats; }
+  void printSummary(std::ostream &_out) const;
+
+private:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief true if the context can save / load binaries, queried once
+  //----------------------------------------------------------------------------------------------------------------------
+  static bool binariesSupported();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the GL vendor / renderer / version, queried once
+  //----------------------------------------------------------------------------------------------------------------------
+  static const std::string &driverString();
+  static uint64_t hash(const Program &_program);
+  std::string fileName(const Program &_program, uint64_t _key) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief try to load the binary into the program
+  /// @returns false on a miss or if the driver rejects it
+  //----------------------------------------------------------------------------------------------------------------------
+  bool load(GLuint _id, const std::string &_file, uint64_t _key);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a linked program binary kept for the rest of the run
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Variant
+  {
+    GLenum format = 0;
+    std::vector<char> binary;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief read the linked binary back from the driver
+  /// @returns false if there is none
+  //----------------------------------------------------------------------------------------------------------------------
+  static bool binary(GLuint _id, Variant &o_variant);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief load a variant built earlier this run
+  /// @returns false if it has no binary or the driver rejects it
+  //----------------------------------------------------------------------------------------------------------------------
+  static bool restore(GLuint _id, const Variant &_variant);
+  void save(const Variant &_variant, const std::string &_file, uint64_t _key, float _compileMs) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the normal ShaderLib compile and link
+  //----------------------------------------------------------------------------------------------------------------------
+  static void compile(const Program &_program, GLuint _id, bool _retrievable);
+  bool m_enabled = true;
+  std::string m_directory = "programcache";
+  Stats m_stats;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the key of the variant each ShaderLib name holds now
+  //----------------------------------------------------------------------------------------------------------------------
+  std::map<std::string, uint64_t> m_current;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief every variant built this run by ShaderLib name and key (sources, so define set, included)
+  //----------------------------------------------------------------------------------------------------------------------
+  std::map<std::pair<std::string, uint64_t>, Variant> m_variants;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef RADIXSORT_H_
+#define RADIXSORT_H_
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "WorkerPool.h"
+//----------------------------------------------------------------------------------------------------------------------
+/// @file RadixSort.h
+/// @brief a parallel LSD radix sort of 32 bit key / value pairs
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class RadixSort
+/// @brief sorts by 8 bits at a time, each pass the keys are split into one chunk per thread which is
+/// counted in parallel, the counts are turned into per chunk offsets and then each chunk scatters
+/// its keys in parallel, so the sort is stable. Passes where every key has the same digit are skipped
+/// (e.g. the high bits of small distances). The scratch buffers are kept between calls.
+//----------------------------------------------------------------------------------------------------------------------
+
+class RadixSort
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief sort the pairs by ascending key
+  /// @param[in,out] io_keys the keys, sorted on return
+  /// @param[in,out] io_values the values (same size as the keys), in key order on return
+  /// @param[in] _pool the threads to use
+  //----------------------------------------------------------------------------------------------------------------------
+  void sort(std::vector<uint32_t> &io_keys, std::vector<uint32_t> &io_values, WorkerPool &_pool);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a positive float as a key that sorts in the same order
+  //----------------------------------------------------------------------------------------------------------------------
+  static uint32_t floatKey(float _value);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief below this many keys per thread it is quicker to use fewer threads
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr size_t c_minPerTask = 16384;
+
+private:
+  using Histogram = std::array<uint32_t, 256>;
+  std::vector<uint32_t> m_keys;
+  std::vector<uint32_t> m_values;
+  std::vector<Histogram> m_histograms;
+};
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef RENDERSCHEDULER_H_
+#define RENDERSCHEDULER_H_
+#include <QOpenGLWindow>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <ostream>
+#include <string_view>
+#include "FrameStats.h"
+//----------------------------------------------------------------------------------------------------------------------
+/// @file RenderScheduler.h
+/// @brief decides when the demos re-draw, replaces the old startTimer(0) busy loop
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class RenderScheduler
+/// @brief drives re-draws of a QOpenGLWindow in one of three modes
+/// Continuous : a new frame is requested each time the last one is presented (frameSwapped) so
+///              we are paced by vsync
+/// OnDemand   : only re-draw when input or animation has marked the scene dirty, idle costs no CPU
+/// Benchmark  : as Continuous but the surface is created with a swap interval of 0 so we are uncapped
+/// It also measures process CPU utilisation and frame pacing so the modes can be compared.
+//----------------------------------------------------------------------------------------------------------------------
+
+class RenderScheduler
+{
+public:
+  enum class Mode
+  {
+    Continuous,
+    OnDemand,
+    Benchmark
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief CPU and pacing stats measured over the last second of presented frames
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Report
+  {
+    float fps = 0.0f;
+    float cpuPercent = 0.0f;
+    float intervalMs = 0.0f;
+    float jitterMs = 0.0f;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ctor
+  /// @param[in] _window the window to schedule, we connect to its frameSwapped signal
+  /// @param[in] _stats the frame stats to tick each frame
+  /// @param[in] _mode the initial mode
+  //----------------------------------------------------------------------------------------------------------------------
+  RenderScheduler(QOpenGLWindow *_window, FrameStats *_stats, Mode _mode = Mode::Continuous);
+  ~RenderScheduler();
+  RenderScheduler(const RenderScheduler &) = delete;
+  RenderScheduler &operator=(const RenderScheduler &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief change mode, note Benchmark needs the swap interval set before the window is shown
+  //----------------------------------------------------------------------------------------------------------------------
+  void setMode(Mode _mode);
+  Mode mode() const { return m_mode; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief switch to OnDemand and back to the last other mode, the swap interval is fixed when the
+  /// window is shown so a window started in Benchmark goes back to Benchmark, not an uncapped Continuous
+  //----------------------------------------------------------------------------------------------------------------------
+  void toggleOnDemand();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief request a new frame, use this instead of update() from input handlers
+  //----------------------------------------------------------------------------------------------------------------------
+  void markDirty();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief in OnDemand mode keep re-drawing while something is animating
+  //----------------------------------------------------------------------------------------------------------------------
+  void setAnimating(bool _animating);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief call at the start of paintGL, ticks the frame stats (ignoring any idle gap)
+  //----------------------------------------------------------------------------------------------------------------------
+  void beginFrame();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the last complete measurement window
+  //----------------------------------------------------------------------------------------------------------------------
+  Report report() const { return m_report; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief print the CPU usage over the whole run
+  //----------------------------------------------------------------------------------------------------------------------
+  void printSummary(std::ostream &_out) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief helpers for the command line
+  //----------------------------------------------------------------------------------------------------------------------
+  static const char *modeName(Mode _mode);
+  static Mode modeFromName(std::string_view _name);
+  static int swapInterval(Mode _mode);
+
+private:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief called from the frameSwapped signal
+  //----------------------------------------------------------------------------------------------------------------------
+  void frameSwapped();
+  using Clock = std::chrono::steady_clock;
+  QOpenGLWindow *m_window;
+  FrameStats *m_stats;
+  Mode m_mode;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the mode toggleOnDemand goes back to
+  //----------------------------------------------------------------------------------------------------------------------
+  Mode m_resumeMode = Mode::Continuous;
+  QMetaObject::Connection m_connection;
+  bool m_dirty = true;
+  bool m_animating = false;
+  bool m_idle = false;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief accumulators for the current measurement window
+  //----------------------------------------------------------------------------------------------------------------------
+  Clock::time_point m_windowStart;
+  Clock::time_point m_lastSwap;
+  std::clock_t m_windowCPU;
+  uint32_t m_windowFrames = 0;
+  double m_intervalSum = 0.0;
+  double m_intervalSumSq = 0.0;
+  Report m_report;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief start of the run for the summary
+  //----------------------------------------------------------------------------------------------------------------------
+  Clock::time_point m_runStart;
+  std::clock_t m_runCPU;
+  uint64_t m_presented = 0;
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef SHADERDEFINES_H_
+#define SHADERDEFINES_H_
+#include <map>
+#include <string>
+#include <string_view>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file ShaderDefines.h
+/// @brief the #defines a shader variant is built with
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class ShaderDefines
+/// @brief a set of #define name value pairs worked out at run time (driver limits, the chosen
+/// encoding / pass / backend) and injected after the #version line by ProgramCache::readSource. The
+/// names are kept sorted so the same set always gives the same text and so the same program
+/// cache key. Shaders should give a default (#ifndef) for anything that is sized from a limit.
+//----------------------------------------------------------------------------------------------------------------------
+
+class ShaderDefines
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief add or replace a define, an empty value is a plain #define NAME flag
+  //----------------------------------------------------------------------------------------------------------------------
+  ShaderDefines &set(std::string_view _name, std::string_view _value = "");
+  ShaderDefines &set(std::string_view _name, long long _value);
+  bool has(std::string_view _name) const { return m_defines.find(std::string(_name)) != m_defines.end(); }
+  bool empty() const { return m_defines.empty(); }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the #define lines, one per define
+  //----------------------------------------------------------------------------------------------------------------------
+  std::string text() const;
+
+private:
+  std::map<std::string, std::string> m_defines;
+};
+
+#endif
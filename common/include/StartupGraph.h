@@ -0,0 +1,124 @@
+#ifndef STARTUPGRAPH_H_
+#define STARTUPGRAPH_H_
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file StartupGraph.h
+/// @brief runs the start up work as a dependency graph so the window can show frames while it loads
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class StartupGraph
+/// @brief each stage is either CPU work (decoding, parsing, generating) or GL work (compiling,
+/// uploading) and lists the stages it needs. A CPU stage is started on its own thread as soon as
+/// the stages it needs are done, so independent loads overlap. GL stages run on the thread that
+/// calls pump(), the render thread with the context current, a frame's worth at a time so paintGL
+/// can keep drawing a progress frame in between. Every stage records when it became ready, started
+/// and finished, printTrace shows the break down and writeTrace saves it for chrome://tracing.
+/// Jobs must not throw, a CPU job may use WorkerPool::shared() as the render thread doesn't while
+/// the graph is running.
+//----------------------------------------------------------------------------------------------------------------------
+
+class StartupGraph
+{
+public:
+  enum class Kind
+  {
+    Cpu,
+    Gl
+  };
+  using Job = std::function<void()>;
+  StartupGraph();
+  ~StartupGraph();
+  StartupGraph(const StartupGraph &) = delete;
+  StartupGraph &operator=(const StartupGraph &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief add a stage, all stages must be added before the first pump
+  /// @param[in] _needs the ids (returned by add) of the stages that must finish first
+  /// @returns the stage id
+  //----------------------------------------------------------------------------------------------------------------------
+  size_t add(const std::string &_name, Kind _kind, const std::vector<size_t> &_needs, Job _job);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief start any ready CPU stages then run ready GL stages until _budgetMs has been used (at
+  /// least one is run if any are ready)
+  /// @returns true once every stage has finished
+  //----------------------------------------------------------------------------------------------------------------------
+  bool pump(float _budgetMs);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief pump until everything has finished, for when there is nothing to show in between
+  //----------------------------------------------------------------------------------------------------------------------
+  void finish();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief wait for the running CPU stages and start nothing else, for a window closed while loading
+  //----------------------------------------------------------------------------------------------------------------------
+  void cancel();
+  bool finished() const { return m_finished == m_stages.size(); }
+  size_t finishedStages() const { return m_finished; }
+  size_t stages() const { return m_stages.size(); }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the names of the stages running now, for the progress frame
+  //----------------------------------------------------------------------------------------------------------------------
+  std::string running() const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief record when the first (progress) frame was shown, it is part of the trace
+  //----------------------------------------------------------------------------------------------------------------------
+  void markFirstFrame();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ms since the graph was created, the times in the trace are relative to this too
+  //----------------------------------------------------------------------------------------------------------------------
+  float elapsedMs() const;
+  void printTrace(std::ostream &_out) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief write the stages in the Chrome trace event format
+  /// @returns false if the file could not be written
+  //----------------------------------------------------------------------------------------------------------------------
+  bool writeTrace(const std::string &_fileName) const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+  enum class State
+  {
+    Waiting,
+    Running,
+    Done
+  };
+  struct Stage
+  {
+    std::string name;
+    Kind kind = Kind::Cpu;
+    std::vector<size_t> needs;
+    Job job;
+    State state = State::Waiting;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set by the CPU thread once the job has returned
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<bool> complete{false};
+    std::thread thread;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ms since the graph was created, a GL stage can be ready a while before the next
+    /// pump gets to it
+    //----------------------------------------------------------------------------------------------------------------------
+    float readyMs = -1.0f;
+    float startMs = 0.0f;
+    float endMs = 0.0f;
+  };
+  bool ready(const Stage &_stage) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief join finished CPU stages and start any that are now ready
+  //----------------------------------------------------------------------------------------------------------------------
+  void schedule();
+  std::vector<std::unique_ptr<Stage>> m_stages;
+  size_t m_finished = 0;
+  Clock::time_point m_start;
+  float m_firstFrameMs = -1.0f;
+  bool m_cancelled = false;
+};
+
+#endif
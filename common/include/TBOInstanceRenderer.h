@@ -0,0 +1,51 @@
+#ifndef TBOINSTANCERENDERER_H_
+#define TBOINSTANCERENDERER_H_
+#include "InstanceRenderer.h"
+#include <vector>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file TBOInstanceRenderer.h
+/// @brief TBO instancing backend
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class TBOInstanceRenderer
+/// @brief fetches each instance matrix from a samplerBuffer (GL_RGBA32F texels) using gl_InstanceID.
+/// A samplerBuffer can only address GL_MAX_TEXTURE_BUFFER_SIZE texels so larger data is drawn in
+/// several draws, each with its own texture attached to its part of the buffer.
+//----------------------------------------------------------------------------------------------------------------------
+
+class TBOInstanceRenderer : public InstanceRenderer
+{
+public:
+  void initialize() override;
+  void draw(const Mesh &_mesh, const InstanceData &_data, const ngl::Mat4 &_project, Pass _pass = Pass::Colour) override;
+  Backend backend() const override { return Backend::TBO; }
+  ~TBOInstanceRenderer() override;
+
+private:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a texture buffer object and the buffer / generation / offset it is attached to
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Attachment
+  {
+    GLuint texture = 0;
+    GLuint buffer = 0;
+    uint32_t generation = 0;
+    GLintptr offset = 0;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief find the texture attached to a buffer / offset, re-attaching the least recently used one
+  /// if none is
+  /// @param[in] _maxBytes the most to attach, the attachment runs to the end of the store up to this
+  /// @returns the texture to bind
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint attach(GLuint _buffer, uint32_t _generation, GLintptr _offset, GLsizeiptr _maxBytes);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief one texture per chunk of the instance data so a frame of chunks doesn't re-attach, the
+  /// front of the list is the most recently used
+  //----------------------------------------------------------------------------------------------------------------------
+  std::vector<Attachment> m_attachments;
+  static constexpr size_t c_maxAttachments = 16;
+};
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef TILESTREAMER_H_
+#define TILESTREAMER_H_
+#include <ngl/Mat4.h>
+#include <ngl/Vec3.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "InstancePool.h"
+//----------------------------------------------------------------------------------------------------------------------
+/// @file TileStreamer.h
+/// @brief streams square tiles of instances from disk into an InstancePool around the camera
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class TileStreamer
+/// @brief bake() splits a set of instance matrices into tileSize x tileSize squares on the XZ plane
+/// and writes one file per tile (the matrices as they are in the TBO, 16 floats each) plus a
+/// manifest of which tiles exist and how many instances each holds. The manifest also records how
+/// the instances were generated so a bake from other settings is redone rather than streamed. Tiles are keyed by their
+/// integer x / z so the world has no fixed bounds, only the tiles in the manifest are ever read.
+/// Each update() picks the tiles within the load radius of the eye, nearest first, until the GPU
+/// budget is used up, already resident tiles are kept a little further out so they don't flicker
+/// in and out at the edge. Resident tiles that weren't picked are removed from the pool and the
+/// missing ones are queued for a background thread that reads the files, the results are added
+/// to the pool on the next update so all of the GL work stays on the render thread. A tile that
+/// can't be read stays out of the pool and is asked for again after a short wait. The pool only
+/// ever holds the resident tiles so everything drawn from it (culling, sorting) covers just those.
+//----------------------------------------------------------------------------------------------------------------------
+
+class TileStreamer
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief residency and load statistics, the latency is from a tile first being wanted to it
+  /// being added to the pool
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Stats
+  {
+    size_t tiles = 0;
+    size_t resident = 0;
+    size_t residentInstances = 0;
+    int64_t residentBytes = 0;
+    size_t queued = 0;
+    uint64_t loads = 0;
+    uint64_t evictions = 0;
+    uint64_t discarded = 0;
+    uint64_t failures = 0;
+    float lastLatencyMs = 0.0f;
+    float maxLatencyMs = 0.0f;
+    double totalLatencyMs = 0.0;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief what a bake was made from, kept in the manifest
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Generation
+  {
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the instances asked for (fewer may have been placed) and the seed they were placed with
+    //----------------------------------------------------------------------------------------------------------------------
+    uint64_t count = 0;
+    uint32_t seed = 0;
+    float tileSize = 64.0f;
+  };
+  TileStreamer() = default;
+  ~TileStreamer();
+  TileStreamer(const TileStreamer &) = delete;
+  TileStreamer &operator=(const TileStreamer &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief write _count matrices as tiles of _generation.tileSize into _dir (created if needed),
+  /// any tiles from an earlier bake are removed first
+  /// @returns false if a file could not be written
+  //----------------------------------------------------------------------------------------------------------------------
+  static bool bake(const std::string &_dir, const ngl::Mat4 *_matrices, size_t _count, const Generation &_generation);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief true if _dir has a manifest from a bake of the same _generation
+  //----------------------------------------------------------------------------------------------------------------------
+  static bool baked(const std::string &_dir, const Generation &_generation);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief read the manifest and start the loader thread
+  /// @param[in] _radius tiles closer than this to the eye are loaded
+  /// @param[in] _budgetBytes the most instance data to keep in the pool
+  /// @returns false if there is no readable manifest
+  //----------------------------------------------------------------------------------------------------------------------
+  bool start(const std::string &_dir, float _radius, int64_t _budgetBytes);
+  void stop();
+  bool active() const { return m_thread.joinable(); }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief evict / add tiles for the eye (in the space of the matrices), call once per frame
+  /// before io_pool is uploaded
+  /// @returns true if io_pool changed
+  //----------------------------------------------------------------------------------------------------------------------
+  bool update(const ngl::Vec3 &_eye, InstancePool &io_pool);
+  float radius() const { return m_radius; }
+  int64_t budget() const { return m_budget; }
+  const Stats &stats() const { return m_stats; }
+  void printSummary(std::ostream &_out) const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a tile read by the loader thread waiting to be added to the pool
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Loaded
+  {
+    int64_t key;
+    std::vector<ngl::Mat4> matrices;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the file was missing, truncated or didn't match the manifest
+    //----------------------------------------------------------------------------------------------------------------------
+    bool failed = false;
+  };
+  static int64_t key(int32_t _x, int32_t _z) { return static_cast<int64_t>((static_cast<uint64_t>(static_cast<uint32_t>(_x)) << 32) | static_cast<uint32_t>(_z)); }
+  static std::string tileFile(const std::string &_dir, int64_t _key);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the loader thread, reads queued tiles until stopped
+  //----------------------------------------------------------------------------------------------------------------------
+  void loop();
+  void evict(int64_t _key, InstancePool &io_pool);
+  std::string m_dir;
+  float m_tileSize = 64.0f;
+  float m_radius = 300.0f;
+  int64_t m_budget = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief instances per tile from the manifest
+  //----------------------------------------------------------------------------------------------------------------------
+  std::unordered_map<int64_t, uint32_t> m_counts;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief render thread only, the pool handles of each resident tile and when each wanted tile
+  /// was first asked for
+  //----------------------------------------------------------------------------------------------------------------------
+  std::unordered_map<int64_t, std::vector<InstancePool::Handle>> m_resident;
+  std::unordered_map<int64_t, Clock::time_point> m_wanted;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief render thread only, when each tile that couldn't be read last failed
+  //----------------------------------------------------------------------------------------------------------------------
+  std::unordered_map<int64_t, Clock::time_point> m_failed;
+  Stats m_stats;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief shared with the loader thread, the queue is nearest first and replaced every update
+  //----------------------------------------------------------------------------------------------------------------------
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::vector<int64_t> m_queue;
+  std::unordered_set<int64_t> m_loading;
+  std::vector<Loaded> m_loaded;
+  bool m_stop = false;
+  std::thread m_thread;
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef UBOINSTANCERENDERER_H_
+#define UBOINSTANCERENDERER_H_
+#include "InstanceRenderer.h"
+//----------------------------------------------------------------------------------------------------------------------
+/// @file UBOInstanceRenderer.h
+/// @brief UBO instancing backend
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class UBOInstanceRenderer
+/// @brief binds the matrices in batches to a uniform block using glBindBufferRange, the batch size
+/// is limited by GL_MAX_UNIFORM_BLOCK_SIZE and each batch must start on GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+/// The shader array is sized to the batch (INSTANCES_PER_BLOCK) when the programs are built
+//----------------------------------------------------------------------------------------------------------------------
+
+class UBOInstanceRenderer : public InstanceRenderer
+{
+public:
+  void initialize() override;
+  void draw(const Mesh &_mesh, const InstanceData &_data, const ngl::Mat4 &_project, Pass _pass = Pass::Colour) override;
+  Backend backend() const override { return Backend::UBO; }
+
+protected:
+  void addDefines(ShaderDefines &io_defines, Encoding _encoding) const override;
+
+private:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief number of instances we can bind to the uniform block at once, indexed by Encoding
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint m_instancesPerBlock[2] = {0, 0};
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef VIEWSET_H_
+#define VIEWSET_H_
+#include <ngl/Mat4.h>
+#include <array>
+#include <vector>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file ViewSet.h
+/// @brief the views for multi view instanced rendering
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class ViewSet
+/// @brief holds a uniform block of view projection matrices (the Views block in the backend vertex
+/// shaders built with MULTI_VIEW) and a grid of viewports, one per view. The instance matrices are
+/// then model space and the InstanceRenderer draws each instance once per view in one draw.
+/// Usage : layoutGrid() for the target viewport, setViewProjections() each frame, bind() before the draw
+//----------------------------------------------------------------------------------------------------------------------
+
+class ViewSet
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the size of the viewProjection array in the shaders
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr GLuint c_maxViews = 8;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the uniform buffer binding of the Views block
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr GLuint c_binding = 1;
+  ViewSet() = default;
+  ~ViewSet();
+  ViewSet(const ViewSet &) = delete;
+  ViewSet &operator=(const ViewSet &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief create the uniform buffer, must be called with a valid GL context
+  //----------------------------------------------------------------------------------------------------------------------
+  void initialize();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the most views we can draw, limited by the shader array and GL_MAX_VIEWPORTS
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint maxViews() const { return m_maxViews; }
+  GLuint count() const { return m_count; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief split a viewport into a near square grid of viewports
+  /// @param[in] _count the number of views (clamped to maxViews)
+  /// @param[in] _x _y the bottom left of the area in pixels
+  /// @param[in] _width the width of the area in pixels
+  /// @param[in] _height the height of the area in pixels
+  //----------------------------------------------------------------------------------------------------------------------
+  void layoutGrid(GLuint _count, int _x, int _y, int _width, int _height);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the aspect ratio of a view for its projection
+  //----------------------------------------------------------------------------------------------------------------------
+  float aspect(GLuint _view) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief upload the view projection matrix of each view, only the first count() are used
+  //----------------------------------------------------------------------------------------------------------------------
+  void setViewProjections(const std::vector<ngl::Mat4> &_viewProjections);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief bind the uniform block and set the viewports, glViewport will reset them afterwards
+  //----------------------------------------------------------------------------------------------------------------------
+  void bind() const;
+
+private:
+  GLuint m_ubo = 0;
+  GLuint m_maxViews = 1;
+  GLuint m_count = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief x, y, width, height for each view as used by glViewportArrayv
+  //----------------------------------------------------------------------------------------------------------------------
+  std::array<GLfloat, c_maxViews * 4> m_viewports = {};
+};
+
+#endif
@@ -6,44 +6,43 @@ struct WinParams
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief used to store the x rotation mouse value
   //----------------------------------------------------------------------------------------------------------------------
-  int spinXFace=0;
+  int spinXFace = 0;
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief used to store the y rotation mouse value
   //----------------------------------------------------------------------------------------------------------------------
-  int spinYFace=0;
+  int spinYFace = 0;
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief flag to indicate if the mouse button is pressed when dragging
   //----------------------------------------------------------------------------------------------------------------------
-  bool rotate=false;
+  bool rotate = false;
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief flag to indicate if the Right mouse button is pressed when dragging
   //----------------------------------------------------------------------------------------------------------------------
-  bool translate=false;
+  bool translate = false;
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief the previous x mouse value
   //----------------------------------------------------------------------------------------------------------------------
-  int origX=0;
+  int origX = 0;
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief the previous y mouse value
   //----------------------------------------------------------------------------------------------------------------------
-  int origY=0;
+  int origY = 0;
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief the previous x mouse value for Position changes
   //----------------------------------------------------------------------------------------------------------------------
-  int origXPos=0;
+  int origXPos = 0;
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief the previous y mouse value for Position changes
   //----------------------------------------------------------------------------------------------------------------------
-  int origYPos=0;
+  int origYPos = 0;
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief window width
   //----------------------------------------------------------------------------------------------------------------------
-  int width=1024;
+  int width = 1024;
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief window height
   //----------------------------------------------------------------------------------------------------------------------
-  int height=720;
-
+  int height = 720;
 };
 
 #endif
@@ -0,0 +1,68 @@
+#ifndef WORKERPOOL_H_
+#define WORKERPOOL_H_
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file WorkerPool.h
+/// @brief a fixed set of worker threads for splitting per frame CPU work
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// @class WorkerPool
+/// @brief the threads are started once and sleep between jobs so a job costs a wake up rather than
+/// a thread start. run() splits a job into numbered tasks which are handed out to the workers and
+/// the calling thread, it returns once they are all done. Tasks must not throw or call run().
+//----------------------------------------------------------------------------------------------------------------------
+
+class WorkerPool
+{
+public:
+  using Task = std::function<void(size_t _task)>;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ctor
+  /// @param[in] _threads the total number of threads including the caller, 0 uses one per core
+  //----------------------------------------------------------------------------------------------------------------------
+  explicit WorkerPool(size_t _threads = 0);
+  ~WorkerPool();
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief run _task(0) ... _task(_tasks - 1) across the pool and wait for them all
+  //----------------------------------------------------------------------------------------------------------------------
+  void run(size_t _tasks, const Task &_task);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the number of threads work is split across (including the caller)
+  //----------------------------------------------------------------------------------------------------------------------
+  size_t size() const { return m_threads.size() + 1; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a pool with one thread per core shared by everything that runs on the main thread
+  //----------------------------------------------------------------------------------------------------------------------
+  static WorkerPool &shared();
+
+private:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief take tasks from the current job until there are none left
+  //----------------------------------------------------------------------------------------------------------------------
+  void work();
+  void loop();
+  std::vector<std::thread> m_threads;
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the current job, changes to m_generation wake the workers
+  //----------------------------------------------------------------------------------------------------------------------
+  const Task *m_task = nullptr;
+  size_t m_count = 0;
+  std::atomic<size_t> m_next{0};
+  size_t m_busy = 0;
+  uint64_t m_generation = 0;
+  bool m_stop = false;
+};
+
+#endif
@@ -0,0 +1,45 @@
+// Philox4x32-10 counter based random numbers, the same words as CounterRandom::block in
+// common/src/CounterRandom.cpp for the same seed, stream, index and draw. Pulled into a shader
+// with #include "CounterRandom.glsl", which ProgramCache::readSource splices in
+
+// the high and low 32 bits of a * b
+void counterMulHiLo(uint a, uint b, out uint hi, out uint lo)
+{
+#if __VERSION__ >= 400
+	umulExtended(a, b, hi, lo);
+#else
+	// GLSL 3.30 has no 64 bit product so the high half is built from 16 bit pieces
+	uint al = a & 0xffffu;
+	uint ah = a >> 16u;
+	uint bl = b & 0xffffu;
+	uint bh = b >> 16u;
+	uint lolo = al * bl;
+	uint lohi = al * bh;
+	uint hilo = ah * bl;
+	uint mid = (lolo >> 16u) + (lohi & 0xffffu) + (hilo & 0xffffu);
+	hi = ah * bh + (lohi >> 16u) + (hilo >> 16u) + (mid >> 16u);
+	lo = a * b;
+#endif
+}
+
+// key (seed, stream) counter (index, draw, 0, 0)
+uvec4 counterRandom(uint seed, uint stream, uint index, uint draw)
+{
+	uvec4 c = uvec4(index, draw, 0u, 0u);
+	uvec2 k = uvec2(seed, stream);
+	for (int r = 0; r < 10; ++r)
+	{
+		uint hi0, lo0, hi1, lo1;
+		counterMulHiLo(0xD2511F53u, c.x, hi0, lo0);
+		counterMulHiLo(0xCD9E8D57u, c.z, hi1, lo1);
+		c = uvec4(hi1 ^ c.y ^ k.x, lo1, hi0 ^ c.w ^ k.y, lo0);
+		k += uvec2(0x9E3779B9u, 0xBB67AE85u);
+	}
+	return c;
+}
+
+// [0, 1) from the top 24 bits, exact so it matches CounterRandom::unit
+float counterUnit(uint bits)
+{
+	return float(bits >> 8u) * (1.0 / 16777216.0);
+}
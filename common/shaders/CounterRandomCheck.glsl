@@ -0,0 +1,9 @@
+#version 330 core
+// writes the CounterRandom words for each index so CounterRandom::checkGpu can compare them with
+// the CPU, CHECK_SEED, CHECK_STREAM and CHECK_DRAW are defined by the check
+#include "CounterRandom.glsl"
+flat out uvec4 bits;
+void main()
+{
+	bits = counterRandom(uint(CHECK_SEED), uint(CHECK_STREAM), uint(gl_VertexID), uint(CHECK_DRAW));
+}
@@ -0,0 +1,5 @@
+#version 330 core
+// the fragment shader for the depth pre-pass, only the depth is written
+void main()
+{
+}
@@ -0,0 +1,123 @@
+#version 430 core
+// tests the bounds of each instance against the view frustum and the Hi-Z depth pyramid and
+// appends the visible ones to a compacted list, the instance count of the indirect draw command
+// is the append counter so the list can be drawn without reading anything back. With a LOD range
+// the visible instances are also split by distance into a near (mesh) and far (impostor) list.
+// With an order the instances are tested in that order (e.g. sorted front to back) so the lists
+// come out close to it, the appends keep the order the work groups run in
+// the work group size comes from HiZCuller so the dispatch always matches
+#ifndef LOCAL_SIZE
+#define LOCAL_SIZE 64
+#endif
+layout (local_size_x = LOCAL_SIZE) in;
+// the per instance model matrices (4 texels each)
+uniform samplerBuffer instances;
+uniform sampler2D hiz;
+uniform mat4 VP;
+uniform mat4 View;
+// near / far distance of the impostor fade, far <= 0 puts everything in the near list
+uniform vec2 lodRange;
+// the local space bounds of the mesh
+uniform vec3 boundsMin;
+uniform vec3 boundsMax;
+uniform int count;
+uniform int hizLevels;
+// 0 only frustum cull
+uniform int occlusion;
+// the ids to test in order when ordered is not 0, otherwise the invocation is the id
+uniform usamplerBuffer order;
+uniform int ordered;
+
+layout (std430, binding = 0) writeonly buffer Visible
+{
+	uint ids[];
+};
+// the first 4 are a DrawArraysIndirectCommand
+layout (std430, binding = 1) buffer Command
+{
+	uint vertexCount;
+	uint instanceCount;
+	uint first;
+	uint baseInstance;
+	uint frustumCulled;
+	uint occluded;
+	uint farVertexCount;
+	uint farInstanceCount;
+	uint farFirst;
+	uint farBaseInstance;
+};
+layout (std430, binding = 2) writeonly buffer Far
+{
+	uint farIds[];
+};
+
+void main()
+{
+	uint index = gl_GlobalInvocationID.x;
+	if (index >= uint(count))
+	{
+		return;
+	}
+	uint id = ordered != 0 ? texelFetch(order, int(index)).r : index;
+	int base = int(id) * 4;
+	mat4 model = mat4(texelFetch(instances, base + 0),
+										texelFetch(instances, base + 1),
+										texelFetch(instances, base + 2),
+										texelFetch(instances, base + 3));
+	mat4 MVP = VP * model;
+	// project the 8 corners of the bounds and take the NDC box
+	vec3 ndcMin = vec3(1e30);
+	vec3 ndcMax = vec3(-1e30);
+	bool crossesNear = false;
+	for (int i = 0; i < 8; ++i)
+	{
+		vec3 corner = mix(boundsMin, boundsMax, vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+		vec4 clip = MVP * vec4(corner, 1.0);
+		if (clip.w <= 0.0)
+		{
+			crossesNear = true;
+			break;
+		}
+		vec3 ndc = clip.xyz / clip.w;
+		ndcMin = min(ndcMin, ndc);
+		ndcMax = max(ndcMax, ndc);
+	}
+	// anything crossing the near plane is treated as visible
+	if (!crossesNear)
+	{
+		if (ndcMax.x < -1.0 || ndcMin.x > 1.0 || ndcMax.y < -1.0 || ndcMin.y > 1.0 || ndcMin.z > 1.0)
+		{
+			atomicAdd(frustumCulled, 1u);
+			return;
+		}
+		if (occlusion != 0)
+		{
+			vec2 uvMin = clamp(ndcMin.xy * 0.5 + 0.5, 0.0, 1.0);
+			vec2 uvMax = clamp(ndcMax.xy * 0.5 + 0.5, 0.0, 1.0);
+			// pick the level where the box covers at most 2x2 texels so 4 samples cover it
+			vec2 extent = (uvMax - uvMin) * vec2(textureSize(hiz, 0));
+			int lod = clamp(int(ceil(log2(max(max(extent.x, extent.y), 1.0)))), 0, hizLevels - 1);
+			ivec2 levelSize = textureSize(hiz, lod);
+			ivec2 a = min(ivec2(uvMin * vec2(levelSize)), levelSize - 1);
+			ivec2 b = min(ivec2(uvMax * vec2(levelSize)), levelSize - 1);
+			float furthest = max(max(texelFetch(hiz, a, lod).r, texelFetch(hiz, ivec2(b.x, a.y), lod).r),
+													 max(texelFetch(hiz, ivec2(a.x, b.y), lod).r, texelFetch(hiz, b, lod).r));
+			// the nearest point of the box is behind everything drawn there
+			if (ndcMin.z * 0.5 + 0.5 > furthest)
+			{
+				atomicAdd(occluded, 1u);
+				return;
+			}
+		}
+	}
+	// both lists get the instances in the fade band so they can be cross faded
+	float dist = length((View * model[3]).xyz);
+	if (lodRange.y <= 0.0 || dist < lodRange.y)
+	{
+		ids[atomicAdd(instanceCount, 1u)] = id;
+	}
+	if (lodRange.y > 0.0 && dist > lodRange.x)
+	{
+		farIds[atomicAdd(farInstanceCount, 1u)] = id;
+	}
+}
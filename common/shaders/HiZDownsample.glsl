@@ -0,0 +1,37 @@
+#version 430 core
+// builds one level of the Hi-Z depth pyramid, level 0 is copied from the depth buffer and every
+// other level keeps the furthest (max) depth of the 2x2 texels below it so a test against any
+// level is conservative
+// the tile size comes from DepthPyramid so the dispatch always matches
+#ifndef TILE_SIZE
+#define TILE_SIZE 8
+#endif
+layout (local_size_x = TILE_SIZE, local_size_y = TILE_SIZE) in;
+// the depth buffer the occluders were drawn into (only used for level 0)
+uniform sampler2D depth;
+// the level we are writing
+uniform int level;
+layout (r32f, binding = 0) uniform readonly image2D src;
+layout (r32f, binding = 1) uniform writeonly image2D dst;
+
+void main()
+{
+	ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+	if (any(greaterThanEqual(p, imageSize(dst))))
+	{
+		return;
+	}
+	float d;
+	if (level == 0)
+	{
+		d = texelFetch(depth, p, 0).r;
+	}
+	else
+	{
+		// the pyramid is a power of 2 so each texel covers exactly 2x2 of the level above
+		ivec2 s = p * 2;
+		d = max(max(imageLoad(src, s).r, imageLoad(src, s + ivec2(1, 0)).r),
+						max(imageLoad(src, s + ivec2(0, 1)).r, imageLoad(src, s + ivec2(1, 1)).r));
+	}
+	imageStore(dst, p, vec4(d));
+}
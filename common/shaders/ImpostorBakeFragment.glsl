@@ -0,0 +1,10 @@
+#version 410 core
+layout (location = 0) out vec4 fragColour;
+in vec2 vertUV;
+uniform sampler2D tex;
+
+void main()
+{
+	// alpha marks the texels covered by the mesh
+	fragColour = vec4(texture(tex, vertUV).rgb, 1.0);
+}
@@ -0,0 +1,12 @@
+#version 410 core
+// renders the mesh into one view of the impostor atlas
+layout (location = 0) in vec3 inVert;
+layout (location = 2) in vec2 inUV;
+uniform mat4 MVP;
+out vec2 vertUV;
+
+void main()
+{
+	vertUV = inUV;
+	gl_Position = MVP * vec4(inVert, 1.0);
+}
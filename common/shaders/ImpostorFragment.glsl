@@ -0,0 +1,36 @@
+#version 410 core
+layout (location = 0) out vec4 fragColour;
+in vec2 atlasUV;
+in vec3 viewPos;
+flat in float scale;
+flat in float fade;
+uniform sampler2D colourAtlas;
+uniform sampler2D depthAtlas;
+uniform mat4 project;
+// the distance of the bake camera from the mesh axis, the bake depth range is twice this
+uniform float bakeDistance;
+
+// the same screen door pattern as the mesh shader, the mesh keeps the pixels the impostor drops
+float dither()
+{
+	return fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+}
+
+void main()
+{
+	if (dither() >= fade)
+	{
+		discard;
+	}
+	vec4 colour = texture(colourAtlas, atlasUV);
+	if (colour.a < 0.5)
+	{
+		discard;
+	}
+	// the bake was orthographic so the depth is linear with the quad in the middle, push the
+	// fragment back (or forward) along the view ray by how far the surface was from the quad
+	float offset = (texture(depthAtlas, atlasUV).r * 2.0 - 1.0) * bakeDistance * scale;
+	vec4 clip = project * vec4(viewPos + normalize(viewPos) * offset, 1.0);
+	gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+	fragColour = vec4(colour.rgb, 1.0);
+}
@@ -0,0 +1,42 @@
+#version 410 core
+// draws each far instance as an upright quad facing the camera (a 4 vertex triangle strip with no
+// vertex data) and picks the atlas view baked closest to the direction the instance is seen from
+uniform samplerBuffer TBO;
+uniform usamplerBuffer ids;
+uniform mat4 project;
+uniform mat4 View;
+// the fade band, must match the mesh shader and the culling
+uniform vec2 lodRange;
+// the quad in the local space of the mesh
+uniform float halfWidth;
+uniform vec2 heightRange;
+uniform int views;
+uniform int columns;
+out vec2 atlasUV;
+out vec3 viewPos;
+flat out float scale;
+flat out float fade;
+
+void main()
+{
+	int id = int(texelFetch(ids, gl_InstanceID).r);
+	mat4 MV = View * mat4(texelFetch(TBO, id * 4 + 0),
+												texelFetch(TBO, id * 4 + 1),
+												texelFetch(TBO, id * 4 + 2),
+												texelFetch(TBO, id * 4 + 3));
+	vec3 centre = MV[3].xyz;
+	scale = length(MV[1].xyz);
+	fade = clamp((length(centre) - lodRange.x) / max(lodRange.y - lodRange.x, 1e-4), 0.0, 1.0);
+	// keep the quad upright in the instance's frame and turn it to face the camera
+	vec3 toCamera = -centre;
+	vec3 up = normalize(MV[1].xyz);
+	vec3 right = normalize(cross(up, toCamera));
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	viewPos = centre + right * (corner.x * 2.0 - 1.0) * halfWidth * scale + up * mix(heightRange.x, heightRange.y, corner.y) * scale;
+	// the angle around the instance's Y axis we are looking from, view i was baked from 2pi i / views
+	vec3 local = transpose(mat3(MV)) * toCamera;
+	int view = int(round(atan(local.x, local.z) / 6.2831853 * float(views)));
+	view = (view % views + views) % views;
+	atlasUV = (vec2(view % columns, view / columns) + corner) / float(columns);
+	gl_Position = project * vec4(viewPos, 1.0);
+}
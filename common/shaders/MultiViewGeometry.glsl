@@ -0,0 +1,29 @@
+#version 410 core
+// routes each triangle of a multi view draw to the viewport (and layer when rendering to a
+// layered target) of its view, gl_ViewportIndex from the vertex shader needs an extension so
+// it is done here
+layout(triangles) in;
+layout(triangle_strip, max_vertices = 3) out;
+
+flat in int vertView[];
+#ifndef DEPTH_ONLY
+in vec2 geomUV[];
+out vec2 vertUV;
+#endif
+// the depth pre-pass and colour pass must produce identical depths for GL_EQUAL
+invariant gl_Position;
+
+void main()
+{
+	for(int i = 0; i < 3; ++i)
+	{
+		gl_Position = gl_in[i].gl_Position;
+		gl_ViewportIndex = vertView[0];
+		gl_Layer = vertView[0];
+#ifndef DEPTH_ONLY
+		vertUV = geomUV[i];
+#endif
+		EmitVertex();
+	}
+	EndPrimitive();
+}
@@ -0,0 +1,78 @@
+#version 330 core
+// some of this code is borrowed / modified from the
+// Apple 	WWDC 2011 Instancing demo
+
+// the batch size is injected from GL_MAX_UNIFORM_BLOCK_SIZE when the program is built, this is
+// the spec minimum (16KB of mat4) if it isn't
+#ifndef INSTANCES_PER_BLOCK
+#define INSTANCES_PER_BLOCK 256
+#endif
+#ifdef MATRIX_AFFINE
+// affine matrices are stored as 3 rows, the last row is always 0,0,0,1
+layout(std140) uniform UBO
+{
+	vec4 ModelViewRows[INSTANCES_PER_BLOCK*3];
+} block;
+#else
+layout(std140) uniform UBO
+{
+	mat4 ModelView[INSTANCES_PER_BLOCK];
+} block;
+#endif
+/// @brief projection passed from app, the Mat4 single view matrices already include it
+#ifndef MATRIX_PROJECTED
+uniform mat4 Projection;
+#endif
+// first attribute the vertex values from our VAO
+layout(location =0)in vec3 inVert;
+// second attribute the UV values from our VAO
+layout (location=1)in vec2 inUV;
+// in multi view the matrices are model space and every instance is drawn once per view, the
+// view projections come from the Views block and the geometry shader outputs vertUV
+#ifdef MULTI_VIEW
+layout(std140) uniform Views
+{
+	mat4 viewProjection[MAX_VIEWS];
+};
+uniform int numViews;
+flat out int vertView;
+#define vertUV geomUV
+#define INSTANCE (gl_InstanceID / numViews)
+#else
+#define INSTANCE gl_InstanceID
+#endif
+// we use this to pass the UV values to the frag shader, the depth pass has no UV work
+#ifndef DEPTH_ONLY
+out vec2 vertUV;
+#endif
+// the depth pre-pass and colour pass must produce identical depths for GL_EQUAL
+invariant gl_Position;
+
+void main(void)
+{
+	vec4 position = vec4(inVert, 1.0);
+	// transform the vertex rather than building a full matrix, the matrix products are per instance
+	// work the generator does once
+#ifdef MATRIX_AFFINE
+	// affine matrices are stored as 3 rows, the last row is always 0,0,0,1 so each row is a dot product
+	vec4 transformed = vec4(dot(block.ModelViewRows[INSTANCE*3+0], position),
+													dot(block.ModelViewRows[INSTANCE*3+1], position),
+													dot(block.ModelViewRows[INSTANCE*3+2], position),
+													1.0);
+#else
+	vec4 transformed = block.ModelView[INSTANCE] * position;
+#endif
+#ifdef MULTI_VIEW
+	vertView = gl_InstanceID % numViews;
+	gl_Position = viewProjection[vertView] * transformed;
+#elif defined(MATRIX_PROJECTED)
+	// the generator baked the projection into the matrix
+	gl_Position = transformed;
+#else
+	gl_Position = Projection * transformed;
+#endif
+#ifndef DEPTH_ONLY
+	// pass the UV values to the frag shader
+	vertUV=inUV;
+#endif
+}
@@ -0,0 +1,88 @@
+#version 330 core
+// some of this code is borrowed / modified from the
+// Apple 	WWDC 2011 Instancing demo
+// the view matrix for our object this will be
+// created from the camera
+uniform mat4 View;
+// per draw data to modify our objects
+uniform vec4 data;
+// mouse rotatin passed in from our objet
+uniform mat4 mouseRotation;
+#ifdef POINTS_GENERATED
+#include "CounterRandom.glsl"
+// the same cloud as InstanceGenerator::createPoints worked out from the index, nothing is read
+vec3 cloudPoint(uint index)
+{
+	uvec4 a = counterRandom(uint(CLOUD_SEED), uint(CLOUD_STREAM), index, 0u);
+	uint b = counterRandom(uint(CLOUD_SEED), uint(CLOUD_STREAM), index, 1u).x;
+	float angle = (counterUnit(a.x) * 2.0 - 1.0) * 3.14159265;
+	float radius = counterUnit(a.y) * 2.0 - 1.0;
+	float ca = cos(angle);
+	float sa = sin(angle);
+	float x = radius * (ca < 0.0 ? -1.0 : 1.0) * pow(abs(ca), 1.2);
+	float y = radius * (sa < 0.0 ? -1.0 : 1.0) * pow(abs(sa), 1.2);
+	return vec3((counterUnit(a.z) * 2.0 - 1.0) * x * 80.0, (counterUnit(a.w) * 2.0 - 1.0) * y,
+							(counterUnit(b) * 2.0 - 1.0) * (x + y * 80.0));
+}
+#else
+// this is the point position passed in, it may be quantized to 0-1 over the bounds of the cloud
+layout (location=0) in vec3 inPos;
+#endif
+// dequantize with pointMin + inPos * pointScale (0 and 1 for float points)
+uniform vec3 pointMin;
+uniform vec3 pointScale;
+// this matrix will be used as an output from our feedback buffer and fed
+// into the next shader for per object transforms
+#ifdef MATRIX_AFFINE
+// affine matrices only need the first 3 rows, the last row is always 0,0,0,1
+out vec4 ModelViewRow0;
+out vec4 ModelViewRow1;
+out vec4 ModelViewRow2;
+#else
+out mat4 ModelView;
+#endif
+void main()
+{
+#ifdef POINTS_GENERATED
+	vec3 pos = cloudPoint(uint(gl_VertexID));
+#else
+	vec3 pos = pointMin + inPos * pointScale;
+#endif
+	//	Scale and spin each instance by a unique amount
+	float spin = (gl_VertexID & 31) - 15.5;
+	float c = cos(data.x * spin);
+	float s = sin(data.x * spin);
+	float y = (gl_VertexID & 15) * 0.125 + 0.25;
+	float z = ((gl_VertexID + 5) & 63) * 0.03125 + 0.25;
+	mat4 Model = mat4(   c, 0.0,  -s, 0.0,
+												 0.0,   y, 0.0, 0.0,
+													 s, 0.0, z*c, 0.0,
+												 0.0, 0.0, 0.0, 1.0);
+	// Translate each instance
+	Model[3].xyz = pos;
+	// Rotate all instances around Z, scaled by dist
+	float dist = length(pos);
+	float speed = data.y - dist * data.z + (gl_VertexID & 7) * 0.01;
+	c = cos(data.x * speed);
+	s = sin(data.x * speed);
+	mat4 rotY = mat4(   c,   s, 0.0, 0.0,
+												 -s,   c, 0.0, 0.0,
+												0.0, 0.0, 1.0, 0.0,
+												0.0, 0.0, 0.0, 1.0);
+	Model = rotY * Model;
+	Model = mouseRotation * Model;
+	// Scale each instance
+	Model[0] *= data.w;
+	Model[1] *= data.w;
+	Model[2] *= data.w;
+	// with a single view bake that in, for multi view View is the identity and the per view
+	// matrices are applied in the draw
+#ifdef MATRIX_AFFINE
+	mat4 rows = transpose(View * Model);
+	ModelViewRow0 = rows[0];
+	ModelViewRow1 = rows[1];
+	ModelViewRow2 = rows[2];
+#else
+	ModelView = View * Model;
+#endif
+}
@@ -0,0 +1,176 @@
+#include "BackendTuner.h"
+#include "GpuTimer.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief size of the offscreen target, fixed so the results don't depend on the window size
+//----------------------------------------------------------------------------------------------------------------------
+constexpr GLsizei c_width = 1024;
+constexpr GLsizei c_height = 720;
+
+namespace
+{
+float median(std::vector<float> &_values)
+{
+  if (_values.empty())
+  {
+    return 0.0f;
+  }
+  auto mid = _values.begin() + _values.size() / 2;
+  std::nth_element(_values.begin(), mid, _values.end());
+  return *mid;
+}
+
+std::string glString(GLenum _name)
+{
+  auto str = glGetString(_name);
+  return str != nullptr ? reinterpret_cast<const char *>(str) : "unknown";
+}
+} // namespace
+
+BackendTuner::BackendTuner(std::string _cacheFile) : m_cacheFile(std::move(_cacheFile))
+{
+}
+
+void BackendTuner::setFrames(int _warmup, int _measured)
+{
+  m_warmupFrames = std::max(_warmup, 0);
+  m_measuredFrames = std::max(_measured, 1);
+}
+
+std::string BackendTuner::cacheKey(GLuint _instances, const std::string &_settings)
+{
+  return glString(GL_RENDERER) + " | " + glString(GL_VERSION) + " | " + std::to_string(_instances) + " | " + _settings;
+}
+
+BackendTuner::Choice BackendTuner::tune(GLuint _instances, const std::string &_settings, const DrawFunction &_draw, bool _force)
+{
+  auto key = cacheKey(_instances, _settings);
+  m_timings.clear();
+  m_fromCache = !_force && loadCached(key, m_choice);
+  if (m_fromCache)
+  {
+    return m_choice;
+  }
+  // render offscreen so nothing is presented and the size is fixed
+  GLint previousFBO, viewport[4];
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFBO);
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  GLuint fbo, rbo[2];
+  glGenFramebuffers(1, &fbo);
+  glGenRenderbuffers(2, rbo);
+  glBindRenderbuffer(GL_RENDERBUFFER, rbo[0]);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, c_width, c_height);
+  glBindRenderbuffer(GL_RENDERBUFFER, rbo[1]);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, c_width, c_height);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rbo[0]);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rbo[1]);
+  glViewport(0, 0, c_width, c_height);
+
+  for (auto backend : {InstanceRenderer::Backend::TBO, InstanceRenderer::Backend::UBO, InstanceRenderer::Backend::Divisor})
+  {
+    for (auto encoding : {InstanceRenderer::Encoding::Mat4, InstanceRenderer::Encoding::Affine})
+    {
+      m_timings.push_back(measure({backend, encoding}, _draw));
+    }
+  }
+  auto best = std::min_element(m_timings.begin(), m_timings.end(), [](const Timing &_a, const Timing &_b)
+                               { return _a.frameMs < _b.frameMs; });
+  m_choice = best->choice;
+
+  glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previousFBO));
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  glDeleteRenderbuffers(2, rbo);
+  glDeleteFramebuffers(1, &fbo);
+  storeCached(key, m_choice);
+  return m_choice;
+}
+
+BackendTuner::Timing BackendTuner::measure(const Choice &_choice, const DrawFunction &_draw) const
+{
+  for (int i = 0; i < m_warmupFrames; ++i)
+  {
+    _draw(_choice);
+  }
+  glFinish();
+  GpuTimer timer;
+  std::vector<float> frame, gpu;
+  frame.reserve(m_measuredFrames);
+  gpu.reserve(m_measuredFrames);
+  for (int i = 0; i < m_measuredFrames; ++i)
+  {
+    auto start = std::chrono::steady_clock::now();
+    timer.begin();
+    _draw(_choice);
+    timer.end();
+    glFinish();
+    frame.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+    gpu.push_back(timer.elapsedMs());
+  }
+  Timing timing;
+  timing.choice = _choice;
+  timing.frameMs = median(frame);
+  timing.gpuMs = median(gpu);
+  return timing;
+}
+
+bool BackendTuner::loadCached(const std::string &_key, Choice &o_choice) const
+{
+  // each line is key <tab> backend <tab> encoding
+  std::ifstream file(m_cacheFile);
+  std::string line;
+  while (std::getline(file, line))
+  {
+    std::istringstream fields(line);
+    std::string key, backend, encoding;
+    if (std::getline(fields, key, '\t') && std::getline(fields, backend, '\t') && std::getline(fields, encoding) && key == _key)
+    {
+      o_choice.backend = InstanceRenderer::backendFromName(backend);
+      o_choice.encoding = InstanceRenderer::encodingFromName(encoding);
+      return true;
+    }
+  }
+  return false;
+}
+
+void BackendTuner::storeCached(const std::string &_key, const Choice &_choice) const
+{
+  // keep the entries for other setups and replace ours
+  std::vector<std::string> lines;
+  {
+    std::ifstream file(m_cacheFile);
+    std::string line;
+    while (std::getline(file, line))
+    {
+      if (!line.empty() && line.compare(0, _key.size() + 1, _key + '\t') != 0)
+      {
+        lines.push_back(line);
+      }
+    }
+  }
+  lines.push_back(_key + '\t' + InstanceRenderer::backendName(_choice.backend) + '\t' + InstanceRenderer::encodingName(_choice.encoding));
+  std::ofstream file(m_cacheFile);
+  for (const auto &line : lines)
+  {
+    file << line << '\n';
+  }
+}
+
+void BackendTuner::printSummary(std::ostream &_out) const
+{
+  _out << "Instancing backend " << InstanceRenderer::backendName(m_choice.backend) << ' '
+       << InstanceRenderer::encodingName(m_choice.encoding) << (m_fromCache ? " (cached in " + m_cacheFile + ")" : "") << '\n';
+  auto flags = _out.flags();
+  _out << std::fixed << std::setprecision(3);
+  for (const auto &t : m_timings)
+  {
+    _out << "  " << std::setw(8) << InstanceRenderer::backendName(t.choice.backend) << ' ' << std::setw(6)
+         << InstanceRenderer::encodingName(t.choice.encoding) << " frame " << t.frameMs << "ms gpu " << t.gpuMs << "ms\n";
+  }
+  _out.flags(flags);
+}
@@ -0,0 +1,502 @@
+#include "BatchTransform.h"
+#include "SimdTarget.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the kernels for one instruction set, ranges are [_begin, _end) so the vector kernels can
+/// hand their remainder to the scalar ones
+//----------------------------------------------------------------------------------------------------------------------
+struct Kernels
+{
+  void (*compose)(const BatchTransform::Transforms &, size_t, size_t, float *);
+  void (*multiply)(const float *, const float *, size_t, size_t, float *);
+  void (*bounds)(const float *, size_t, size_t, const float *, const float *, float *, float *);
+};
+
+float valueOr(const float *_values, size_t _i, float _default)
+{
+  return _values != nullptr ? _values[_i] : _default;
+}
+
+void composeScalar(const BatchTransform::Transforms &_t, size_t _begin, size_t _end, float *o_matrices)
+{
+  for (size_t i = _begin; i < _end; ++i)
+  {
+    float x = valueOr(_t.qx, i, 0.0f), y = valueOr(_t.qy, i, 0.0f), z = valueOr(_t.qz, i, 0.0f), w = valueOr(_t.qw, i, 1.0f);
+    float sx = _t.sx[i], sy = _t.sy[i], sz = _t.sz[i];
+    float *m = o_matrices + i * 16;
+    m[0] = (1.0f - 2.0f * (y * y + z * z)) * sx;
+    m[1] = 2.0f * (x * y + w * z) * sx;
+    m[2] = 2.0f * (x * z - w * y) * sx;
+    m[3] = 0.0f;
+    m[4] = 2.0f * (x * y - w * z) * sy;
+    m[5] = (1.0f - 2.0f * (x * x + z * z)) * sy;
+    m[6] = 2.0f * (y * z + w * x) * sy;
+    m[7] = 0.0f;
+    m[8] = 2.0f * (x * z + w * y) * sz;
+    m[9] = 2.0f * (y * z - w * x) * sz;
+    m[10] = (1.0f - 2.0f * (x * x + y * y)) * sz;
+    m[11] = 0.0f;
+    m[12] = _t.px[i];
+    m[13] = _t.py[i];
+    m[14] = _t.pz[i];
+    m[15] = 1.0f;
+  }
+}
+
+void multiplyScalar(const float *_lhs, const float *_matrices, size_t _begin, size_t _end, float *o_matrices)
+{
+  for (size_t i = _begin; i < _end; ++i)
+  {
+    const float *m = _matrices + i * 16;
+    float result[16];
+    for (int c = 0; c < 4; ++c)
+    {
+      for (int r = 0; r < 4; ++r)
+      {
+        result[c * 4 + r] = _lhs[r] * m[c * 4] + _lhs[4 + r] * m[c * 4 + 1] + _lhs[8 + r] * m[c * 4 + 2] + _lhs[12 + r] * m[c * 4 + 3];
+      }
+    }
+    std::memcpy(o_matrices + i * 16, result, sizeof(result));
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the centre moves with the matrix and the half extent is the sum of the absolute columns
+/// scaled by the local half extent (Arvo), no need to transform all 8 corners
+//----------------------------------------------------------------------------------------------------------------------
+void boundsScalar(const float *_matrices, size_t _begin, size_t _end, const float *_centre, const float *_extent, float *o_min, float *o_max)
+{
+  for (size_t i = _begin; i < _end; ++i)
+  {
+    const float *m = _matrices + i * 16;
+    for (int r = 0; r < 4; ++r)
+    {
+      float centre = m[r] * _centre[0] + m[4 + r] * _centre[1] + m[8 + r] * _centre[2] + m[12 + r];
+      float extent = std::fabs(m[r]) * _extent[0] + std::fabs(m[4 + r]) * _extent[1] + std::fabs(m[8 + r]) * _extent[2];
+      o_min[i * 4 + r] = centre - extent;
+      o_max[i * 4 + r] = centre + extent;
+    }
+  }
+}
+
+#if defined(SIMD_X86)
+TARGET_SSE2 __m128 loadOr(const float *_values, size_t _i, float _default)
+{
+  return _values != nullptr ? _mm_loadu_ps(_values + _i) : _mm_set1_ps(_default);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the 4 rows of one column for 4 instances, transposed so each instance's column is stored whole
+//----------------------------------------------------------------------------------------------------------------------
+TARGET_SSE2 void storeColumn(float *o_matrices, size_t _i, int _column, __m128 _r0, __m128 _r1, __m128 _r2, __m128 _r3)
+{
+  _MM_TRANSPOSE4_PS(_r0, _r1, _r2, _r3);
+  float *m = o_matrices + _i * 16 + _column * 4;
+  _mm_storeu_ps(m, _r0);
+  _mm_storeu_ps(m + 16, _r1);
+  _mm_storeu_ps(m + 32, _r2);
+  _mm_storeu_ps(m + 48, _r3);
+}
+
+TARGET_SSE2 void composeSSE2(const BatchTransform::Transforms &_t, size_t _begin, size_t _end, float *o_matrices)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 two = _mm_set1_ps(2.0f);
+  const __m128 zero = _mm_setzero_ps();
+  size_t i = _begin;
+  for (; i + 4 <= _end; i += 4)
+  {
+    __m128 x = loadOr(_t.qx, i, 0.0f), y = loadOr(_t.qy, i, 0.0f), z = loadOr(_t.qz, i, 0.0f), w = loadOr(_t.qw, i, 1.0f);
+    __m128 sx = _mm_loadu_ps(_t.sx + i), sy = _mm_loadu_ps(_t.sy + i), sz = _mm_loadu_ps(_t.sz + i);
+    __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+    __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+    __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+    storeColumn(o_matrices, i, 0, _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+                _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx), _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx), zero);
+    storeColumn(o_matrices, i, 1, _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy),
+                _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy), _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy), zero);
+    storeColumn(o_matrices, i, 2, _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz), _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+                _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz), zero);
+    storeColumn(o_matrices, i, 3, _mm_loadu_ps(_t.px + i), _mm_loadu_ps(_t.py + i), _mm_loadu_ps(_t.pz + i), one);
+  }
+  composeScalar(_t, i, _end, o_matrices);
+}
+
+TARGET_SSE2 void multiplySSE2(const float *_lhs, const float *_matrices, size_t _begin, size_t _end, float *o_matrices)
+{
+  const __m128 l0 = _mm_loadu_ps(_lhs), l1 = _mm_loadu_ps(_lhs + 4), l2 = _mm_loadu_ps(_lhs + 8), l3 = _mm_loadu_ps(_lhs + 12);
+  for (size_t i = _begin; i < _end; ++i)
+  {
+    const float *m = _matrices + i * 16;
+    // all of the columns are loaded first so the output can be the input
+    __m128 columns[4] = {_mm_loadu_ps(m), _mm_loadu_ps(m + 4), _mm_loadu_ps(m + 8), _mm_loadu_ps(m + 12)};
+    float *o = o_matrices + i * 16;
+    // each result column is the lhs columns weighted by the elements of the rhs column
+    for (int c = 0; c < 4; ++c)
+    {
+      __m128 r = _mm_mul_ps(l0, _mm_shuffle_ps(columns[c], columns[c], _MM_SHUFFLE(0, 0, 0, 0)));
+      r = _mm_add_ps(r, _mm_mul_ps(l1, _mm_shuffle_ps(columns[c], columns[c], _MM_SHUFFLE(1, 1, 1, 1))));
+      r = _mm_add_ps(r, _mm_mul_ps(l2, _mm_shuffle_ps(columns[c], columns[c], _MM_SHUFFLE(2, 2, 2, 2))));
+      r = _mm_add_ps(r, _mm_mul_ps(l3, _mm_shuffle_ps(columns[c], columns[c], _MM_SHUFFLE(3, 3, 3, 3))));
+      _mm_storeu_ps(o + c * 4, r);
+    }
+  }
+}
+
+TARGET_SSE2 void boundsSSE2(const float *_matrices, size_t _begin, size_t _end, const float *_centre, const float *_extent, float *o_min, float *o_max)
+{
+  const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  const __m128 cx = _mm_set1_ps(_centre[0]), cy = _mm_set1_ps(_centre[1]), cz = _mm_set1_ps(_centre[2]);
+  const __m128 ex = _mm_set1_ps(_extent[0]), ey = _mm_set1_ps(_extent[1]), ez = _mm_set1_ps(_extent[2]);
+  for (size_t i = _begin; i < _end; ++i)
+  {
+    const float *m = _matrices + i * 16;
+    __m128 c0 = _mm_loadu_ps(m), c1 = _mm_loadu_ps(m + 4), c2 = _mm_loadu_ps(m + 8), c3 = _mm_loadu_ps(m + 12);
+    __m128 centre = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, cx), _mm_mul_ps(c1, cy)), _mm_add_ps(_mm_mul_ps(c2, cz), c3));
+    __m128 extent = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(c0, absMask), ex), _mm_mul_ps(_mm_and_ps(c1, absMask), ey)),
+                               _mm_mul_ps(_mm_and_ps(c2, absMask), ez));
+    _mm_storeu_ps(o_min + i * 4, _mm_sub_ps(centre, extent));
+    _mm_storeu_ps(o_max + i * 4, _mm_add_ps(centre, extent));
+  }
+}
+
+TARGET_AVX2 __m256 loadOr8(const float *_values, size_t _i, float _default)
+{
+  return _values != nullptr ? _mm256_loadu_ps(_values + _i) : _mm256_set1_ps(_default);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief as storeColumn for 8 instances, the low and high halves are the first and last 4
+//----------------------------------------------------------------------------------------------------------------------
+TARGET_AVX2 void storeColumn8(float *o_matrices, size_t _i, int _column, __m256 _r0, __m256 _r1, __m256 _r2, __m256 _r3)
+{
+  __m128 lo0 = _mm256_castps256_ps128(_r0), lo1 = _mm256_castps256_ps128(_r1), lo2 = _mm256_castps256_ps128(_r2), lo3 = _mm256_castps256_ps128(_r3);
+  __m128 hi0 = _mm256_extractf128_ps(_r0, 1), hi1 = _mm256_extractf128_ps(_r1, 1), hi2 = _mm256_extractf128_ps(_r2, 1),
+         hi3 = _mm256_extractf128_ps(_r3, 1);
+  _MM_TRANSPOSE4_PS(lo0, lo1, lo2, lo3);
+  _MM_TRANSPOSE4_PS(hi0, hi1, hi2, hi3);
+  float *m = o_matrices + _i * 16 + _column * 4;
+  _mm_storeu_ps(m, lo0);
+  _mm_storeu_ps(m + 16, lo1);
+  _mm_storeu_ps(m + 32, lo2);
+  _mm_storeu_ps(m + 48, lo3);
+  _mm_storeu_ps(m + 64, hi0);
+  _mm_storeu_ps(m + 80, hi1);
+  _mm_storeu_ps(m + 96, hi2);
+  _mm_storeu_ps(m + 112, hi3);
+}
+
+TARGET_AVX2 void composeAVX2(const BatchTransform::Transforms &_t, size_t _begin, size_t _end, float *o_matrices)
+{
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 two = _mm256_set1_ps(2.0f);
+  const __m256 minusTwo = _mm256_set1_ps(-2.0f);
+  const __m256 zero = _mm256_setzero_ps();
+  size_t i = _begin;
+  for (; i + 8 <= _end; i += 8)
+  {
+    __m256 x = loadOr8(_t.qx, i, 0.0f), y = loadOr8(_t.qy, i, 0.0f), z = loadOr8(_t.qz, i, 0.0f), w = loadOr8(_t.qw, i, 1.0f);
+    __m256 sx = _mm256_loadu_ps(_t.sx + i), sy = _mm256_loadu_ps(_t.sy + i), sz = _mm256_loadu_ps(_t.sz + i);
+    __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+    __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+    __m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+    // 1 - 2 * (a + b) as one fused multiply add
+    storeColumn8(o_matrices, i, 0, _mm256_mul_ps(_mm256_fmadd_ps(minusTwo, _mm256_add_ps(yy, zz), one), sx),
+                 _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx), _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx), zero);
+    storeColumn8(o_matrices, i, 1, _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy),
+                 _mm256_mul_ps(_mm256_fmadd_ps(minusTwo, _mm256_add_ps(xx, zz), one), sy), _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy),
+                 zero);
+    storeColumn8(o_matrices, i, 2, _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz),
+                 _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz), _mm256_mul_ps(_mm256_fmadd_ps(minusTwo, _mm256_add_ps(xx, yy), one), sz),
+                 zero);
+    storeColumn8(o_matrices, i, 3, _mm256_loadu_ps(_t.px + i), _mm256_loadu_ps(_t.py + i), _mm256_loadu_ps(_t.pz + i), one);
+  }
+  composeScalar(_t, i, _end, o_matrices);
+}
+
+TARGET_AVX2 void multiplyAVX2(const float *_lhs, const float *_matrices, size_t _begin, size_t _end, float *o_matrices)
+{
+  // the lhs columns repeated in both halves so two rhs columns are done per instruction
+  const __m256 l0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(_lhs));
+  const __m256 l1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(_lhs + 4));
+  const __m256 l2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(_lhs + 8));
+  const __m256 l3 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(_lhs + 12));
+  for (size_t i = _begin; i < _end; ++i)
+  {
+    const float *m = _matrices + i * 16;
+    __m256 c01 = _mm256_loadu_ps(m), c23 = _mm256_loadu_ps(m + 8);
+    __m256 r01 = _mm256_mul_ps(l0, _mm256_permute_ps(c01, 0x00));
+    __m256 r23 = _mm256_mul_ps(l0, _mm256_permute_ps(c23, 0x00));
+    r01 = _mm256_fmadd_ps(l1, _mm256_permute_ps(c01, 0x55), r01);
+    r23 = _mm256_fmadd_ps(l1, _mm256_permute_ps(c23, 0x55), r23);
+    r01 = _mm256_fmadd_ps(l2, _mm256_permute_ps(c01, 0xaa), r01);
+    r23 = _mm256_fmadd_ps(l2, _mm256_permute_ps(c23, 0xaa), r23);
+    r01 = _mm256_fmadd_ps(l3, _mm256_permute_ps(c01, 0xff), r01);
+    r23 = _mm256_fmadd_ps(l3, _mm256_permute_ps(c23, 0xff), r23);
+    _mm256_storeu_ps(o_matrices + i * 16, r01);
+    _mm256_storeu_ps(o_matrices + i * 16 + 8, r23);
+  }
+}
+
+TARGET_AVX2 __m256 loadPair(const float *_a, const float *_b)
+{
+  return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(_a)), _mm_loadu_ps(_b), 1);
+}
+
+TARGET_AVX2 void boundsAVX2(const float *_matrices, size_t _begin, size_t _end, const float *_centre, const float *_extent, float *o_min, float *o_max)
+{
+  const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+  const __m256 cx = _mm256_set1_ps(_centre[0]), cy = _mm256_set1_ps(_centre[1]), cz = _mm256_set1_ps(_centre[2]);
+  const __m256 ex = _mm256_set1_ps(_extent[0]), ey = _mm256_set1_ps(_extent[1]), ez = _mm256_set1_ps(_extent[2]);
+  size_t i = _begin;
+  // two instances per pass, one in each half
+  for (; i + 2 <= _end; i += 2)
+  {
+    const float *a = _matrices + i * 16;
+    const float *b = a + 16;
+    __m256 c0 = loadPair(a, b), c1 = loadPair(a + 4, b + 4), c2 = loadPair(a + 8, b + 8), c3 = loadPair(a + 12, b + 12);
+    __m256 centre = _mm256_fmadd_ps(c0, cx, _mm256_fmadd_ps(c1, cy, _mm256_fmadd_ps(c2, cz, c3)));
+    __m256 extent = _mm256_fmadd_ps(_mm256_and_ps(c0, absMask), ex,
+                                    _mm256_fmadd_ps(_mm256_and_ps(c1, absMask), ey, _mm256_mul_ps(_mm256_and_ps(c2, absMask), ez)));
+    _mm256_storeu_ps(o_min + i * 4, _mm256_sub_ps(centre, extent));
+    _mm256_storeu_ps(o_max + i * 4, _mm256_add_ps(centre, extent));
+  }
+  boundsScalar(_matrices, i, _end, _centre, _extent, o_min, o_max);
+}
+#endif
+
+BatchTransform::Isa detect()
+{
+#if defined(SIMD_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 0);
+  int maxLeaf = info[0];
+  __cpuid(info, 1);
+  bool sse2 = (info[3] & (1 << 26)) != 0;
+  bool fma = (info[2] & (1 << 12)) != 0;
+  // the OS must save the AVX registers (OSXSAVE and XCR0 bits 1 and 2)
+  bool osAVX = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+  bool avx2 = false;
+  if (maxLeaf >= 7)
+  {
+    __cpuidex(info, 7, 0);
+    avx2 = (info[1] & (1 << 5)) != 0;
+  }
+#else
+  __builtin_cpu_init();
+  bool sse2 = __builtin_cpu_supports("sse2");
+  bool fma = __builtin_cpu_supports("fma");
+  bool osAVX = true; // __builtin_cpu_supports already checks the OS support
+  bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+  if (avx2 && fma && osAVX)
+  {
+    return BatchTransform::Isa::AVX2;
+  }
+  if (sse2)
+  {
+    return BatchTransform::Isa::SSE2;
+  }
+#endif
+  return BatchTransform::Isa::Scalar;
+}
+
+const Kernels &kernels(BatchTransform::Isa _isa)
+{
+  static const Kernels scalar = {composeScalar, multiplyScalar, boundsScalar};
+#if defined(SIMD_X86)
+  static const Kernels sse2 = {composeSSE2, multiplySSE2, boundsSSE2};
+  static const Kernels avx2 = {composeAVX2, multiplyAVX2, boundsAVX2};
+  switch (_isa)
+  {
+  case BatchTransform::Isa::AVX2:
+    return avx2;
+  case BatchTransform::Isa::SSE2:
+    return sse2;
+  default:
+    break;
+  }
+#endif
+  return scalar;
+}
+
+std::atomic<int> &currentIsa()
+{
+  static std::atomic<int> isa{static_cast<int>(BatchTransform::supported())};
+  return isa;
+}
+
+const Kernels &active()
+{
+  return kernels(static_cast<BatchTransform::Isa>(currentIsa().load(std::memory_order_relaxed)));
+}
+} // namespace
+
+BatchTransform::Isa BatchTransform::supported()
+{
+  static const Isa best = detect();
+  return best;
+}
+
+BatchTransform::Isa BatchTransform::isa()
+{
+  return static_cast<Isa>(currentIsa().load());
+}
+
+void BatchTransform::setIsa(Isa _isa)
+{
+  currentIsa().store(std::min(static_cast<int>(_isa), static_cast<int>(supported())));
+}
+
+const char *BatchTransform::isaName(Isa _isa)
+{
+  switch (_isa)
+  {
+  case Isa::AVX2:
+    return "AVX2";
+  case Isa::SSE2:
+    return "SSE2";
+  default:
+    return "scalar";
+  }
+}
+
+void BatchTransform::compose(const Transforms &_transforms, float *o_matrices)
+{
+  active().compose(_transforms, 0, _transforms.count, o_matrices);
+}
+
+void BatchTransform::multiply(const ngl::Mat4 &_lhs, const float *_matrices, size_t _count, float *o_matrices)
+{
+  active().multiply(&_lhs.m_m[0][0], _matrices, 0, _count, o_matrices);
+}
+
+void BatchTransform::transformBounds(const float *_matrices, size_t _count, const ngl::Vec3 &_min, const ngl::Vec3 &_max, float *o_min, float *o_max)
+{
+  const float centre[3] = {(_min.m_x + _max.m_x) * 0.5f, (_min.m_y + _max.m_y) * 0.5f, (_min.m_z + _max.m_z) * 0.5f};
+  const float extent[3] = {(_max.m_x - _min.m_x) * 0.5f, (_max.m_y - _min.m_y) * 0.5f, (_max.m_z - _min.m_z) * 0.5f};
+  active().bounds(_matrices, 0, _count, centre, extent, o_min, o_max);
+}
+
+namespace
+{
+
+float maxDifference(const std::vector<float> &_a, const std::vector<float> &_b)
+{
+  float difference = 0.0f;
+  for (size_t i = 0; i < _a.size(); ++i)
+  {
+    difference = std::max(difference, std::fabs(_a[i] - _b[i]));
+  }
+  return difference;
+}
+} // namespace
+
+void BatchTransform::benchmark(std::ostream &_out, size_t _count)
+{
+  static_assert(sizeof(ngl::Mat4) == 16 * sizeof(float), "ngl::Mat4 must be 16 packed floats");
+  Isa saved = isa();
+  // the same sort of data as the trees, a spread of positions and uniform scales
+  std::mt19937 generator(1234);
+  std::uniform_real_distribution<float> position(-540.0f, 540.0f);
+  std::uniform_real_distribution<float> scale(0.5f, 2.5f);
+  std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+  std::vector<float> px(_count), py(_count), pz(_count), qx(_count), qy(_count), qz(_count), qw(_count), s(_count);
+  for (size_t i = 0; i < _count; ++i)
+  {
+    px[i] = position(generator);
+    py[i] = 0.0f;
+    pz[i] = position(generator);
+    s[i] = scale(generator);
+    // a rotation about y for the rotated compose
+    float half = angle(generator) * 0.5f;
+    qx[i] = 0.0f;
+    qy[i] = std::sin(half);
+    qz[i] = 0.0f;
+    qw[i] = std::cos(half);
+  }
+  Transforms transforms;
+  transforms.px = px.data();
+  transforms.py = py.data();
+  transforms.pz = pz.data();
+  transforms.sx = transforms.sy = transforms.sz = s.data();
+  transforms.count = _count;
+  Transforms rotated = transforms;
+  rotated.qx = qx.data();
+  rotated.qy = qy.data();
+  rotated.qz = qz.data();
+  rotated.qw = qw.data();
+  // a camera like matrix to pre-multiply by
+  ngl::Mat4 lhs = ngl::Mat4::rotateY(30.0f) * ngl::Mat4::rotateX(20.0f);
+  lhs.m_m[3][0] = 10.0f;
+  lhs.m_m[3][1] = -5.0f;
+  lhs.m_m[3][2] = -200.0f;
+  ngl::Vec3 boundsMin(-1.0f, 0.0f, -1.0f), boundsMax(1.0f, 4.0f, 1.0f);
+
+  // the ngl::Mat4 loops the kernels replace
+  std::vector<ngl::Mat4> reference(_count), referenceProduct(_count);
+  double composeMs = simd::bestOf(
+      [&]()
+      {
+        for (size_t i = 0; i < _count; ++i)
+        {
+          reference[i] = ngl::Mat4::translate(px[i], py[i], pz[i]) * ngl::Mat4::scale(s[i], s[i], s[i]);
+        }
+      });
+  double multiplyMs = simd::bestOf(
+      [&]()
+      {
+        for (size_t i = 0; i < _count; ++i)
+        {
+          referenceProduct[i] = lhs * reference[i];
+        }
+      });
+  std::vector<float> referenceMatrices(&reference[0].m_m[0][0], &reference[0].m_m[0][0] + _count * 16);
+  std::vector<float> referenceProducts(&referenceProduct[0].m_m[0][0], &referenceProduct[0].m_m[0][0] + _count * 16);
+  std::vector<float> referenceMin, referenceMax;
+
+  auto flags = _out.flags();
+  _out << std::fixed << std::setprecision(2);
+  _out << "Batch transforms " << _count << " instances, best of 5 (CPU supports " << isaName(supported()) << ")\n";
+  _out << "  ngl::Mat4 translate * scale " << composeMs << "ms, lhs * matrix " << multiplyMs << "ms\n";
+  std::vector<float> matrices(_count * 16), products(_count * 16), minimum(_count * 4), maximum(_count * 4);
+  for (auto kernelSet : {Isa::Scalar, Isa::SSE2, Isa::AVX2})
+  {
+    if (kernelSet > supported())
+    {
+      continue;
+    }
+    setIsa(kernelSet);
+    double batchCompose = simd::bestOf([&]() { compose(transforms, matrices.data()); });
+    float composeError = maxDifference(matrices, referenceMatrices);
+    double batchRotated = simd::bestOf([&]() { compose(rotated, products.data()); });
+    double batchMultiply = simd::bestOf([&]() { multiply(lhs, matrices.data(), _count, products.data()); });
+    float multiplyError = maxDifference(products, referenceProducts);
+    double batchBounds = simd::bestOf([&]() { transformBounds(matrices.data(), _count, boundsMin, boundsMax, minimum.data(), maximum.data()); });
+    // the scalar kernels are the reference for the bounds
+    if (kernelSet == Isa::Scalar)
+    {
+      referenceMin = minimum;
+      referenceMax = maximum;
+    }
+    float boundsError = std::max(maxDifference(minimum, referenceMin), maxDifference(maximum, referenceMax));
+    _out << "  " << std::setw(6) << isaName(kernelSet) << " compose " << batchCompose << "ms (x" << composeMs / std::max(batchCompose, 1e-6)
+         << ", with rotation " << batchRotated << "ms) multiply " << batchMultiply << "ms (x" << multiplyMs / std::max(batchMultiply, 1e-6)
+         << ") bounds " << batchBounds << "ms, max error " << std::setprecision(6) << std::max({composeError, multiplyError, boundsError})
+         << std::setprecision(2) << "\n";
+  }
+  _out.flags(flags);
+  setIsa(saved);
+}
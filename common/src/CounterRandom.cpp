@@ -0,0 +1,325 @@
+#include "CounterRandom.h"
+#include "BatchTransform.h"
+#include "ProgramCache.h"
+#include "SimdTarget.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <ostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the Philox4x32 multipliers and Weyl key increments (Salmon et al. 2011), these and the
+/// round function must match shaders/CounterRandom.glsl
+//----------------------------------------------------------------------------------------------------------------------
+constexpr uint32_t c_m0 = 0xD2511F53u;
+constexpr uint32_t c_m1 = 0xCD9E8D57u;
+constexpr uint32_t c_w0 = 0x9E3779B9u;
+constexpr uint32_t c_w1 = 0xBB67AE85u;
+constexpr int c_rounds = 10;
+
+CounterRandom::Block philox(uint32_t _k0, uint32_t _k1, uint32_t _index, uint32_t _draw)
+{
+  uint32_t c0 = _index, c1 = _draw, c2 = 0, c3 = 0;
+  for (int round = 0; round < c_rounds; ++round)
+  {
+    uint64_t p0 = static_cast<uint64_t>(c_m0) * c0;
+    uint64_t p1 = static_cast<uint64_t>(c_m1) * c2;
+    uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ _k0;
+    uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ _k1;
+    c1 = static_cast<uint32_t>(p1);
+    c3 = static_cast<uint32_t>(p0);
+    c0 = n0;
+    c2 = n2;
+    _k0 += c_w0;
+    _k1 += c_w1;
+  }
+  return {c0, c1, c2, c3};
+}
+
+void fillScalar(uint32_t _seed, uint32_t _stream, uint32_t _draw, uint32_t _first, size_t _begin, size_t _end, uint32_t *o_bits)
+{
+  for (size_t i = _begin; i < _end; ++i)
+  {
+    auto block = philox(_seed, _stream, static_cast<uint32_t>(_first + i), _draw);
+    std::copy(block.begin(), block.end(), o_bits + i * 4);
+  }
+}
+
+#if defined(SIMD_X86)
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the high and low halves of _a * _m for each 32 bit lane, _mm_mul_epu32 only does the
+/// even lanes so the odd ones are shifted down and the halves shuffled back together
+//----------------------------------------------------------------------------------------------------------------------
+TARGET_SSE2 inline void mulHiLo(__m128i _a, __m128i _m, __m128i &o_hi, __m128i &o_lo)
+{
+  __m128i even = _mm_shuffle_epi32(_mm_mul_epu32(_a, _m), _MM_SHUFFLE(3, 1, 2, 0));
+  __m128i odd = _mm_shuffle_epi32(_mm_mul_epu32(_mm_srli_epi64(_a, 32), _m), _MM_SHUFFLE(3, 1, 2, 0));
+  o_lo = _mm_unpacklo_epi32(even, odd);
+  o_hi = _mm_unpackhi_epi32(even, odd);
+}
+
+TARGET_SSE2 void fillSSE2(uint32_t _seed, uint32_t _stream, uint32_t _draw, uint32_t _first, size_t _begin, size_t _end, uint32_t *o_bits)
+{
+  const __m128i m0 = _mm_set1_epi32(static_cast<int>(c_m0));
+  const __m128i m1 = _mm_set1_epi32(static_cast<int>(c_m1));
+  const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+  size_t i = _begin;
+  for (; i + 4 <= _end; i += 4)
+  {
+    // one index per lane, the key is the same for every lane
+    __m128i c0 = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(_first + i))), lanes);
+    __m128i c1 = _mm_set1_epi32(static_cast<int>(_draw));
+    __m128i c2 = _mm_setzero_si128();
+    __m128i c3 = _mm_setzero_si128();
+    uint32_t k0 = _seed, k1 = _stream;
+    for (int round = 0; round < c_rounds; ++round)
+    {
+      __m128i hi0, lo0, hi1, lo1;
+      mulHiLo(c0, m0, hi0, lo0);
+      mulHiLo(c2, m1, hi1, lo1);
+      c0 = _mm_xor_si128(_mm_xor_si128(hi1, c1), _mm_set1_epi32(static_cast<int>(k0)));
+      c1 = lo1;
+      c2 = _mm_xor_si128(_mm_xor_si128(hi0, c3), _mm_set1_epi32(static_cast<int>(k1)));
+      c3 = lo0;
+      k0 += c_w0;
+      k1 += c_w1;
+    }
+    // transpose so each index's 4 words are together
+    __m128i t0 = _mm_unpacklo_epi32(c0, c1);
+    __m128i t1 = _mm_unpacklo_epi32(c2, c3);
+    __m128i t2 = _mm_unpackhi_epi32(c0, c1);
+    __m128i t3 = _mm_unpackhi_epi32(c2, c3);
+    auto *out = reinterpret_cast<__m128i *>(o_bits + i * 4);
+    _mm_storeu_si128(out, _mm_unpacklo_epi64(t0, t1));
+    _mm_storeu_si128(out + 1, _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128(out + 2, _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128(out + 3, _mm_unpackhi_epi64(t2, t3));
+  }
+  fillScalar(_seed, _stream, _draw, _first, i, _end, o_bits);
+}
+
+TARGET_AVX2 inline void mulHiLo(__m256i _a, __m256i _m, __m256i &o_hi, __m256i &o_lo)
+{
+  __m256i even = _mm256_shuffle_epi32(_mm256_mul_epu32(_a, _m), _MM_SHUFFLE(3, 1, 2, 0));
+  __m256i odd = _mm256_shuffle_epi32(_mm256_mul_epu32(_mm256_srli_epi64(_a, 32), _m), _MM_SHUFFLE(3, 1, 2, 0));
+  o_lo = _mm256_unpacklo_epi32(even, odd);
+  o_hi = _mm256_unpackhi_epi32(even, odd);
+}
+
+TARGET_AVX2 void fillAVX2(uint32_t _seed, uint32_t _stream, uint32_t _draw, uint32_t _first, size_t _begin, size_t _end, uint32_t *o_bits)
+{
+  const __m256i m0 = _mm256_set1_epi32(static_cast<int>(c_m0));
+  const __m256i m1 = _mm256_set1_epi32(static_cast<int>(c_m1));
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  size_t i = _begin;
+  for (; i + 8 <= _end; i += 8)
+  {
+    __m256i c0 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(_first + i))), lanes);
+    __m256i c1 = _mm256_set1_epi32(static_cast<int>(_draw));
+    __m256i c2 = _mm256_setzero_si256();
+    __m256i c3 = _mm256_setzero_si256();
+    uint32_t k0 = _seed, k1 = _stream;
+    for (int round = 0; round < c_rounds; ++round)
+    {
+      __m256i hi0, lo0, hi1, lo1;
+      mulHiLo(c0, m0, hi0, lo0);
+      mulHiLo(c2, m1, hi1, lo1);
+      c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32(static_cast<int>(k0)));
+      c1 = lo1;
+      c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32(static_cast<int>(k1)));
+      c3 = lo0;
+      k0 += c_w0;
+      k1 += c_w1;
+    }
+    // the unpacks transpose within each 128 bit half, so row r holds index r and r + 4
+    __m256i t0 = _mm256_unpacklo_epi32(c0, c1);
+    __m256i t1 = _mm256_unpacklo_epi32(c2, c3);
+    __m256i t2 = _mm256_unpackhi_epi32(c0, c1);
+    __m256i t3 = _mm256_unpackhi_epi32(c2, c3);
+    __m256i r0 = _mm256_unpacklo_epi64(t0, t1);
+    __m256i r1 = _mm256_unpackhi_epi64(t0, t1);
+    __m256i r2 = _mm256_unpacklo_epi64(t2, t3);
+    __m256i r3 = _mm256_unpackhi_epi64(t2, t3);
+    auto *out = reinterpret_cast<__m256i *>(o_bits + i * 4);
+    _mm256_storeu_si256(out, _mm256_permute2x128_si256(r0, r1, 0x20));
+    _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(r2, r3, 0x20));
+    _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(r0, r1, 0x31));
+    _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(r2, r3, 0x31));
+  }
+  fillScalar(_seed, _stream, _draw, _first, i, _end, o_bits);
+}
+#endif
+
+using FillKernel = void (*)(uint32_t, uint32_t, uint32_t, uint32_t, size_t, size_t, uint32_t *);
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the kernel for the set BatchTransform is using so one setIsa switches both
+//----------------------------------------------------------------------------------------------------------------------
+FillKernel fillKernel()
+{
+#if defined(SIMD_X86)
+  switch (BatchTransform::isa())
+  {
+  case BatchTransform::Isa::AVX2:
+    return fillAVX2;
+  case BatchTransform::Isa::SSE2:
+    return fillSSE2;
+  default:
+    break;
+  }
+#endif
+  return fillScalar;
+}
+} // namespace
+
+CounterRandom::Block CounterRandom::block(uint32_t _seed, uint32_t _stream, uint32_t _index, uint32_t _draw)
+{
+  return philox(_seed, _stream, _index, _draw);
+}
+
+void CounterRandom::fill(uint32_t _seed, uint32_t _stream, uint32_t _draw, uint32_t _first, size_t _count, uint32_t *o_bits)
+{
+  fillKernel()(_seed, _stream, _draw, _first, 0, _count, o_bits);
+}
+
+void CounterRandom::fillUnit(uint32_t _seed, uint32_t _stream, uint32_t _draw, uint32_t _first, size_t _count, float *o_values)
+{
+  // a small batch at a time so the words stay in the cache for the conversion
+  constexpr size_t c_batch = 256;
+  uint32_t bits[c_batch * 4];
+  auto kernel = fillKernel();
+  for (size_t begin = 0; begin < _count; begin += c_batch)
+  {
+    size_t count = std::min(c_batch, _count - begin);
+    kernel(_seed, _stream, _draw, static_cast<uint32_t>(_first + begin), 0, count, bits);
+    for (size_t i = 0; i < count * 4; ++i)
+    {
+      o_values[begin * 4 + i] = unit(bits[i]);
+    }
+  }
+}
+
+uint32_t CounterRandom::next()
+{
+  if (m_left == 0)
+  {
+    m_block = philox(m_seed, m_stream, m_index, m_draw++);
+    m_left = 4;
+  }
+  return m_block[4 - m_left--];
+}
+
+bool CounterRandom::checkGpu(std::ostream &_out, size_t _count)
+{
+  // any key and draw will do, these are just not all zero
+  constexpr uint32_t c_seed = 1234;
+  constexpr uint32_t c_stream = 7;
+  constexpr uint32_t c_draw = 3;
+  ShaderDefines defines;
+  defines.set("CHECK_SEED", c_seed).set("CHECK_STREAM", c_stream).set("CHECK_DRAW", c_draw);
+  ProgramCache::Program program;
+  program.name = "CounterRandomCheck";
+  program.stages.push_back({ngl::ShaderType::VERTEX, ProgramCache::readSource("shaders/CounterRandomCheck.glsl", defines)});
+  program.varyings = {"bits"};
+  ProgramCache::shared().build(program);
+
+  auto bytes = static_cast<GLsizeiptr>(_count * sizeof(Block));
+  GLuint vao = 0;
+  GLuint buffer = 0;
+  glGenVertexArrays(1, &vao);
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, buffer);
+  glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, bytes, nullptr, GL_STATIC_READ);
+  // the shader only uses gl_VertexID so the VAO is empty
+  glBindVertexArray(vao);
+  glEnable(GL_RASTERIZER_DISCARD);
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffer);
+  glBeginTransformFeedback(GL_POINTS);
+  glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(_count));
+  glEndTransformFeedback();
+  glDisable(GL_RASTERIZER_DISCARD);
+  std::vector<uint32_t> gpu(_count * 4);
+  glGetBufferSubData(GL_TRANSFORM_FEEDBACK_BUFFER, 0, bytes, gpu.data());
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+  glBindVertexArray(0);
+  glDeleteBuffers(1, &buffer);
+  glDeleteVertexArrays(1, &vao);
+
+  std::vector<uint32_t> cpu(_count * 4);
+  fill(c_seed, c_stream, c_draw, 0, _count, cpu.data());
+  size_t mismatches = 0;
+  size_t first = 0;
+  for (size_t i = 0; i < cpu.size(); ++i)
+  {
+    if (cpu[i] != gpu[i] && mismatches++ == 0)
+    {
+      first = i;
+    }
+  }
+  _out << "Counter random GPU check " << _count << " indices, ";
+  if (mismatches == 0)
+  {
+    _out << "every word matches the CPU\n";
+  }
+  else
+  {
+    _out << mismatches << " words differ, the first at index " << first / 4 << " word " << first % 4 << " (CPU " << std::hex << cpu[first]
+         << " GPU " << gpu[first] << std::dec << ")\n";
+  }
+  return mismatches == 0;
+}
+
+void CounterRandom::benchmark(std::ostream &_out, size_t _count)
+{
+  // the Random123 known answers for Philox4x32-10, key (k0, k1) counter (c0, c1, c2, c3), only
+  // the ones with c2 = c3 = 0 can be given to block
+  struct Answer
+  {
+    uint32_t key[2];
+    uint32_t counter[2];
+    Block expected;
+  };
+  const Answer answers[] = {{{0u, 0u}, {0u, 0u}, {0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u}}};
+  size_t wrong = 0;
+  for (const auto &answer : answers)
+  {
+    wrong += block(answer.key[0], answer.key[1], answer.counter[0], answer.counter[1]) != answer.expected;
+  }
+  auto saved = BatchTransform::isa();
+  auto flags = _out.flags();
+  _out << std::fixed << std::setprecision(2);
+  _out << "Counter random " << _count << " indices (4 words each), best of 5, known answers " << (wrong == 0 ? "match" : "WRONG") << "\n";
+  std::vector<uint32_t> words(_count * 4);
+  std::mt19937 generator(1234);
+  double mtMs = simd::bestOf(
+      [&]()
+      {
+        for (auto &word : words)
+        {
+          word = generator();
+        }
+      });
+  _out << "  std::mt19937 (one shared state) " << mtMs << "ms\n";
+  std::vector<uint32_t> reference;
+  for (auto kernelSet : {BatchTransform::Isa::Scalar, BatchTransform::Isa::SSE2, BatchTransform::Isa::AVX2})
+  {
+    if (kernelSet > BatchTransform::supported())
+    {
+      continue;
+    }
+    BatchTransform::setIsa(kernelSet);
+    double ms = simd::bestOf([&]() { fill(1234, 0, 0, 0, _count, words.data()); });
+    if (reference.empty())
+    {
+      reference = words;
+    }
+    _out << "  " << std::setw(6) << BatchTransform::isaName(kernelSet) << " fill " << ms << "ms (x" << mtMs / std::max(ms, 1e-6) << ") "
+         << (words == reference ? "same words as scalar" : "DIFFERENT words to scalar") << "\n";
+  }
+  _out.flags(flags);
+  BatchTransform::setIsa(saved);
+}
@@ -0,0 +1,868 @@
+#include <QMouseEvent>
+#include <QGuiApplication>
+#include <QImage>
+
+#include "CubeScene.h"
+#include "BackendTuner.h"
+#include "CounterRandom.h"
+#include "InstanceLimits.h"
+#include "ProgramCache.h"
+#include <ngl/NGLInit.h>
+#include <ngl/Util.h>
+#include <algorithm>
+#include <memory>
+#include <iostream>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the increment for x/y translation with mouse movement
+//----------------------------------------------------------------------------------------------------------------------
+constexpr float INCREMENT = 0.01f;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the increment for the wheel zoom
+//----------------------------------------------------------------------------------------------------------------------
+constexpr float ZOOM = 5.0f;
+//----------------------------------------------------------------------------------------------------------------------
+/// num instances, setMaxInstances can raise this
+//----------------------------------------------------------------------------------------------------------------------
+constexpr GLuint maxinstances = 1000000;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief ms of GL start up work per progress frame
+//----------------------------------------------------------------------------------------------------------------------
+constexpr float c_startupBudgetMs = 8.0f;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief indices compared by --check-random
+//----------------------------------------------------------------------------------------------------------------------
+constexpr size_t c_randomCheckCount = 1 << 16;
+
+namespace
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the +/- step, 10000 up to a million then a tenth of the power of 10 below the count so
+/// 10M+ counts can be reached from the keyboard
+//----------------------------------------------------------------------------------------------------------------------
+GLuint instanceStep(GLuint _instances)
+{
+  GLuint step = 10000;
+  while (step * 100 <= _instances)
+  {
+    step *= 10;
+  }
+  return step;
+}
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+void CubeScene::incInstances()
+{
+  auto instances = m_generator.numInstances();
+  m_generator.setNumInstances(static_cast<GLuint>(std::min<uint64_t>(uint64_t(instances) + instanceStep(instances), m_generator.maxInstances())));
+}
+//----------------------------------------------------------------------------------------------------------------------
+void CubeScene::decInstances()
+{
+  auto instances = m_generator.numInstances();
+  if (instances > 10000)
+  {
+    auto step = instanceStep(instances - 1);
+    m_generator.setNumInstances(std::max(instances - std::min(step, instances), 10000u));
+  }
+}
+
+CubeScene::CubeScene(const char *_title, InstanceRenderer::Backend _backend) : m_generator(maxinstances), m_backend(_backend)
+{
+  setTitle(_title);
+  m_scheduler = std::make_unique<RenderScheduler>(this, &m_frameStats);
+}
+
+CubeScene::~CubeScene()
+{
+  // a window closed while loading has to wait for the worker stages before anything is torn down
+  m_startup.cancel();
+  std::cout << "Shutting down NGL, removing VAO's and Shaders\n";
+  // dump the full frame time distribution so we can look at the tail
+  m_frameStats.printSummary(std::cout);
+  m_frameStats.writeHistogram("frametimes.csv");
+  m_scheduler->printSummary(std::cout);
+  if (m_generator.stream().stats().frames > 0)
+  {
+    m_generator.stream().printSummary(std::cout);
+  }
+  auto &memory = MemoryRegistry::shared();
+  memory.printSummary(std::cout);
+  if (!m_memoryReport.empty())
+  {
+    auto driver = MemoryRegistry::driverMemory();
+    if (!memory.writeJson(m_memoryReport, &driver))
+    {
+      std::cerr << "Unable to write memory report " << m_memoryReport << "\n";
+    }
+  }
+  glDeleteVertexArrays(1, &m_vaoID);
+  memory.release(this);
+}
+
+void CubeScene::addOptions(QCommandLineParser &io_parser)
+{
+  // command line options for benchmarking
+  io_parser.addOptions({
+      {"frame-budget", "frame time in ms above which a frame counts as a stutter", "ms", "16.67"},
+      {"render-mode", "continuous (vsync), ondemand (only on input) or benchmark (uncapped)", "mode", "continuous"},
+      {"backend", "instancing backend to start with tbo, ubo or divisor", "backend"},
+      {"encoding", "instance matrix layout mat4 or affine (3 rows)", "encoding"},
+      {"instances", "number of instances to start with", "count"},
+      {"max-instances", "size of the point cloud, past the driver limits the instances are drawn in chunks", "count", "1000000"},
+      {"autotune", "benchmark every backend and encoding at startup and use the fastest, the choice is cached per GPU / driver"},
+      {"retune", "as --autotune but ignore any cached choice"},
+      {"source", "compute the matrices on the GPU (feedback) or the CPU (stream)", "source", "feedback"},
+      {"stream-regions", "frames of ring buffer space for the CPU stream", "count", "3"},
+      {"record", "record the camera / instance count / backend changes to a file", "file"},
+      {"replay", "replay a recording on the same frame schedule", "file"},
+      {"quit-after-replay", "exit once the replay has finished"},
+      {"depth-prepass", "draw the instances depth only before the textured pass (P toggles)"},
+      {"point-format", "how the point cloud is stored float, unorm16, packed (10:10:10:2) or generated (from the index in the shader)", "format",
+       "float"},
+      {"views", "number of views drawn in one instanced draw (V cycles)", "count", "1"},
+      {"memory-report", "write the CPU / GPU memory accounting as JSON on exit", "file"},
+      {"no-program-cache", "always compile the shaders rather than loading the cached program binaries"},
+      {"program-cache", "directory for the cached program binaries", "dir", "programcache"},
+      {"startup-trace", "write the start up stages as a Chrome trace", "file"},
+      {"blocking-startup", "finish the start up in initializeGL rather than showing progress frames"},
+      {"check-random", "check the shader counter random numbers match the CPU at start up"},
+  });
+}
+
+bool CubeScene::applyOptions(const QCommandLineParser &_parser)
+{
+  // the programs are built in initializeGL so the cache is set up before the window is shown
+  ProgramCache::shared().setEnabled(!_parser.isSet("no-program-cache"));
+  ProgramCache::shared().setDirectory(_parser.value("program-cache").toStdString());
+  auto renderMode = RenderScheduler::modeFromName(_parser.value("render-mode").toStdString());
+  // benchmark mode runs uncapped, the others are paced by vsync
+  auto surfaceFormat = format();
+  surfaceFormat.setSwapInterval(RenderScheduler::swapInterval(renderMode));
+  setFormat(surfaceFormat);
+  setFrameBudget(_parser.value("frame-budget").toFloat());
+  setRenderMode(renderMode);
+  if (_parser.isSet("backend"))
+  {
+    setBackend(InstanceRenderer::backendFromName(_parser.value("backend").toStdString()));
+  }
+  if (_parser.isSet("encoding"))
+  {
+    setEncoding(InstanceRenderer::encodingFromName(_parser.value("encoding").toStdString()));
+  }
+  setMaxInstances(_parser.value("max-instances").toUInt());
+  if (_parser.isSet("instances"))
+  {
+    setNumInstances(_parser.value("instances").toUInt());
+  }
+  setSource(InstanceGenerator::sourceFromName(_parser.value("source").toStdString()), _parser.value("stream-regions").toUInt());
+  if (_parser.isSet("record"))
+  {
+    recordInput(_parser.value("record").toStdString());
+  }
+  if (_parser.isSet("replay") && !replayInput(_parser.value("replay").toStdString(), _parser.isSet("quit-after-replay")))
+  {
+    return false;
+  }
+  setPointFormat(InstanceGenerator::pointFormatFromName(_parser.value("point-format").toStdString()));
+  setDepthPrepass(_parser.isSet("depth-prepass"));
+  setViews(_parser.value("views").toUInt());
+  if (_parser.isSet("memory-report"))
+  {
+    setMemoryReport(_parser.value("memory-report").toStdString());
+  }
+  if (_parser.isSet("startup-trace"))
+  {
+    setStartupTrace(_parser.value("startup-trace").toStdString());
+  }
+  setProgressiveStartup(!_parser.isSet("blocking-startup"));
+  setCheckRandom(_parser.isSet("check-random"));
+  setAutoTune(_parser.isSet("autotune") || _parser.isSet("retune"), _parser.isSet("retune"));
+  return true;
+}
+
+void CubeScene::setFrameBudget(float _ms)
+{
+  m_frameStats.setBudget(_ms);
+}
+
+void CubeScene::setRenderMode(RenderScheduler::Mode _mode)
+{
+  m_scheduler->setMode(_mode);
+}
+
+void CubeScene::setBackend(InstanceRenderer::Backend _backend)
+{
+  m_backend = _backend;
+  m_scheduler->markDirty();
+}
+
+void CubeScene::setEncoding(InstanceRenderer::Encoding _encoding)
+{
+  m_generator.setEncoding(_encoding);
+  m_scheduler->markDirty();
+}
+
+void CubeScene::setMaxInstances(GLuint _count)
+{
+  m_generator.setMaxInstances(_count);
+}
+
+void CubeScene::setNumInstances(GLuint _count)
+{
+  m_generator.setNumInstances(_count);
+  m_scheduler->markDirty();
+}
+
+void CubeScene::setSource(InstanceGenerator::Source _source, GLuint _regions)
+{
+  m_generator.setSource(_source);
+  m_generator.stream().setRegions(_regions);
+  m_scheduler->markDirty();
+}
+
+void CubeScene::setAutoTune(bool _enable, bool _force)
+{
+  m_autoTune = _enable;
+  m_forceTune = _force;
+}
+
+void CubeScene::setDepthPrepass(bool _enable)
+{
+  m_depthPrepass = _enable;
+  m_scheduler->markDirty();
+}
+
+void CubeScene::setViews(GLuint _views)
+{
+  m_views = std::max(_views, 1u);
+  m_scheduler->markDirty();
+}
+
+void CubeScene::recordInput(const std::string &_fileName)
+{
+  m_input.startRecording(_fileName);
+}
+
+bool CubeScene::replayInput(const std::string &_fileName, bool _quitWhenDone)
+{
+  if (!m_input.startReplay(_fileName))
+  {
+    return false;
+  }
+  m_quitAfterReplay = _quitWhenDone;
+  // keep drawing every frame so the events land on the recorded frames
+  m_scheduler->setAnimating(true);
+  return true;
+}
+
+void CubeScene::syncInput()
+{
+  m_input.beginFrame();
+  if (m_input.replaying())
+  {
+    InputRecorder::Values v;
+    if (m_input.value("camera", v))
+    {
+      m_win.spinXFace = static_cast<int>(v[0]);
+      m_win.spinYFace = static_cast<int>(v[1]);
+    }
+    if (m_input.value("position", v))
+    {
+      m_modelPos.set(v[0], v[1], v[2]);
+    }
+    if (m_input.value("instances", v))
+    {
+      m_generator.setNumInstances(static_cast<GLuint>(v[0]));
+    }
+    if (m_input.value("backend", v))
+    {
+      m_backend = static_cast<InstanceRenderer::Backend>(v[0]);
+      m_generator.setEncoding(static_cast<InstanceRenderer::Encoding>(v[1]));
+      m_generator.setSource(static_cast<InstanceGenerator::Source>(v[2]));
+      m_depthPrepass = v[3] != 0.0f;
+    }
+    if (m_input.value("views", v))
+    {
+      m_views = static_cast<GLuint>(v[0]);
+    }
+    if (m_input.finished() && m_quitAfterReplay)
+    {
+      QGuiApplication::exit(EXIT_SUCCESS);
+    }
+  }
+  else if (m_input.recording())
+  {
+    m_input.record("camera", {static_cast<float>(m_win.spinXFace), static_cast<float>(m_win.spinYFace)});
+    m_input.record("position", {m_modelPos.m_x, m_modelPos.m_y, m_modelPos.m_z});
+    m_input.record("instances", {static_cast<float>(m_generator.numInstances())});
+    m_input.record("backend", {static_cast<float>(m_backend), static_cast<float>(m_generator.encoding()), static_cast<float>(m_generator.source()),
+                               m_depthPrepass ? 1.0f : 0.0f});
+    m_input.record("views", {static_cast<float>(m_views)});
+  }
+}
+
+void CubeScene::decodeTexture()
+{
+  // QImage is fine away from the GUI thread, only the upload needs the context
+  QImage image;
+  bool loaded = image.load("textures/crate.bmp");
+  if (loaded == true)
+  {
+    m_textureWidth = image.width();
+    m_textureHeight = image.height();
+
+    m_textureData.resize(static_cast<size_t>(m_textureWidth) * m_textureHeight * 3);
+    unsigned int index = 0;
+    QRgb colour;
+    for (int y = 0; y < m_textureHeight; ++y)
+    {
+      for (int x = 0; x < m_textureWidth; ++x)
+      {
+        colour = image.pixel(x, y);
+
+        m_textureData[index++] = qRed(colour);
+        m_textureData[index++] = qGreen(colour);
+        m_textureData[index++] = qBlue(colour);
+      }
+    }
+  }
+}
+
+void CubeScene::loadTexture()
+{
+  if (m_textureData.empty())
+  {
+    return;
+  }
+  glGenTextures(1, &m_textureName);
+  glActiveTexture(GL_TEXTURE0 + InstanceRenderer::c_textureUnit);
+  glBindTexture(GL_TEXTURE_2D, m_textureName);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_textureWidth, m_textureHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, m_textureData.data());
+  glGenerateMipmap(GL_TEXTURE_2D); //  Allocate the mipmaps
+  MemoryRegistry::shared().set(MemoryRegistry::Category::Textures, this, MemoryRegistry::textureBytes(m_textureWidth, m_textureHeight, 3, 0));
+  std::vector<unsigned char>().swap(m_textureData);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void CubeScene::createCube(GLfloat _scale)
+{
+
+  // vertex coords array
+  GLfloat vertices[] = {
+      -1, 1, -1, 1, 1, -1, 1, -1, -1, -1, 1, -1, -1, -1, -1, 1, -1, -1, // back
+      -1, 1, 1, 1, 1, 1, 1, -1, 1, -1, -1, 1, 1, -1, 1, -1, 1, 1,       // front
+      -1, 1, -1, 1, 1, -1, 1, 1, 1, -1, 1, 1, 1, 1, 1, -1, 1, -1,       // top
+      -1, -1, -1, 1, -1, -1, 1, -1, 1, -1, -1, 1, 1, -1, 1, -1, -1, -1, // bottom
+      -1, 1, -1, -1, 1, 1, -1, -1, -1, -1, -1, -1, -1, -1, 1, -1, 1, 1, // left
+      1, 1, -1, 1, 1, 1, 1, -1, -1, 1, -1, -1, 1, -1, 1, 1, 1, 1,       // left
+
+  };
+  GLfloat texture[] = {
+      0, 0, 0, 1, 1, 1, 0, 0, 1, 0, 1, 1, // back
+      0, 1, 1, 0, 1, 1, 0, 0, 1, 0, 0, 1, // front
+      0, 0, 1, 0, 1, 1, 0, 1, 1, 1, 0, 0, // top
+      0, 0, 1, 0, 1, 1, 0, 1, 1, 1, 0, 0, // bottom
+      1, 0, 1, 1, 0, 0, 0, 0, 0, 1, 1, 1, // left
+      1, 0, 1, 1, 0, 0, 0, 0, 0, 1, 1, 1, // right
+
+  };
+
+  // first we scale our vertices to _scale
+  for (unsigned int i = 0; i < sizeof(vertices) / sizeof(GLfloat); ++i)
+  {
+    vertices[i] *= _scale;
+  }
+
+  glGenVertexArrays(1, &m_vaoID);
+
+  // now bind this to be the currently active one
+  glBindVertexArray(m_vaoID);
+  // now we create two VBO's one for each of the objects these are only used here
+  // as they will be associated with the vertex array object
+  GLuint vboID[2];
+  glGenBuffers(2, &vboID[0]);
+  // now we will bind an array buffer to the first one and load the data for the verts
+  glBindBuffer(GL_ARRAY_BUFFER, vboID[0]);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+  // now we bind the vertex attribute pointer for this object in this case the
+  // vertex data
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+  glEnableVertexAttribArray(0);
+  // now we repeat for the UV data using the second VBO
+  glBindBuffer(GL_ARRAY_BUFFER, vboID[1]);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(texture), texture, GL_STATIC_DRAW);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+  glEnableVertexAttribArray(1);
+  glBindVertexArray(0);
+  MemoryRegistry::shared().set(MemoryRegistry::Category::Meshes, this, sizeof(vertices) + sizeof(texture));
+}
+
+void CubeScene::resizeGL(int _w, int _h)
+{
+  m_project = ngl::perspective(45.0f, static_cast<float>(_w) / _h, 0.05f, 350.0f);
+  m_win.width = static_cast<int>(_w * devicePixelRatio());
+  m_win.height = static_cast<int>(_h * devicePixelRatio());
+}
+
+void CubeScene::initializeGL()
+{
+  // we must call this first before any other GL commands to load and link the
+  // gl commands from the lib, if this is not done program will crash
+  ngl::NGLInit::initialize();
+
+  glClearColor(0.4f, 0.4f, 0.4f, 1.0f); // Grey Background
+  // enable depth testing for drawing
+  glEnable(GL_DEPTH_TEST);
+  // enable multisampling for smoother drawing
+  glEnable(GL_MULTISAMPLE);
+  // Now we will create a basic Camera from the graphics library
+  // This is a static camera so it only needs to be set once
+  // First create Values for the camera position
+  ngl::Vec3 from(0, 1, 220);
+  ngl::Vec3 to(0, 0, 0);
+  ngl::Vec3 up(0, 1, 0);
+
+  m_view = ngl::lookAt(from, to, up);
+  // set the shape using FOV 45 Aspect Ratio based on Width and Height
+  // The final two are near and far clipping planes
+  m_project = ngl::perspective(45.0f, 720.0f / 576.0f, 0.05f, 350.0f);
+  // the generator creates the point cloud and the feedback shader
+  // show what the driver allows and how the instances will be split
+  InstanceLimits::get().printReport(std::cout, m_generator.maxInstances());
+  // an analytic estimate counted from the shader source, not a measurement. A mat4 x mat4 is 64
+  // multiply-adds, a mat4 x vec4 16 and an affine 3x4 (3 dot products) 12. The vertex shaders used
+  // to build Projection * ModelView for every vertex then transform it, now Mat4 has the projection
+  // baked in by the generator and Affine transforms with 3 dot products then the projection
+  constexpr int c_mat4Mat4 = 64;
+  constexpr int c_mat4Vec4 = 16;
+  constexpr int c_affineVec4 = 12;
+  constexpr int c_cubeVertices = 36;
+  constexpr int c_oldMads = c_mat4Mat4 + c_mat4Vec4;
+  constexpr int c_mat4Mads = c_mat4Vec4;
+  constexpr int c_affineMads = c_affineVec4 + c_mat4Vec4;
+  std::cout << fmt::format("Cube vertex transform multiply-adds per vertex (estimated from the shaders) Mat4 {} Affine {} (was {}), "
+                           "{} / {} fewer per cube\n",
+                           c_mat4Mads, c_affineMads, c_oldMads, (c_oldMads - c_mat4Mads) * c_cubeVertices,
+                           (c_oldMads - c_affineMads) * c_cubeVertices);
+  // the rest runs as a graph, the text comes first so the progress frames can show it then the
+  // point cloud and texture are made on worker threads while the programs compile
+  using Kind = StartupGraph::Kind;
+  m_startup.add("text", Kind::Gl, {},
+                [this]()
+                {
+                  m_text = std::make_unique<ngl::Text>("fonts/Arial.ttf", 14);
+                  MemoryRegistry::shared().set(MemoryRegistry::Category::Text, this, MemoryRegistry::textBytes(14));
+                  m_text->setScreenSize(width(), height());
+                  m_frameGraph = std::make_unique<FrameGraph>(10, 10, 300, 80);
+                  m_depthTimer = std::make_unique<GpuTimer>();
+                  m_colourTimer = std::make_unique<GpuTimer>();
+                });
+  auto points = m_startup.add("generate points", Kind::Cpu, {}, [this]() { m_generator.createPoints(); });
+  auto decode = m_startup.add("decode texture", Kind::Cpu, {}, [this]() { decodeTexture(); });
+  std::vector<size_t> scene;
+  scene.push_back(m_startup.add("generator programs", Kind::Gl, {}, [this]() { m_generator.createPrograms(); }));
+  scene.push_back(m_startup.add("views", Kind::Gl, {}, [this]() { m_viewSet.initialize(); }));
+  // create all of the backends so we can switch between them at any time
+  for (auto backend : {InstanceRenderer::Backend::TBO, InstanceRenderer::Backend::UBO, InstanceRenderer::Backend::Divisor})
+  {
+    scene.push_back(m_startup.add(fmt::format("{} backend", InstanceRenderer::backendName(backend)), Kind::Gl, {},
+                                  [this, backend]()
+                                  {
+                                    auto &renderer = m_renderers[static_cast<size_t>(backend)];
+                                    renderer = InstanceRenderer::create(backend);
+                                    renderer->initialize();
+                                  }));
+  }
+  scene.push_back(m_startup.add("upload points", Kind::Gl, {points}, [this]() { m_generator.uploadPoints(); }));
+  // create our cube
+  scene.push_back(m_startup.add("cube", Kind::Gl, {}, [this]() { createCube(0.2f); }));
+  scene.push_back(m_startup.add("upload texture", Kind::Gl, {decode}, [this]() { loadTexture(); }));
+  if (m_checkRandom)
+  {
+    m_startup.add("check random", Kind::Gl, {}, []() { CounterRandom::checkGpu(std::cout, c_randomCheckCount); });
+  }
+  if (m_autoTune)
+  {
+    m_startup.add("tune", Kind::Gl, scene,
+                  [this]()
+                  {
+                    BackendTuner tuner;
+                    // everything else that changes which backend is fastest, a choice made for one
+                    // of these setups isn't reused for another
+                    auto settings = fmt::format("views {} prepass {} points {} source {}", std::min(m_views, m_viewSet.maxViews()),
+                                                m_depthPrepass ? 1 : 0, InstanceGenerator::pointFormatName(m_generator.pointFormat()),
+                                                InstanceGenerator::sourceName(m_generator.source()));
+                    auto choice = tuner.tune(m_generator.numInstances(), settings, [this](const BackendTuner::Choice &_choice)
+                                             { drawInstances(_choice.backend, _choice.encoding); },
+                                             m_forceTune);
+                    tuner.printSummary(std::cout);
+                    m_backend = choice.backend;
+                    m_generator.setEncoding(choice.encoding);
+                  });
+  }
+  if (m_progressiveStartup)
+  {
+    m_startup.pump(c_startupBudgetMs);
+  }
+  else
+  {
+    m_startup.finish();
+    finishStartup();
+  }
+}
+
+bool CubeScene::startupFrame()
+{
+  if (m_startup.pump(c_startupBudgetMs))
+  {
+    finishStartup();
+    return false;
+  }
+  m_startup.markFirstFrame();
+  glViewport(0, 0, m_win.width, m_win.height);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  if (m_text)
+  {
+    m_text->setColour(1, 1, 0);
+    m_text->renderText(10, 700, fmt::format("starting {}/{} stages {:.0f}ms {}", m_startup.finishedStages(), m_startup.stages(),
+                                            m_startup.elapsedMs(), m_startup.running()));
+  }
+  // keep the frames coming whatever the render mode until it is done
+  m_scheduler->markDirty();
+  return true;
+}
+
+void CubeScene::finishStartup()
+{
+  m_startup.printTrace(std::cout);
+  if (!m_startupTrace.empty() && !m_startup.writeTrace(m_startupTrace))
+  {
+    std::cerr << "Unable to write start up trace " << m_startupTrace << "\n";
+  }
+  // how long the programs took to build and what the binary cache saved
+  ProgramCache::shared().printSummary(std::cout);
+  // the progress frames aren't part of the frame times
+  m_frameStats.resetTick();
+}
+
+void CubeScene::drawInstances(InstanceRenderer::Backend _backend, InstanceRenderer::Encoding _encoding, bool _timed)
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  // SETUP DATA
+  //----------------------------------------------------------------------------------------------------------------------
+  m_generator.setEncoding(_encoding);
+  auto &renderer = m_renderers[static_cast<size_t>(_backend)];
+  GLuint views = std::min(m_views, m_viewSet.maxViews());
+  // the grid covers whatever we are drawing into, the window or the BackendTuner's target
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  if (views > 1)
+  {
+    // the matrices stay in model space and each view has its own camera spaced around the
+    // cloud, the backend draws every instance once per view
+    m_generator.generate(ngl::Mat4(), m_mouseGlobalTX);
+    m_viewSet.layoutGrid(views, viewport[0], viewport[1], viewport[2], viewport[3]);
+    std::vector<ngl::Mat4> viewProjections(views);
+    for (GLuint i = 0; i < views; ++i)
+    {
+      viewProjections[i] = ngl::perspective(45.0f, m_viewSet.aspect(i), 0.05f, 350.0f) * m_view * ngl::Mat4::rotateY(360.0f * i / views);
+    }
+    m_viewSet.setViewProjections(viewProjections);
+    m_viewSet.bind();
+    renderer->setViews(views);
+  }
+  else
+  {
+    // Mat4 has room for the projection, multiplying it in here saves a matrix product per vertex
+    m_generator.generate(InstanceRenderer::bakesProjection(_encoding, false) ? m_project * m_view : m_view, m_mouseGlobalTX);
+    renderer->setViews(0);
+  }
+
+  //----------------------------------------------------------------------------------------------------------------------
+  // DRAW INSTANCES
+  //----------------------------------------------------------------------------------------------------------------------
+  // clear the screen and depth buffer
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  // activate the texture
+  glActiveTexture(GL_TEXTURE0 + InstanceRenderer::c_textureUnit);
+  glBindTexture(GL_TEXTURE_2D, m_textureName);
+  glPolygonMode(GL_FRONT_AND_BACK, m_polyMode);
+  // large sets come in several chunks (see InstanceLimits), each is drawn in turn
+  const auto &chunks = m_generator.chunks();
+  if (m_depthPrepass)
+  {
+    // lay down the depth with the position only shaders, then only the nearest fragment of each
+    // pixel passes GL_EQUAL so the texturing is done once per pixel
+    if (_timed)
+    {
+      m_depthTimer->begin();
+    }
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    for (const auto &chunk : chunks)
+    {
+      renderer->draw({m_vaoID, 36}, chunk, m_project, InstanceRenderer::Pass::Depth);
+    }
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    if (_timed)
+    {
+      m_depthTimer->end();
+    }
+    glDepthFunc(GL_EQUAL);
+    glDepthMask(GL_FALSE);
+  }
+  if (_timed)
+  {
+    m_colourTimer->begin();
+  }
+  for (const auto &chunk : chunks)
+  {
+    renderer->draw({m_vaoID, 36}, chunk, m_project, InstanceRenderer::Pass::Colour);
+  }
+  if (_timed)
+  {
+    m_colourTimer->end();
+  }
+  glDepthFunc(GL_LESS);
+  glDepthMask(GL_TRUE);
+  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+  if (views > 1)
+  {
+    // back to the one viewport we were given for the overlay
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  }
+  m_generator.endFrame();
+}
+
+void CubeScene::paintGL()
+{
+  if (!m_startup.finished() && startupFrame())
+  {
+    return;
+  }
+  m_scheduler->beginFrame();
+  syncInput();
+  // Rotation based on the mouse position for our global
+  // transform
+  auto rotX = ngl::Mat4::rotateX(m_win.spinXFace);
+  auto rotY = ngl::Mat4::rotateY(m_win.spinYFace);
+  // multiply the rotations
+  m_mouseGlobalTX = rotY * rotX;
+  // add the translations
+  m_mouseGlobalTX.m_m[3][0] = m_modelPos.m_x;
+  m_mouseGlobalTX.m_m[3][1] = m_modelPos.m_y;
+  m_mouseGlobalTX.m_m[3][2] = m_modelPos.m_z;
+
+  glViewport(0, 0, m_win.width, m_win.height);
+  drawInstances(m_backend, m_generator.encoding(), true);
+  GLuint instances = m_generator.numInstances();
+
+  m_text->setColour(1, 1, 0);
+  auto stats = m_frameStats.summary();
+  m_text->renderText(10, 700, fmt::format("{} Instancing {} instances Demo {:.0f} fps (1 TBO 2 UBO 3 Divisor)", InstanceRenderer::backendName(m_backend),
+                                          instances, stats.mean > 0.0f ? 1000.0f / stats.mean : 0.0f));
+  const auto &points = m_generator.pointStats();
+  m_text->renderText(10, 680, fmt::format("Num vertices = {} num triangles = {} {} matrices (E toggles) in {} chunk(s) {} points {}KB max error {:.4f}",
+                                          uint64_t(instances) * 36, uint64_t(instances) * 12, InstanceRenderer::encodingName(m_generator.encoding()),
+                                          m_generator.chunks().size(), InstanceGenerator::pointFormatName(m_generator.pointFormat()), points.bytes / 1024,
+                                          points.maxError));
+  m_text->renderText(10, 660, fmt::format("frame ms p50 {:.2f} p95 {:.2f} p99 {:.2f} max {:.2f} stutters {} (> {:.1f}ms)",
+                                          stats.p50, stats.p95, stats.p99, stats.max, stats.stutters, m_frameStats.budget()));
+  auto pacing = m_scheduler->report();
+  m_text->renderText(10, 640, fmt::format("{} mode cpu {:.0f}% pacing {:.2f}ms +/- {:.2f}ms (R toggles on demand)",
+                                          RenderScheduler::modeName(m_scheduler->mode()), pacing.cpuPercent, pacing.intervalMs, pacing.jitterMs));
+  float colourMs = m_colourTimer->latestMs();
+  float depthMs = m_depthPrepass ? m_depthTimer->latestMs() : 0.0f;
+  m_text->renderText(10, 620, fmt::format("depth pre-pass {} (P) depth {:.2f}ms colour {:.2f}ms total {:.2f}ms views {} (V)", m_depthPrepass ? "on" : "off",
+                                          depthMs, colourMs, depthMs + colourMs, std::min(m_views, m_viewSet.maxViews())));
+  if (m_generator.source() == InstanceGenerator::Source::Stream)
+  {
+    const auto &stream = m_generator.stream();
+    m_text->renderText(10, 600, fmt::format("CPU streamed {} regions fence waits {} last {:.2f}ms max {:.2f}ms (G toggles)", stream.regions(),
+                                            stream.stats().waits, stream.stats().lastWaitMs, stream.stats().maxWaitMs));
+  }
+  auto gpu = MemoryRegistry::shared().usage(MemoryRegistry::Pool::GPU);
+  auto cpu = MemoryRegistry::shared().usage(MemoryRegistry::Pool::CPU);
+  auto driver = MemoryRegistry::driverMemory();
+  m_text->renderText(10, 560, fmt::format("memory GPU {:.1f}MB (peak {:.1f}) CPU {:.1f}MB (peak {:.1f}) driver free {}", gpu.current / 1048576.0,
+                                          gpu.peak / 1048576.0, cpu.current / 1048576.0, cpu.peak / 1048576.0,
+                                          driver.availableKB >= 0 ? fmt::format("{}MB", driver.availableKB / 1024) : std::string("n/a")));
+  if (m_input.mode() != InputRecorder::Mode::Off)
+  {
+    m_text->renderText(10, 580, fmt::format("{} input frame {}", m_input.recording() ? "recording" : "replaying", m_input.frame()));
+  }
+  m_frameGraph->draw(m_frameStats, width(), height());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void CubeScene::mouseMoveEvent(QMouseEvent *_event)
+{
+// note the method buttons() is the button state when event was called
+// this is different from button() which is used to check which button was
+// pressed when the mousePress/Release event is generated
+#if QT_VERSION > QT_VERSION_CHECK(6, 0, 0)
+  auto position = _event->position();
+#else
+  auto position = _event->pos();
+#endif
+  if (m_win.rotate && _event->buttons() == Qt::LeftButton)
+  {
+    int diffx = position.x() - m_win.origX;
+    int diffy = position.y() - m_win.origY;
+    m_win.spinXFace += static_cast<int>(0.5f * diffy);
+    m_win.spinYFace += static_cast<int>(0.5f * diffx);
+    m_win.origX = position.x();
+    m_win.origY = position.y();
+    m_scheduler->markDirty();
+  }
+  // right mouse translate code
+  else if (m_win.translate && _event->buttons() == Qt::RightButton)
+  {
+    int diffX = static_cast<int>(position.x() - m_win.origXPos);
+    int diffY = static_cast<int>(position.y() - m_win.origYPos);
+    m_win.origXPos = position.x();
+    m_win.origYPos = position.y();
+    m_modelPos.m_x += INCREMENT * diffX;
+    m_modelPos.m_y -= INCREMENT * diffY;
+    m_scheduler->markDirty();
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void CubeScene::mousePressEvent(QMouseEvent *_event)
+{
+// this method is called when the mouse button is pressed in this case we
+// store the value where the maouse was clicked (x,y) and set the Rotate flag to true
+#if QT_VERSION > QT_VERSION_CHECK(6, 0, 0)
+  auto position = _event->position();
+#else
+  auto position = _event->pos();
+#endif
+  if (_event->button() == Qt::LeftButton)
+  {
+    m_win.origX = position.x();
+    m_win.origY = position.y();
+    m_win.rotate = true;
+  }
+  // right mouse translate mode
+  else if (_event->button() == Qt::RightButton)
+  {
+    m_win.origXPos = position.x();
+    m_win.origYPos = position.y();
+    m_win.translate = true;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void CubeScene::mouseReleaseEvent(QMouseEvent *_event)
+{
+  // this event is called when the mouse button is released
+  // we then set Rotate to false
+  if (_event->button() == Qt::LeftButton)
+  {
+    m_win.rotate = false;
+  }
+  // right mouse translate mode
+  if (_event->button() == Qt::RightButton)
+  {
+    m_win.translate = false;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void CubeScene::wheelEvent(QWheelEvent *_event)
+{
+
+  // check the diff of the wheel position (0 means no change)
+  if (_event->angleDelta().y() > 0)
+  {
+    m_modelPos.m_z += ZOOM;
+  }
+  else if (_event->angleDelta().y() < 0)
+  {
+    m_modelPos.m_z -= ZOOM;
+  }
+  m_scheduler->markDirty();
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+void CubeScene::keyPressEvent(QKeyEvent *_event)
+{
+  // this method is called every time the main window recives a key event.
+  // we then switch on the key value and set the camera in the GLWindow
+  // only quitting makes sense until the start up has made everything the keys change
+  if (!m_startup.finished() && _event->key() != Qt::Key_Escape)
+  {
+    return;
+  }
+  switch (_event->key())
+  {
+  // escape key to quite
+  case Qt::Key_Escape:
+    QGuiApplication::exit(EXIT_SUCCESS);
+    break;
+  // turn on wirframe rendering
+  case Qt::Key_W:
+    m_polyMode = GL_LINE;
+    break;
+  // turn off wire frame
+  case Qt::Key_S:
+    m_polyMode = GL_FILL;
+    break;
+  // show full screen
+  case Qt::Key_F:
+    showFullScreen();
+    break;
+  // show windowed
+  case Qt::Key_N:
+    showNormal();
+    break;
+  // toggle between on demand re-draws and the mode we started in (continuous or benchmark)
+  case Qt::Key_R:
+    m_scheduler->toggleOnDemand();
+    break;
+  // switch backend on the same instance data
+  case Qt::Key_1:
+    setBackend(InstanceRenderer::Backend::TBO);
+    break;
+  case Qt::Key_2:
+    setBackend(InstanceRenderer::Backend::UBO);
+    break;
+  case Qt::Key_3:
+    setBackend(InstanceRenderer::Backend::Divisor);
+    break;
+  // switch matrix encoding
+  case Qt::Key_E:
+    setEncoding(m_generator.encoding() == InstanceRenderer::Encoding::Mat4 ? InstanceRenderer::Encoding::Affine : InstanceRenderer::Encoding::Mat4);
+    break;
+  // switch between GPU generated and CPU streamed matrices
+  case Qt::Key_G:
+    setSource(m_generator.source() == InstanceGenerator::Source::Feedback ? InstanceGenerator::Source::Stream : InstanceGenerator::Source::Feedback,
+              m_generator.stream().regions());
+    break;
+  // toggle the depth pre-pass
+  case Qt::Key_P:
+    setDepthPrepass(!m_depthPrepass);
+    break;
+  // cycle the number of views 1,2,4,8
+  case Qt::Key_V:
+    setViews(m_views * 2 <= m_viewSet.maxViews() ? m_views * 2 : 1);
+    break;
+  case Qt::Key_Equal:
+    incInstances();
+    break;
+  case Qt::Key_Minus:
+    decInstances();
+    break;
+
+  default:
+    break;
+  }
+  // finally update the GLWindow and re-draw
+  m_scheduler->markDirty();
+}
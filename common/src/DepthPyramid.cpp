@@ -0,0 +1,94 @@
+#include "DepthPyramid.h"
+#include "MemoryRegistry.h"
+#include "ProgramCache.h"
+#include <ngl/ShaderLib.h>
+#include <algorithm>
+
+constexpr auto c_program = "HiZDownsample";
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the work group is c_tileSize x c_tileSize texels of the level being written
+//----------------------------------------------------------------------------------------------------------------------
+constexpr GLint c_tileSize = 8;
+
+DepthPyramid::DepthPyramid(GLsizei _width, GLsizei _height) : m_width(_width), m_height(_height)
+{
+}
+
+DepthPyramid::~DepthPyramid()
+{
+  glDeleteFramebuffers(1, &m_fbo);
+  glDeleteTextures(1, &m_depth);
+  glDeleteTextures(1, &m_pyramid);
+  MemoryRegistry::shared().release(this);
+}
+
+void DepthPyramid::initialize()
+{
+  ProgramCache::shared().build({c_program, {{ngl::ShaderType::COMPUTE, ProgramCache::readSource("shaders/HiZDownsample.glsl", ShaderDefines().set("TILE_SIZE", c_tileSize))}}, {}, {}});
+  ngl::ShaderLib::setUniform("depth", 0);
+
+  // depth target for the occluders
+  glGenTextures(1, &m_depth);
+  glBindTexture(GL_TEXTURE_2D, m_depth);
+  glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, m_width, m_height);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glGenFramebuffers(1, &m_fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depth, 0);
+  // depth only
+  glDrawBuffer(GL_NONE);
+  glReadBuffer(GL_NONE);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  // the pyramid, a full mip chain down to 1x1
+  m_levels = 1;
+  for (GLsizei size = std::max(m_width, m_height); size > 1; size /= 2)
+  {
+    ++m_levels;
+  }
+  glGenTextures(1, &m_pyramid);
+  glBindTexture(GL_TEXTURE_2D, m_pyramid);
+  glTexStorage2D(GL_TEXTURE_2D, m_levels, GL_R32F, m_width, m_height);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  MemoryRegistry::shared().set(MemoryRegistry::Category::Culling, this,
+                               MemoryRegistry::textureBytes(m_width, m_height, 4) + MemoryRegistry::textureBytes(m_width, m_height, 4, m_levels));
+  m_timer = std::make_unique<GpuTimer>();
+}
+
+void DepthPyramid::bindOccluderTarget()
+{
+  m_gpuMs = m_timer->latestMs();
+  m_timer->begin();
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_savedFBO);
+  glGetIntegerv(GL_VIEWPORT, m_savedViewport);
+  glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+  glViewport(0, 0, m_width, m_height);
+  glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void DepthPyramid::build()
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(m_savedFBO));
+  glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+  ngl::ShaderLib::use(c_program);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, m_depth);
+  GLsizei width = m_width, height = m_height;
+  for (int level = 0; level < m_levels; ++level)
+  {
+    ngl::ShaderLib::setUniform("level", level);
+    glBindImageTexture(0, m_pyramid, std::max(level - 1, 0), GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+    glBindImageTexture(1, m_pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    glDispatchCompute(static_cast<GLuint>((width + c_tileSize - 1) / c_tileSize), static_cast<GLuint>((height + c_tileSize - 1) / c_tileSize), 1);
+    // the next level reads what we just wrote
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    width = std::max(width / 2, 1);
+    height = std::max(height / 2, 1);
+  }
+  // the culling shader samples the pyramid
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+  m_timer->end();
+}
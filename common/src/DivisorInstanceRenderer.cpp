@@ -0,0 +1,48 @@
+#include "DivisorInstanceRenderer.h"
+#include <ngl/ShaderLib.h>
+#include <ngl/Vec4.h>
+#include <algorithm>
+
+constexpr auto c_program = "DivisorInstancing";
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the first attribute of the matrix (inModelView) it takes 4 (3 for affine)
+//----------------------------------------------------------------------------------------------------------------------
+constexpr GLuint c_matrixAttrib = 2;
+
+void DivisorInstanceRenderer::initialize()
+{
+  for (auto encoding : {Encoding::Mat4, Encoding::Affine})
+  {
+    for (auto pass : c_passes)
+    {
+      for (auto multiView : c_viewModes)
+      {
+        createProgram(c_program, "shaders/DivisorVertex.glsl", encoding, pass, multiView);
+      }
+    }
+  }
+}
+
+void DivisorInstanceRenderer::draw(const Mesh &_mesh, const InstanceData &_data, const ngl::Mat4 &_project, Pass _pass)
+{
+  useProgram(c_program, _data, _project, _pass);
+  glBindVertexArray(_mesh.vao);
+  // the mesh VAO is shared with the other backends so we add the per instance
+  // attributes for the draw and remove them again afterwards
+  GLuint rows = _data.encoding == Encoding::Affine ? 3 : 4;
+  // in multi view the matrix advances once every views instances so each is drawn once per view
+  GLuint views = std::max(m_views, 1u);
+  glBindBuffer(GL_ARRAY_BUFFER, _data.buffer);
+  for (GLuint i = 0; i < rows; ++i)
+  {
+    glEnableVertexAttribArray(c_matrixAttrib + i);
+    glVertexAttribPointer(c_matrixAttrib + i, 4, GL_FLOAT, GL_FALSE, stride(_data.encoding), reinterpret_cast<void *>(_data.offset + i * sizeof(ngl::Vec4)));
+    glVertexAttribDivisor(c_matrixAttrib + i, views);
+  }
+  glDrawArraysInstanced(GL_TRIANGLES, 0, _mesh.numVerts, _data.count * views);
+  for (GLuint i = 0; i < rows; ++i)
+  {
+    glDisableVertexAttribArray(c_matrixAttrib + i);
+  }
+  glBindVertexArray(0);
+}
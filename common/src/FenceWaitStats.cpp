@@ -0,0 +1,27 @@
+#include "FenceWaitStats.h"
+#include <algorithm>
+#include <chrono>
+
+float FenceWaitStats::wait(unsigned _region, Fence &_fence)
+{
+  // only count it as a wait if the GPU isn't done yet
+  if (_fence.signalled())
+  {
+    m_stats.lastWaitMs = 0.0f;
+    return 0.0f;
+  }
+  auto start = std::chrono::steady_clock::now();
+  _fence.block();
+  float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+  ++m_stats.waits;
+  m_stats.totalWaitMs += ms;
+  m_stats.maxWaitMs = std::max(m_stats.maxWaitMs, ms);
+  m_stats.lastWaitMs = ms;
+  m_stats.lastWaitRegion = static_cast<int>(_region);
+  if (m_stats.regionWaits.size() <= _region)
+  {
+    m_stats.regionWaits.resize(_region + 1);
+  }
+  ++m_stats.regionWaits[_region];
+  return ms;
+}
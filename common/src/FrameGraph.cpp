@@ -0,0 +1,63 @@
+#include "FrameGraph.h"
+#include <ngl/ShaderLib.h>
+#include <ngl/SimpleVAO.h>
+#include <ngl/Util.h>
+#include <ngl/VAOFactory.h>
+#include <ngl/Vec3.h>
+#include <algorithm>
+#include <vector>
+
+FrameGraph::FrameGraph(int _x, int _y, int _width, int _height, float _maxMs)
+    : m_x(_x), m_y(_y), m_width(std::min(_width, static_cast<int>(FrameStats::c_historySize))), m_height(_height), m_maxMs(_maxMs)
+{
+  m_graphVAO = ngl::VAOFactory::createVAO(ngl::simpleVAO, GL_LINE_STRIP);
+  m_budgetVAO = ngl::VAOFactory::createVAO(ngl::simpleVAO, GL_LINES);
+}
+
+void FrameGraph::draw(const FrameStats &_stats, int _screenWidth, int _screenHeight)
+{
+  std::vector<float> frames(m_width);
+  auto n = _stats.history(frames.data(), frames.size());
+  if (n < 2)
+  {
+    return;
+  }
+  auto toY = [this](float _ms)
+  { return m_y + std::min(_ms / m_maxMs, 1.0f) * m_height; };
+
+  std::vector<ngl::Vec3> points(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    points[i].set(static_cast<float>(m_x + i), toY(frames[i]), 0.0f);
+  }
+  float budgetY = toY(_stats.budget());
+  std::vector<ngl::Vec3> lines = {
+      {static_cast<float>(m_x), budgetY, 0.0f}, {static_cast<float>(m_x + m_width), budgetY, 0.0f},
+      {static_cast<float>(m_x), static_cast<float>(m_y), 0.0f}, {static_cast<float>(m_x + m_width), static_cast<float>(m_y), 0.0f}};
+
+  GLboolean depth = glIsEnabled(GL_DEPTH_TEST);
+  glDisable(GL_DEPTH_TEST);
+  ngl::ShaderLib::use(ngl::nglColourShader);
+  ngl::ShaderLib::setUniform("MVP", ngl::ortho(0.0f, static_cast<float>(_screenWidth), 0.0f, static_cast<float>(_screenHeight), -1.0f, 1.0f));
+
+  ngl::ShaderLib::setUniform("Colour", 1.0f, 0.2f, 0.2f, 1.0f);
+  m_budgetVAO->bind();
+  m_budgetVAO->setData(ngl::SimpleVAO::VertexData(lines.size() * sizeof(ngl::Vec3), lines[0].m_x, GL_STREAM_DRAW));
+  m_budgetVAO->setVertexAttributePointer(0, 3, GL_FLOAT, 0, 0);
+  m_budgetVAO->setNumIndices(lines.size());
+  m_budgetVAO->draw();
+  m_budgetVAO->unbind();
+
+  ngl::ShaderLib::setUniform("Colour", 0.2f, 1.0f, 0.2f, 1.0f);
+  m_graphVAO->bind();
+  m_graphVAO->setData(ngl::SimpleVAO::VertexData(points.size() * sizeof(ngl::Vec3), points[0].m_x, GL_STREAM_DRAW));
+  m_graphVAO->setVertexAttributePointer(0, 3, GL_FLOAT, 0, 0);
+  m_graphVAO->setNumIndices(points.size());
+  m_graphVAO->draw();
+  m_graphVAO->unbind();
+
+  if (depth)
+  {
+    glEnable(GL_DEPTH_TEST);
+  }
+}
@@ -0,0 +1,182 @@
+#include "FrameStats.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+FrameStats::FrameStats(float _budgetMs) : m_budget(_budgetMs)
+{
+  for (auto &f : m_ring)
+  {
+    f.store(0.0f, std::memory_order_relaxed);
+  }
+  for (auto &b : m_histogram)
+  {
+    b.store(0, std::memory_order_relaxed);
+  }
+}
+
+void FrameStats::tick()
+{
+  auto now = std::chrono::steady_clock::now();
+  if (m_haveTick)
+  {
+    addFrame(std::chrono::duration<float, std::milli>(now - m_lastTick).count());
+  }
+  m_lastTick = now;
+  m_haveTick = true;
+}
+
+void FrameStats::resetTick()
+{
+  m_haveTick = false;
+}
+
+void FrameStats::addFrame(float _ms)
+{
+  // single writer so we only need to publish the head once the slot is filled
+  auto head = m_head.load(std::memory_order_relaxed);
+  m_ring[head & (c_historySize - 1)].store(_ms, std::memory_order_relaxed);
+  m_head.store(head + 1, std::memory_order_release);
+
+  auto bin = std::min(static_cast<size_t>(_ms / c_binWidth), c_numBins - 1);
+  m_histogram[bin].fetch_add(1, std::memory_order_relaxed);
+  if (_ms > m_budget.load(std::memory_order_relaxed))
+  {
+    m_stutters.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (_ms > m_maxFrame.load(std::memory_order_relaxed))
+  {
+    m_maxFrame.store(_ms, std::memory_order_relaxed);
+  }
+}
+
+void FrameStats::setBudget(float _ms)
+{
+  m_budget.store(_ms, std::memory_order_relaxed);
+}
+
+float FrameStats::budget() const
+{
+  return m_budget.load(std::memory_order_relaxed);
+}
+
+size_t FrameStats::history(float *_out, size_t _count) const
+{
+  auto head = m_head.load(std::memory_order_acquire);
+  size_t n = std::min({_count, c_historySize, static_cast<size_t>(head)});
+  for (size_t i = 0; i < n; ++i)
+  {
+    _out[i] = m_ring[(head - n + i) & (c_historySize - 1)].load(std::memory_order_relaxed);
+  }
+  return n;
+}
+
+FrameStats::Summary FrameStats::summary() const
+{
+  std::array<float, c_historySize> frames;
+  Summary s;
+  s.frames = history(frames.data(), c_historySize);
+  if (s.frames == 0)
+  {
+    return s;
+  }
+  auto begin = frames.begin();
+  auto end = begin + s.frames;
+  float budget = m_budget.load(std::memory_order_relaxed);
+  float total = 0.0f;
+  for (auto f = begin; f != end; ++f)
+  {
+    total += *f;
+    s.max = std::max(s.max, *f);
+    if (*f > budget)
+    {
+      ++s.stutters;
+    }
+  }
+  s.mean = total / s.frames;
+  // nth_element partitions the range so each later query only needs to search the top part
+  auto percentile = [&](float _p, decltype(begin) _from)
+  {
+    auto nth = begin + std::min(static_cast<size_t>(_p * s.frames), s.frames - 1);
+    std::nth_element(_from, nth, end);
+    return nth;
+  };
+  auto p50 = percentile(0.50f, begin);
+  auto p95 = percentile(0.95f, p50);
+  auto p99 = percentile(0.99f, p95);
+  s.p50 = *p50;
+  s.p95 = *p95;
+  s.p99 = *p99;
+  return s;
+}
+
+uint64_t FrameStats::totalFrames() const
+{
+  return m_head.load(std::memory_order_acquire);
+}
+
+uint64_t FrameStats::totalStutters() const
+{
+  return m_stutters.load(std::memory_order_relaxed);
+}
+
+float FrameStats::totalPercentile(float _p) const
+{
+  uint64_t total = totalFrames();
+  if (total == 0)
+  {
+    return 0.0f;
+  }
+  auto target = static_cast<uint64_t>(_p * (total - 1));
+  uint64_t count = 0;
+  for (size_t i = 0; i < c_numBins; ++i)
+  {
+    count += m_histogram[i].load(std::memory_order_relaxed);
+    if (count > target)
+    {
+      // report the upper edge of the bin so we never under report the time, the last bin
+      // collects everything slower so its edge is the longest frame seen
+      return i + 1 == c_numBins ? m_maxFrame.load(std::memory_order_relaxed) : (i + 1) * c_binWidth;
+    }
+  }
+  return m_maxFrame.load(std::memory_order_relaxed);
+}
+
+void FrameStats::printSummary(std::ostream &_out) const
+{
+  auto total = totalFrames();
+  _out << "Frame times over " << total << " frames (ms)\n";
+  if (total == 0)
+  {
+    return;
+  }
+  _out << std::fixed << std::setprecision(2)
+       << "p50 " << totalPercentile(0.50f)
+       << " p95 " << totalPercentile(0.95f)
+       << " p99 " << totalPercentile(0.99f)
+       << " p99.9 " << totalPercentile(0.999f)
+       << " max " << m_maxFrame.load(std::memory_order_relaxed) << '\n'
+       << "stutters (> " << budget() << "ms) " << totalStutters()
+       << " (" << 100.0 * totalStutters() / total << "%)\n";
+}
+
+bool FrameStats::writeHistogram(std::string_view _fname) const
+{
+  std::ofstream file(std::string(_fname).c_str());
+  if (!file.is_open())
+  {
+    return false;
+  }
+  file << "bin_ms,count\n";
+  for (size_t i = 0; i < c_numBins; ++i)
+  {
+    auto count = m_histogram[i].load(std::memory_order_relaxed);
+    if (count != 0)
+    {
+      file << i * c_binWidth << ',' << count << '\n';
+    }
+  }
+  return true;
+}
@@ -0,0 +1,75 @@
+#include "GpuTimer.h"
+
+GpuTimer::GpuTimer(GLenum _target) : m_target(_target)
+{
+  glGenQueries(static_cast<GLsizei>(c_numQueries), m_queries.data());
+}
+
+GpuTimer::~GpuTimer()
+{
+  glDeleteQueries(static_cast<GLsizei>(c_numQueries), m_queries.data());
+}
+
+void GpuTimer::begin()
+{
+  m_current = (m_current + 1) % c_numQueries;
+  // the oldest query is a few frames old so this will hardly ever wait
+  if (m_pending[m_current])
+  {
+    collect(m_current);
+  }
+  glBeginQuery(m_target, m_queries[m_current]);
+}
+
+void GpuTimer::end()
+{
+  glEndQuery(m_target);
+  m_pending[m_current] = true;
+}
+
+bool GpuTimer::available() const
+{
+  GLint available = 0;
+  glGetQueryObjectiv(m_queries[m_current], GL_QUERY_RESULT_AVAILABLE, &available);
+  return available != 0;
+}
+
+void GpuTimer::collect(size_t _index)
+{
+  glGetQueryObjectui64v(m_queries[_index], GL_QUERY_RESULT, &m_latest);
+  m_pending[_index] = false;
+}
+
+float GpuTimer::elapsedMs()
+{
+  if (m_pending[m_current])
+  {
+    collect(m_current);
+  }
+  return static_cast<float>(m_latest) / 1.0e6f;
+}
+
+float GpuTimer::latestMs()
+{
+  return static_cast<float>(latestValue()) / 1.0e6f;
+}
+
+GLuint64 GpuTimer::latestValue()
+{
+  // walk from the oldest to the newest so m_latest ends up as the newest finished result
+  for (size_t i = 1; i <= c_numQueries; ++i)
+  {
+    size_t index = (m_current + i) % c_numQueries;
+    if (m_pending[index])
+    {
+      GLint available = 0;
+      glGetQueryObjectiv(m_queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+      if (available == 0)
+      {
+        break;
+      }
+      collect(index);
+    }
+  }
+  return m_latest;
+}
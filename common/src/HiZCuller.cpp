@@ -0,0 +1,154 @@
+#include "HiZCuller.h"
+#include "MemoryRegistry.h"
+#include "ProgramCache.h"
+#include <ngl/ShaderLib.h>
+
+constexpr auto c_program = "HiZCull";
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief layout of the command buffer, a DrawArraysIndirectCommand followed by the culled counts
+/// then the DrawArraysIndirectCommand for the far list
+//----------------------------------------------------------------------------------------------------------------------
+constexpr GLuint c_commandSize = 10;
+constexpr GLuint c_farCommand = 6;
+constexpr GLuint c_localSize = 64;
+constexpr GLint c_orderUnit = 3;
+
+HiZCuller::~HiZCuller()
+{
+  glDeleteTextures(1, &m_visibleTBO);
+  glDeleteTextures(1, &m_farTBO);
+  glDeleteBuffers(1, &m_visible);
+  glDeleteBuffers(1, &m_far);
+  glDeleteBuffers(1, &m_command);
+  glDeleteBuffers(static_cast<GLsizei>(c_readbackLatency), m_readback.data());
+  MemoryRegistry::shared().release(this);
+}
+
+bool HiZCuller::supported()
+{
+  GLint major = 0, minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  return major > 4 || (major == 4 && minor >= 3);
+}
+
+void HiZCuller::initialize(GLuint _maxInstances)
+{
+  ProgramCache::shared().build({c_program, {{ngl::ShaderType::COMPUTE, ProgramCache::readSource("shaders/HiZCull.glsl", ShaderDefines().set("LOCAL_SIZE", c_localSize))}}, {}, {}});
+  // the instance TBO is on unit 0, the pyramid on unit 2 and the order on unit 3
+  ngl::ShaderLib::setUniform("instances", 0);
+  ngl::ShaderLib::setUniform("hiz", 2);
+  ngl::ShaderLib::setUniform("order", c_orderUnit);
+
+  glGenBuffers(1, &m_visible);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_visible);
+  glBufferStorage(GL_SHADER_STORAGE_BUFFER, std::max(_maxInstances, 1u) * sizeof(GLuint), nullptr, 0);
+  glGenTextures(1, &m_visibleTBO);
+  glBindTexture(GL_TEXTURE_BUFFER, m_visibleTBO);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, m_visible);
+  glGenBuffers(1, &m_far);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_far);
+  glBufferStorage(GL_SHADER_STORAGE_BUFFER, std::max(_maxInstances, 1u) * sizeof(GLuint), nullptr, 0);
+  glGenTextures(1, &m_farTBO);
+  glBindTexture(GL_TEXTURE_BUFFER, m_farTBO);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, m_far);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+  glGenBuffers(1, &m_command);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_command);
+  glBufferStorage(GL_SHADER_STORAGE_BUFFER, c_commandSize * sizeof(GLuint), nullptr, GL_DYNAMIC_STORAGE_BIT);
+  glGenBuffers(static_cast<GLsizei>(c_readbackLatency), m_readback.data());
+  for (auto buffer : m_readback)
+  {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, c_commandSize * sizeof(GLuint), nullptr, GL_CLIENT_STORAGE_BIT);
+  }
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  // the near / far id lists, the command buffer and its readback copies
+  MemoryRegistry::shared().set(MemoryRegistry::Category::Culling, this,
+                               2 * static_cast<int64_t>(std::max(_maxInstances, 1u)) * sizeof(GLuint) + (c_readbackLatency + 1) * c_commandSize * sizeof(GLuint));
+  m_timer = std::make_unique<GpuTimer>();
+}
+
+void HiZCuller::setLodRange(float _near, float _far)
+{
+  m_lodNear = _near;
+  m_lodFar = _far;
+}
+
+void HiZCuller::cull(GLuint _instances, GLuint _count, GLuint _numVerts, const ngl::Mat4 &_project, const ngl::Mat4 &_view, const ngl::Vec3 &_boundsMin,
+                     const ngl::Vec3 &_boundsMax, const DepthPyramid *_pyramid)
+{
+  m_gpuMs = m_timer->latestMs();
+  // pick up the counts from a few frames ago, by now the GPU is done with them so this won't stall
+  size_t slot = m_frame % c_readbackLatency;
+  if (m_frame >= c_readbackLatency)
+  {
+    GLuint counts[c_commandSize];
+    glBindBuffer(GL_COPY_READ_BUFFER, m_readback[slot]);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(counts), counts);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    m_stats.tested = m_readbackTested[slot];
+    m_stats.visible = counts[1];
+    m_stats.frustumCulled = counts[4];
+    m_stats.occluded = counts[5];
+    m_stats.impostors = counts[c_farCommand + 1];
+  }
+
+  m_timer->begin();
+  // reset the commands, instanceCount is the append counter, the far list draws 4 vertex quads
+  GLuint reset[c_commandSize] = {_numVerts, 0, 0, 0, 0, 0, 4, 0, 0, 0};
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_command);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(reset), reset);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  ngl::ShaderLib::use(c_program);
+  ngl::ShaderLib::setUniform("VP", _project * _view);
+  ngl::ShaderLib::setUniform("View", _view);
+  ngl::ShaderLib::setUniform("lodRange", m_lodNear, m_lodFar);
+  ngl::ShaderLib::setUniform("boundsMin", _boundsMin);
+  ngl::ShaderLib::setUniform("boundsMax", _boundsMax);
+  ngl::ShaderLib::setUniform("count", static_cast<int>(_count));
+  ngl::ShaderLib::setUniform("occlusion", _pyramid != nullptr ? 1 : 0);
+  ngl::ShaderLib::setUniform("hizLevels", _pyramid != nullptr ? _pyramid->levels() : 1);
+  ngl::ShaderLib::setUniform("ordered", m_order != 0 ? 1 : 0);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_BUFFER, _instances);
+  glActiveTexture(GL_TEXTURE2);
+  glBindTexture(GL_TEXTURE_2D, _pyramid != nullptr ? _pyramid->texture() : 0);
+  glActiveTexture(GL_TEXTURE0 + c_orderUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, m_order);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_visible);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_command);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_far);
+  glDispatchCompute((_count + c_localSize - 1) / c_localSize, 1, 1);
+  // the draw reads the command and the vertex shader the ids
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+  m_timer->end();
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+
+  glBindBuffer(GL_COPY_READ_BUFFER, m_command);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, m_readback[slot]);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, c_commandSize * sizeof(GLuint));
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  m_readbackTested[slot] = _count;
+  ++m_frame;
+}
+
+void HiZCuller::draw() const
+{
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_command);
+  glDrawArraysIndirect(GL_TRIANGLES, nullptr);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void HiZCuller::drawFar() const
+{
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_command);
+  glDrawArraysIndirect(GL_TRIANGLE_STRIP, reinterpret_cast<const void *>(c_farCommand * sizeof(GLuint)));
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
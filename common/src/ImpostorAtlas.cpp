@@ -0,0 +1,146 @@
+#include "ImpostorAtlas.h"
+#include "MemoryRegistry.h"
+#include "ProgramCache.h"
+#include <ngl/ShaderLib.h>
+#include <ngl/Util.h>
+#include <algorithm>
+#include <cmath>
+
+constexpr auto c_bakeProgram = "ImpostorBake";
+constexpr auto c_program = "Impostor";
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the texture units the impostor program uses, unit 0 is the instance matrices
+//----------------------------------------------------------------------------------------------------------------------
+constexpr GLint c_idUnit = 4;
+constexpr GLint c_colourUnit = 5;
+constexpr GLint c_depthUnit = 6;
+
+ImpostorAtlas::ImpostorAtlas(int _views, GLsizei _viewSize)
+  : m_views(std::max(_views, 1)), m_columns(static_cast<int>(std::ceil(std::sqrt(static_cast<float>(m_views))))), m_viewSize(_viewSize)
+{
+}
+
+ImpostorAtlas::~ImpostorAtlas()
+{
+  glDeleteTextures(1, &m_colour);
+  glDeleteTextures(1, &m_depth);
+  glDeleteVertexArrays(1, &m_vao);
+  MemoryRegistry::shared().release(this);
+}
+
+namespace
+{
+void createProgram(const char *_name, const char *_vertex, const char *_fragment)
+{
+  ProgramCache::shared().build(
+      {_name, {{ngl::ShaderType::VERTEX, ProgramCache::readSource(_vertex)}, {ngl::ShaderType::FRAGMENT, ProgramCache::readSource(_fragment)}}, {}, {}});
+}
+} // namespace
+
+void ImpostorAtlas::initialize()
+{
+  createProgram(c_bakeProgram, "shaders/ImpostorBakeVertex.glsl", "shaders/ImpostorBakeFragment.glsl");
+  ngl::ShaderLib::setUniform("tex", 1);
+  createProgram(c_program, "shaders/ImpostorVertex.glsl", "shaders/ImpostorFragment.glsl");
+  ngl::ShaderLib::setUniform("TBO", 0);
+  ngl::ShaderLib::setUniform("ids", c_idUnit);
+  ngl::ShaderLib::setUniform("colourAtlas", c_colourUnit);
+  ngl::ShaderLib::setUniform("depthAtlas", c_depthUnit);
+  ngl::ShaderLib::setUniform("views", m_views);
+  ngl::ShaderLib::setUniform("columns", m_columns);
+  glGenVertexArrays(1, &m_vao);
+}
+
+void ImpostorAtlas::bake(const DrawFunction &_draw, GLuint _texture, const ngl::Vec3 &_boundsMin, const ngl::Vec3 &_boundsMax)
+{
+  GLsizei size = m_viewSize * m_columns;
+  int levels = std::max(static_cast<int>(std::log2(static_cast<float>(m_viewSize))) - 3, 1);
+  glDeleteTextures(1, &m_colour);
+  glDeleteTextures(1, &m_depth);
+  glGenTextures(1, &m_colour);
+  glBindTexture(GL_TEXTURE_2D, m_colour);
+  glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, size, size);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glGenTextures(1, &m_depth);
+  glBindTexture(GL_TEXTURE_2D, m_depth);
+  glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, size, size);
+  MemoryRegistry::shared().set(MemoryRegistry::Category::Textures, this,
+                               MemoryRegistry::textureBytes(size, size, 4, levels) + MemoryRegistry::textureBytes(size, size, 4));
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  GLint savedFBO = 0;
+  GLint savedViewport[4];
+  GLfloat savedClear[4];
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &savedFBO);
+  glGetIntegerv(GL_VIEWPORT, savedViewport);
+  glGetFloatv(GL_COLOR_CLEAR_VALUE, savedClear);
+  GLuint fbo = 0;
+  glGenFramebuffers(1, &fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colour, 0);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depth, 0);
+  // empty texels have 0 alpha and are discarded when drawn
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glViewport(0, 0, size, size);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+  // the quad is upright and as wide as the mesh is around its Y axis, the bake camera sits far
+  // enough out that the whole mesh is in front of it and the quad is half way down the depth range
+  float halfWidth = 0.0f;
+  float distance = 0.0f;
+  for (int i = 0; i < 4; ++i)
+  {
+    float x = (i & 1) ? _boundsMax.m_x : _boundsMin.m_x;
+    float z = (i & 2) ? _boundsMax.m_z : _boundsMin.m_z;
+    halfWidth = std::max(halfWidth, std::sqrt(x * x + z * z));
+  }
+  distance = std::sqrt(halfWidth * halfWidth + std::max(_boundsMin.m_y * _boundsMin.m_y, _boundsMax.m_y * _boundsMax.m_y)) + 1.0f;
+  auto project = ngl::ortho(-halfWidth, halfWidth, _boundsMin.m_y, _boundsMax.m_y, 0.0f, 2.0f * distance);
+
+  ngl::ShaderLib::use(c_bakeProgram);
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, _texture);
+  for (int view = 0; view < m_views; ++view)
+  {
+    // view i looks at the mesh from angle 2pi i / views around Y, matching the selection in ImpostorVertex.glsl
+    float angle = 2.0f * static_cast<float>(M_PI) * view / m_views;
+    ngl::Vec3 eye(std::sin(angle) * distance, 0.0f, std::cos(angle) * distance);
+    glViewport((view % m_columns) * m_viewSize, (view / m_columns) * m_viewSize, m_viewSize, m_viewSize);
+    ngl::ShaderLib::setUniform("MVP", project * ngl::lookAt(eye, ngl::Vec3(0.0f, 0.0f, 0.0f), ngl::Vec3(0.0f, 1.0f, 0.0f)));
+    _draw();
+  }
+  glBindTexture(GL_TEXTURE_2D, m_colour);
+  glGenerateMipmap(GL_TEXTURE_2D);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(savedFBO));
+  glDeleteFramebuffers(1, &fbo);
+  glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+  glClearColor(savedClear[0], savedClear[1], savedClear[2], savedClear[3]);
+
+  ngl::ShaderLib::use(c_program);
+  ngl::ShaderLib::setUniform("halfWidth", halfWidth);
+  ngl::ShaderLib::setUniform("heightRange", _boundsMin.m_y, _boundsMax.m_y);
+  ngl::ShaderLib::setUniform("bakeDistance", distance);
+}
+
+void ImpostorAtlas::use(GLuint _ids, const ngl::Mat4 &_project, const ngl::Mat4 &_view, float _near, float _far)
+{
+  ngl::ShaderLib::use(c_program);
+  ngl::ShaderLib::setUniform("project", _project);
+  ngl::ShaderLib::setUniform("View", _view);
+  ngl::ShaderLib::setUniform("lodRange", _near, _far);
+  glActiveTexture(GL_TEXTURE0 + c_idUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, _ids);
+  glActiveTexture(GL_TEXTURE0 + c_colourUnit);
+  glBindTexture(GL_TEXTURE_2D, m_colour);
+  glActiveTexture(GL_TEXTURE0 + c_depthUnit);
+  glBindTexture(GL_TEXTURE_2D, m_depth);
+  glBindVertexArray(m_vao);
+}
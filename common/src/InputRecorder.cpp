@@ -0,0 +1,149 @@
+#include "InputRecorder.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+InputRecorder::~InputRecorder()
+{
+  if (m_mode == Mode::Record)
+  {
+    save();
+  }
+}
+
+void InputRecorder::startRecording(std::string _fileName)
+{
+  m_mode = Mode::Record;
+  m_fileName = std::move(_fileName);
+  m_events.clear();
+  m_state.clear();
+  m_frame = 0;
+  m_started = false;
+}
+
+bool InputRecorder::startReplay(const std::string &_fileName)
+{
+  std::ifstream file(_fileName);
+  if (!file.is_open())
+  {
+    std::cerr << "unable to open input recording " << _fileName << "\n";
+    return false;
+  }
+  m_events.clear();
+  std::string line;
+  while (std::getline(file, line))
+  {
+    if (line.empty() || line[0] == '#')
+    {
+      continue;
+    }
+    std::istringstream fields(line);
+    Event event;
+    if (!(fields >> event.frame >> event.timeMs >> event.channel))
+    {
+      continue;
+    }
+    while (event.count < event.values.size() && fields >> event.values[event.count])
+    {
+      ++event.count;
+    }
+    m_events.push_back(std::move(event));
+  }
+  // they should already be in order but make sure as we walk them with a cursor
+  std::stable_sort(m_events.begin(), m_events.end(), [](const Event &_a, const Event &_b)
+                   { return _a.frame < _b.frame; });
+  m_fileName = _fileName;
+  m_mode = Mode::Replay;
+  m_state.clear();
+  m_cursor = 0;
+  m_frame = 0;
+  m_started = false;
+  return true;
+}
+
+void InputRecorder::beginFrame()
+{
+  if (m_mode == Mode::Off)
+  {
+    return;
+  }
+  if (!m_started)
+  {
+    m_start = Clock::now();
+    m_started = true;
+  }
+  else
+  {
+    ++m_frame;
+  }
+  if (m_mode == Mode::Replay)
+  {
+    while (m_cursor < m_events.size() && m_events[m_cursor].frame <= m_frame)
+    {
+      const auto &event = m_events[m_cursor++];
+      m_state[event.channel] = event;
+    }
+  }
+}
+
+void InputRecorder::record(std::string_view _channel, std::initializer_list<float> _values)
+{
+  if (m_mode != Mode::Record)
+  {
+    return;
+  }
+  Event event;
+  event.frame = m_frame;
+  event.timeMs = std::chrono::duration<float, std::milli>(Clock::now() - m_start).count();
+  event.channel = std::string(_channel);
+  event.count = static_cast<uint32_t>(std::min(_values.size(), event.values.size()));
+  std::copy_n(_values.begin(), event.count, event.values.begin());
+  auto last = m_state.find(_channel);
+  if (last != m_state.end() && last->second.count == event.count && last->second.values == event.values)
+  {
+    return;
+  }
+  m_state[event.channel] = event;
+  m_events.push_back(std::move(event));
+}
+
+bool InputRecorder::value(std::string_view _channel, Values &o_values) const
+{
+  auto state = m_state.find(_channel);
+  if (state == m_state.end())
+  {
+    return false;
+  }
+  o_values = state->second.values;
+  return true;
+}
+
+bool InputRecorder::finished() const
+{
+  return m_mode == Mode::Replay && m_cursor >= m_events.size() && (m_events.empty() || m_frame > m_events.back().frame);
+}
+
+bool InputRecorder::save() const
+{
+  std::ofstream file(m_fileName);
+  if (!file.is_open())
+  {
+    std::cerr << "unable to write input recording " << m_fileName << "\n";
+    return false;
+  }
+  file << "# frame timeMs channel values\n";
+  // enough digits to get the same float back
+  file.precision(9);
+  for (const auto &event : m_events)
+  {
+    file << event.frame << ' ' << event.timeMs << ' ' << event.channel;
+    for (uint32_t i = 0; i < event.count; ++i)
+    {
+      file << ' ' << event.values[i];
+    }
+    file << '\n';
+  }
+  std::cout << "Recorded " << m_events.size() << " input events over " << m_frame + 1 << " frames to " << m_fileName << "\n";
+  return true;
+}
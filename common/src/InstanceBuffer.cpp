@@ -0,0 +1,85 @@
+#include "InstanceBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+InstanceBuffer::InstanceBuffer(GLbitfield _storageFlags, GLenum _usage, MemoryRegistry::Category _category)
+    : m_storageFlags(_storageFlags), m_usage(_usage), m_category(_category)
+{
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+  glDeleteBuffers(1, &m_id);
+  MemoryRegistry::shared().release(this);
+}
+
+bool InstanceBuffer::immutableStorageSupported()
+{
+  // only query once, we only ever have the one context
+  static const bool supported = []()
+  {
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major > 4 || (major == 4 && minor >= 4))
+    {
+      return true;
+    }
+    GLint numExtensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+    for (GLint i = 0; i < numExtensions; ++i)
+    {
+      auto name = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+      if (name != nullptr && std::strcmp(name, "GL_ARB_buffer_storage") == 0)
+      {
+        return true;
+      }
+    }
+    return false;
+  }();
+  return supported;
+}
+
+bool InstanceBuffer::resize(GLsizeiptr _bytes)
+{
+  bool reallocated = reserve(_bytes);
+  m_size = _bytes;
+  return reallocated;
+}
+
+bool InstanceBuffer::reserve(GLsizeiptr _bytes)
+{
+  if (_bytes <= m_capacity && m_id != 0)
+  {
+    return false;
+  }
+  allocate(std::max(_bytes, static_cast<GLsizeiptr>(m_capacity * c_growth)));
+  return true;
+}
+
+void InstanceBuffer::allocate(GLsizeiptr _bytes)
+{
+  // GL doesn't like zero sized stores
+  _bytes = std::max<GLsizeiptr>(_bytes, 1);
+  if (immutableStorageSupported())
+  {
+    // immutable storage can't be re-specified so we need a new name
+    glDeleteBuffers(1, &m_id);
+    glGenBuffers(1, &m_id);
+    glBindBuffer(GL_ARRAY_BUFFER, m_id);
+    glBufferStorage(GL_ARRAY_BUFFER, _bytes, nullptr, m_storageFlags);
+  }
+  else
+  {
+    if (m_id == 0)
+    {
+      glGenBuffers(1, &m_id);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, m_id);
+    glBufferData(GL_ARRAY_BUFFER, _bytes, nullptr, m_usage);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  m_capacity = _bytes;
+  ++m_generation;
+  MemoryRegistry::shared().set(m_category, this, m_capacity);
+}
@@ -0,0 +1,477 @@
+#include "InstanceGenerator.h"
+#include "CounterRandom.h"
+#include "InstanceLimits.h"
+#include "MemoryRegistry.h"
+#include "ProgramCache.h"
+#include "WorkerPool.h"
+#include <ngl/ShaderLib.h>
+#include <ngl/Vec3.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+constexpr auto c_program = "TransformFeedback";
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief fixed seed so every backend (and every run) sees the same cloud
+//----------------------------------------------------------------------------------------------------------------------
+constexpr unsigned int c_seed = 1234;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the CounterRandom stream for the cloud, feedback.glsl uses the same
+//----------------------------------------------------------------------------------------------------------------------
+constexpr uint32_t c_cloudStream = 0;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief points per pool task and per batch of random values
+//----------------------------------------------------------------------------------------------------------------------
+constexpr size_t c_pointsPerTask = 65536;
+constexpr GLuint c_pointsPerBatch = 256;
+
+InstanceGenerator::InstanceGenerator(GLuint _maxInstances) : m_maxInstances(_maxInstances), m_instances(std::min(1000u, _maxInstances))
+{
+}
+
+InstanceGenerator::~InstanceGenerator()
+{
+  glDeleteVertexArrays(1, &m_dataVAO);
+  glDeleteBuffers(1, &m_dataBuffer);
+  MemoryRegistry::shared().release(this);
+}
+
+void InstanceGenerator::initialize()
+{
+  createPrograms();
+  createPoints();
+  uploadPoints();
+  // our matrix buffer is going to be fed to the feedback shader to generate our model
+  // position data for later, it is sized in generate as the number of instances changes
+}
+
+void InstanceGenerator::createPrograms()
+{
+  createProgram(InstanceRenderer::Encoding::Mat4);
+  createProgram(InstanceRenderer::Encoding::Affine);
+}
+
+void InstanceGenerator::createProgram(InstanceRenderer::Encoding _encoding)
+{
+  // This is for our transform shader and it will write a matrix per point into
+  // our matrix buffer ready for drawing later
+  ProgramCache::Program program;
+  program.name = InstanceRenderer::programName(c_program, _encoding);
+  auto defines = InstanceRenderer::shaderDefines(_encoding);
+  defines.set("CLOUD_SEED", c_seed).set("CLOUD_STREAM", c_cloudStream);
+  if (m_pointFormat == PointFormat::Generated)
+  {
+    defines.set("POINTS_GENERATED");
+  }
+  program.stages.push_back({ngl::ShaderType::VERTEX, ProgramCache::readSource("shaders/feedback.glsl", defines)});
+  // bind our attribute
+  program.attributes.emplace_back(0, "inPos");
+  // the varyings we want to attach to (this is the out in our shader), recorded interleaved so
+  // each instance is packed one after the other, the affine encoding only writes the first 3 rows
+  if (_encoding == InstanceRenderer::Encoding::Affine)
+  {
+    program.varyings = {"ModelViewRow0", "ModelViewRow1", "ModelViewRow2"};
+  }
+  else
+  {
+    program.varyings = {"ModelView"};
+  }
+  // the varyings are part of the cache key as they change the link
+  ProgramCache::shared().build(program);
+}
+
+void InstanceGenerator::createPoints()
+{
+  // allocate space for the vec3 for each point, we keep a copy for the Stream source
+  m_points.resize(m_maxInstances);
+  // in this case create a sort of supertorus distribution of points based on a random point,
+  // each point only depends on its index so they are split across the pool, this must match
+  // cloudPoint in shaders/feedback.glsl
+  auto &pool = WorkerPool::shared();
+  size_t tasks = std::clamp<size_t>(m_maxInstances / c_pointsPerTask, 1, pool.size());
+  pool.run(tasks,
+           [&](size_t _task)
+           {
+             GLuint begin = static_cast<GLuint>(uint64_t(m_maxInstances) * _task / tasks);
+             GLuint end = static_cast<GLuint>(uint64_t(m_maxInstances) * (_task + 1) / tasks);
+             // 4 values per point from draw 0 and the last from draw 1
+             float first[c_pointsPerBatch * 4];
+             float second[c_pointsPerBatch * 4];
+             for (GLuint batch = begin; batch < end; batch += c_pointsPerBatch)
+             {
+               GLuint count = std::min<GLuint>(c_pointsPerBatch, end - batch);
+               CounterRandom::fillUnit(c_seed, c_cloudStream, 0, batch, count, first);
+               CounterRandom::fillUnit(c_seed, c_cloudStream, 1, batch, count, second);
+               for (GLuint i = 0; i < count; ++i)
+               {
+                 const float *a = first + i * 4;
+                 float angle = (a[0] * 2.0f - 1.0f) * static_cast<float>(M_PI);
+                 float radius = a[1] * 2.0f - 1.0f;
+                 float ca = cosf(angle);
+                 float sa = sinf(angle);
+                 float cs = ca < 0 ? -1 : 1;
+                 float ss = sa < 0 ? -1 : 1;
+                 float x = radius * cs * powf(fabsf(ca), 1.2f);
+                 float y = radius * ss * powf(fabsf(sa), 1.2f);
+                 m_points[batch + i].set((a[2] * 2.0f - 1.0f) * x * 80, (a[3] * 2.0f - 1.0f) * y, (second[i * 4] * 2.0f - 1.0f) * (x + y * 80));
+               }
+             }
+           });
+  // now store this buffer data for later.
+  quantizePoints(m_pointData);
+}
+
+void InstanceGenerator::uploadPoints()
+{
+  // first create a Vertex array for out data points, we will create max instances
+  // size of data but only use a certain amount of them when we draw
+  glGenVertexArrays(1, &m_dataVAO);
+  glBindVertexArray(m_dataVAO);
+  // generated points only need the (empty) VAO for the draw
+  if (m_pointFormat != PointFormat::Generated)
+  {
+    // generate a buffer ready to store our data
+    glGenBuffers(1, &m_dataBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_dataBuffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_pointData.size()), m_pointData.data(), GL_STATIC_DRAW);
+  }
+  MemoryRegistry::shared().set(MemoryRegistry::Category::Points, this, static_cast<int64_t>(m_pointData.size()));
+  // the GL copy is all that is needed now
+  std::vector<unsigned char>().swap(m_pointData);
+  // the CPU copy of the points kept for the Stream source
+  MemoryRegistry::shared().set(MemoryRegistry::Category::CpuStaging, this, static_cast<int64_t>(m_points.capacity() * sizeof(ngl::Vec3)));
+  // attribute 0 is the inPos in our shader, the quantized formats are normalized to 0-1
+  switch (m_pointFormat)
+  {
+  case PointFormat::Generated:
+    break;
+  case PointFormat::Float:
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    break;
+  case PointFormat::Unorm16:
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, 0, nullptr);
+    break;
+  case PointFormat::Packed:
+    // packed formats must have a size of 4, the shader only reads xyz
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_UNSIGNED_INT_2_10_10_10_REV, GL_TRUE, 0, nullptr);
+    break;
+  }
+  glBindVertexArray(0);
+  std::cout << "Points " << pointFormatName(m_pointFormat) << " " << m_pointStats.bytes / 1024 << "KB max error " << m_pointStats.maxError
+            << " mean error " << m_pointStats.meanError << " (cloud extent " << m_pointStats.extent << ")\n";
+}
+
+void InstanceGenerator::quantizePoints(std::vector<unsigned char> &o_data)
+{
+  m_pointStats = PointStats();
+  if (m_pointFormat == PointFormat::Float || m_pointFormat == PointFormat::Generated)
+  {
+    m_pointMin.set(0.0f, 0.0f, 0.0f);
+    m_pointScale.set(1.0f, 1.0f, 1.0f);
+    o_data.resize(m_pointFormat == PointFormat::Float ? m_points.size() * sizeof(ngl::Vec3) : 0);
+    std::memcpy(o_data.data(), m_points.data(), o_data.size());
+    m_pointStats.bytes = o_data.size();
+    return;
+  }
+  // quantize relative to the bounds of the cloud so all of the bits are used
+  float lo[3] = {1e30f, 1e30f, 1e30f};
+  float hi[3] = {-1e30f, -1e30f, -1e30f};
+  for (const auto &p : m_points)
+  {
+    const float v[3] = {p.m_x, p.m_y, p.m_z};
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      lo[axis] = std::min(lo[axis], v[axis]);
+      hi[axis] = std::max(hi[axis], v[axis]);
+    }
+  }
+  float extent[3];
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    extent[axis] = std::max(hi[axis] - lo[axis], 1e-6f);
+    m_pointStats.extent = std::max(m_pointStats.extent, static_cast<double>(extent[axis]));
+  }
+  m_pointMin.set(lo[0], lo[1], lo[2]);
+  m_pointScale.set(extent[0], extent[1], extent[2]);
+
+  bool packed = m_pointFormat == PointFormat::Packed;
+  const float maxValue = packed ? 1023.0f : 65535.0f;
+  size_t stride = packed ? sizeof(uint32_t) : 3 * sizeof(uint16_t);
+  o_data.resize(m_points.size() * stride);
+  double totalError = 0.0;
+  for (size_t i = 0; i < m_points.size(); ++i)
+  {
+    auto &p = m_points[i];
+    const float v[3] = {p.m_x, p.m_y, p.m_z};
+    uint32_t q[3];
+    float dequantized[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      q[axis] = static_cast<uint32_t>(std::lround((v[axis] - lo[axis]) / extent[axis] * maxValue));
+      // the same sum as the shader (pointMin + inPos * pointScale)
+      dequantized[axis] = lo[axis] + (static_cast<float>(q[axis]) / maxValue) * extent[axis];
+    }
+    if (packed)
+    {
+      uint32_t bits = q[0] | (q[1] << 10) | (q[2] << 20);
+      std::memcpy(o_data.data() + i * stride, &bits, stride);
+    }
+    else
+    {
+      uint16_t shorts[3] = {static_cast<uint16_t>(q[0]), static_cast<uint16_t>(q[1]), static_cast<uint16_t>(q[2])};
+      std::memcpy(o_data.data() + i * stride, shorts, stride);
+    }
+    float dx = dequantized[0] - v[0];
+    float dy = dequantized[1] - v[1];
+    float dz = dequantized[2] - v[2];
+    double error = std::sqrt(static_cast<double>(dx * dx + dy * dy + dz * dz));
+    m_pointStats.maxError = std::max(m_pointStats.maxError, error);
+    totalError += error;
+    p.set(dequantized[0], dequantized[1], dequantized[2]);
+  }
+  m_pointStats.bytes = o_data.size();
+  m_pointStats.meanError = m_points.empty() ? 0.0 : totalError / static_cast<double>(m_points.size());
+}
+
+const char *InstanceGenerator::pointFormatName(PointFormat _format)
+{
+  switch (_format)
+  {
+  case PointFormat::Float:
+    return "Float";
+  case PointFormat::Unorm16:
+    return "Unorm16";
+  case PointFormat::Packed:
+    return "Packed";
+  case PointFormat::Generated:
+    return "Generated";
+  }
+  return "Float";
+}
+
+InstanceGenerator::PointFormat InstanceGenerator::pointFormatFromName(std::string_view _name)
+{
+  if (_name == "unorm16" || _name == "Unorm16")
+  {
+    return PointFormat::Unorm16;
+  }
+  else if (_name == "packed" || _name == "Packed")
+  {
+    return PointFormat::Packed;
+  }
+  else if (_name == "generated" || _name == "Generated")
+  {
+    return PointFormat::Generated;
+  }
+  return PointFormat::Float;
+}
+
+void InstanceGenerator::setMaxInstances(GLuint _maxInstances)
+{
+  m_maxInstances = std::max(_maxInstances, 1u);
+  m_instances = std::min(m_instances, m_maxInstances);
+}
+
+void InstanceGenerator::setNumInstances(GLuint _count)
+{
+  _count = std::min(_count, m_maxInstances);
+  if (_count != m_instances)
+  {
+    m_instances = _count;
+    m_updateBuffer = true;
+  }
+}
+
+void InstanceGenerator::setEncoding(InstanceRenderer::Encoding _encoding)
+{
+  if (_encoding != m_encoding)
+  {
+    m_encoding = _encoding;
+    m_updateBuffer = true;
+  }
+}
+
+const char *InstanceGenerator::sourceName(Source _source)
+{
+  return _source == Source::Stream ? "Stream" : "Feedback";
+}
+
+InstanceGenerator::Source InstanceGenerator::sourceFromName(std::string_view _name)
+{
+  if (_name == "stream" || _name == "Stream")
+  {
+    return Source::Stream;
+  }
+  return Source::Feedback;
+}
+
+void InstanceGenerator::generate(const ngl::Mat4 &_view, const ngl::Mat4 &_mouse)
+{
+  GLuint stride = InstanceRenderer::stride(m_encoding);
+  if (m_updateBuffer == true)
+  {
+    m_chunkInstances = InstanceLimits::get().chunkInstances(m_encoding);
+  }
+  GLuint numChunks = std::max((m_instances + m_chunkInstances - 1) / m_chunkInstances, 1u);
+  m_chunks.resize(numChunks);
+  if (m_source == Source::Stream)
+  {
+    // wait for our region to be free then write straight into the mapped buffer, the chunks are
+    // consecutive (aligned) ranges of the region
+    auto data = static_cast<float *>(m_stream.map(static_cast<GLsizeiptr>(m_instances) * stride));
+    computeMatrices(data, _view, _mouse);
+    m_stream.unmap();
+    for (GLuint c = 0; c < numChunks; ++c)
+    {
+      auto &chunk = m_chunks[c];
+      chunk.buffer = m_stream.id();
+      chunk.offset = m_stream.offset() + static_cast<GLintptr>(c) * m_chunkInstances * stride;
+      chunk.count = std::min(m_chunkInstances, m_instances - c * m_chunkInstances);
+      chunk.generation = m_stream.generation();
+      chunk.encoding = m_encoding;
+    }
+    return;
+  }
+  ngl::ShaderLib::use(InstanceRenderer::programName(c_program, m_encoding));
+  // if the number of instances have changed re-size the buffers, this only re-allocates
+  // when we grow past the capacity
+  if (m_updateBuffer == true)
+  {
+    while (m_matrices.size() < numChunks)
+    {
+      m_matrices.push_back(std::make_unique<InstanceBuffer>());
+    }
+    for (GLuint c = 0; c < numChunks; ++c)
+    {
+      GLuint count = std::min(m_chunkInstances, m_instances - c * m_chunkInstances);
+      m_matrices[c]->resize(static_cast<GLsizeiptr>(count) * stride);
+    }
+    m_updateBuffer = false;
+  }
+  // activate our vertex array for the points so we can fill in our matrix buffer
+  glBindVertexArray(m_dataVAO);
+  // set the view for the camera
+  ngl::ShaderLib::setUniform("View", _view);
+  // this sets some per-vertex data values for the Matrix shader
+  ngl::ShaderLib::setUniform("data", 0.3f, 0.6f, 0.5f, 1.2f);
+  // pass in the mouse rotation
+  ngl::ShaderLib::setUniform("mouseRotation", _mouse);
+  // how to dequantize the points, generated points don't read any
+  if (m_pointFormat != PointFormat::Generated)
+  {
+    ngl::ShaderLib::setUniform("pointMin", m_pointMin);
+    ngl::ShaderLib::setUniform("pointScale", m_pointScale);
+  }
+  // this flag tells OpenGL to discard the data once it has passed the transform stage, this means
+  // that none of it wil be drawn (RASTERIZED) remember to turn this back on once we have done this
+  glEnable(GL_RASTERIZER_DISCARD);
+  for (GLuint c = 0; c < numChunks; ++c)
+  {
+    auto &buffer = *m_matrices[c];
+    GLuint first = c * m_chunkInstances;
+    GLuint count = std::min(m_chunkInstances, m_instances - first);
+    // bind a buffer object to an indexed buffer target in this case we are setting out matrix data
+    // to the transform feedback, only the active range so the capacity is left untouched
+    glBindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffer.id(), 0, buffer.size());
+    // redirect all draw output to the transform feedback buffer which is our buffer object matrix
+    glBeginTransformFeedback(GL_POINTS);
+    // now draw this chunk of our array of points (now is a good time to check out the feedback.glsl
+    // shader to see what happens here), gl_VertexID carries on from first so the chunks match one draw
+    glDrawArrays(GL_POINTS, static_cast<GLint>(first), static_cast<GLsizei>(count));
+    // now signal that we have done with the feedback buffer
+    glEndTransformFeedback();
+    auto &chunk = m_chunks[c];
+    chunk.buffer = buffer.id();
+    chunk.offset = 0;
+    chunk.count = count;
+    chunk.generation = buffer.generation();
+    chunk.encoding = m_encoding;
+  }
+  // and re-enable rasterisation
+  glDisable(GL_RASTERIZER_DISCARD);
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+  glBindVertexArray(0);
+}
+
+void InstanceGenerator::endFrame()
+{
+  if (m_source == Source::Stream)
+  {
+    m_stream.fence();
+  }
+}
+
+namespace
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief column major 4x4 (same layout as GLSL / ngl::Mat4) multiply o = a * b
+//----------------------------------------------------------------------------------------------------------------------
+void multiply(float o_m[4][4], const float _a[4][4], const float _b[4][4])
+{
+  for (int c = 0; c < 4; ++c)
+  {
+    for (int r = 0; r < 4; ++r)
+    {
+      o_m[c][r] = _a[0][r] * _b[c][0] + _a[1][r] * _b[c][1] + _a[2][r] * _b[c][2] + _a[3][r] * _b[c][3];
+    }
+  }
+}
+} // namespace
+
+void InstanceGenerator::computeMatrices(float *o_data, const ngl::Mat4 &_view, const ngl::Mat4 &_mouse) const
+{
+  // this must match shaders/feedback.glsl (and the data uniform set in generate)
+  constexpr float data[4] = {0.3f, 0.6f, 0.5f, 1.2f};
+  float view[4][4], mouse[4][4], viewMouse[4][4];
+  std::memcpy(view, &_view.m_m[0][0], sizeof(view));
+  std::memcpy(mouse, &_mouse.m_m[0][0], sizeof(mouse));
+  multiply(viewMouse, view, mouse);
+  bool affine = m_encoding == InstanceRenderer::Encoding::Affine;
+  for (GLuint i = 0; i < m_instances; ++i)
+  {
+    const auto &pos = m_points[i];
+    // Scale and spin each instance by a unique amount
+    float spin = static_cast<float>(i & 31) - 15.5f;
+    float c = cosf(data[0] * spin);
+    float s = sinf(data[0] * spin);
+    float y = (i & 15) * 0.125f + 0.25f;
+    float z = ((i + 5) & 63) * 0.03125f + 0.25f;
+    float model[4][4] = {{c, 0.0f, -s, 0.0f}, {0.0f, y, 0.0f, 0.0f}, {s, 0.0f, z * c, 0.0f}, {pos.m_x, pos.m_y, pos.m_z, 1.0f}};
+    // Rotate all instances around Z, scaled by dist
+    float dist = sqrtf(pos.m_x * pos.m_x + pos.m_y * pos.m_y + pos.m_z * pos.m_z);
+    float speed = data[1] - dist * data[2] + (i & 7) * 0.01f;
+    c = cosf(data[0] * speed);
+    s = sinf(data[0] * speed);
+    float rotY[4][4] = {{c, s, 0.0f, 0.0f}, {-s, c, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 0.0f, 1.0f}};
+    float rotated[4][4], modelView[4][4];
+    multiply(rotated, rotY, model);
+    // Scale each instance
+    for (int col = 0; col < 3; ++col)
+    {
+      for (int row = 0; row < 4; ++row)
+      {
+        rotated[col][row] *= data[3];
+      }
+    }
+    multiply(modelView, viewMouse, rotated);
+    if (affine)
+    {
+      for (int row = 0; row < 3; ++row)
+      {
+        for (int col = 0; col < 4; ++col)
+        {
+          *o_data++ = modelView[col][row];
+        }
+      }
+    }
+    else
+    {
+      std::memcpy(o_data, modelView, sizeof(modelView));
+      o_data += 16;
+    }
+  }
+}
@@ -0,0 +1,112 @@
+#include "InstanceLimits.h"
+#include "ViewSet.h"
+#include <algorithm>
+#include <climits>
+#include <numeric>
+#include <ostream>
+
+const InstanceLimits &InstanceLimits::get()
+{
+  static InstanceLimits limits = []
+  {
+    InstanceLimits l;
+    l.query();
+    return l;
+  }();
+  return limits;
+}
+
+void InstanceLimits::query()
+{
+  glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+  glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTextureBufferSize);
+  glGetIntegerv(GL_TEXTURE_BUFFER_OFFSET_ALIGNMENT, &textureBufferOffsetAlignment);
+  glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &maxUniformBlockSize);
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformBufferOffsetAlignment);
+  glGetIntegerv(GL_MAX_COMBINED_VERTEX_UNIFORM_COMPONENTS, &maxCombinedVertexUniformComponents);
+  glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxVertexAttribs);
+  glGetIntegerv(GL_MAX_VIEWPORTS, &maxViewports);
+  glGetIntegerv(GL_MAX_TRANSFORM_FEEDBACK_INTERLEAVED_COMPONENTS, &maxTransformFeedbackInterleavedComponents);
+  if (majorVersion > 4 || (majorVersion == 4 && minorVersion >= 3))
+  {
+    glGetInteger64v(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &maxShaderStorageBlockSize);
+    glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 0, &maxComputeWorkGroupCount);
+  }
+  // the spec minimums, a broken query must not give us empty chunks
+  maxTextureBufferSize = std::max(maxTextureBufferSize, 65536);
+  maxUniformBlockSize = std::max(maxUniformBlockSize, 16384);
+  textureBufferOffsetAlignment = std::max(textureBufferOffsetAlignment, 1);
+  uniformBufferOffsetAlignment = std::max(uniformBufferOffsetAlignment, 1);
+}
+
+GLuint InstanceLimits::alignedCount(GLint64 _instances, GLuint _stride) const
+{
+  // every chunk / draw must start on both offset alignments (as the UBO batches do)
+  GLuint alignment = static_cast<GLuint>(std::lcm(textureBufferOffsetAlignment, uniformBufferOffsetAlignment));
+  GLuint step = alignment / std::gcd(_stride, alignment);
+  return static_cast<GLuint>(std::max<GLint64>(_instances - _instances % step, step));
+}
+
+GLuint InstanceLimits::tboInstances(InstanceRenderer::Encoding _encoding) const
+{
+  // one RGBA32F texel per matrix row
+  GLuint stride = InstanceRenderer::stride(_encoding);
+  return alignedCount(maxTextureBufferSize / (stride / 16), stride);
+}
+
+GLuint InstanceLimits::uboInstances(InstanceRenderer::Encoding _encoding) const
+{
+  GLuint stride = InstanceRenderer::stride(_encoding);
+  GLint64 bytes = maxUniformBlockSize;
+  if (maxCombinedVertexUniformComponents > 0)
+  {
+    // the block shares the vertex stage uniform storage with the Views block (c_maxViews mat4)
+    // and the default block uniforms, leave room for both
+    GLint64 combined = static_cast<GLint64>(maxCombinedVertexUniformComponents) * 4 - (ViewSet::c_maxViews + 4) * 64;
+    bytes = std::min(bytes, combined);
+  }
+  GLint64 instances = std::max<GLint64>(bytes / stride, 1);
+  // each batch starts at instances * stride which must be a multiple of the offset alignment,
+  // this is always true for the 64 byte Mat4 but not for the 48 byte affine rows
+  GLuint alignment = static_cast<GLuint>(uniformBufferOffsetAlignment);
+  GLuint step = alignment / std::gcd(stride, alignment);
+  return static_cast<GLuint>(instances >= step ? instances - instances % step : instances);
+}
+
+GLuint InstanceLimits::chunkInstances(InstanceRenderer::Encoding _encoding) const
+{
+  GLuint stride = InstanceRenderer::stride(_encoding);
+  GLint64 instances = std::min<GLint64>(c_maxChunkBytes / stride, tboInstances(_encoding));
+  // the draw count is a GLsizei and multi view draws every instance once per view
+  instances = std::min<GLint64>(instances, INT_MAX / ViewSet::c_maxViews);
+  return alignedCount(instances, stride);
+}
+
+GLuint InstanceLimits::numChunks(GLuint _instances, InstanceRenderer::Encoding _encoding) const
+{
+  GLuint perChunk = chunkInstances(_encoding);
+  return std::max((_instances + perChunk - 1) / perChunk, 1u);
+}
+
+void InstanceLimits::printReport(std::ostream &_out, GLuint _instances) const
+{
+  _out << "GL " << majorVersion << "." << minorVersion << " instancing limits\n";
+  _out << "  GL_MAX_TEXTURE_BUFFER_SIZE " << maxTextureBufferSize << " texels\n";
+  _out << "  GL_TEXTURE_BUFFER_OFFSET_ALIGNMENT " << textureBufferOffsetAlignment << "\n";
+  _out << "  GL_MAX_UNIFORM_BLOCK_SIZE " << maxUniformBlockSize << "\n";
+  _out << "  GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT " << uniformBufferOffsetAlignment << "\n";
+  _out << "  GL_MAX_COMBINED_VERTEX_UNIFORM_COMPONENTS " << maxCombinedVertexUniformComponents << "\n";
+  _out << "  GL_MAX_VERTEX_ATTRIBS " << maxVertexAttribs << "\n";
+  _out << "  GL_MAX_VIEWPORTS " << maxViewports << "\n";
+  _out << "  GL_MAX_TRANSFORM_FEEDBACK_INTERLEAVED_COMPONENTS " << maxTransformFeedbackInterleavedComponents << "\n";
+  _out << "  GL_MAX_SHADER_STORAGE_BLOCK_SIZE " << maxShaderStorageBlockSize << "\n";
+  _out << "  GL_MAX_COMPUTE_WORK_GROUP_COUNT[0] " << maxComputeWorkGroupCount << "\n";
+  for (auto encoding : {InstanceRenderer::Encoding::Mat4, InstanceRenderer::Encoding::Affine})
+  {
+    GLuint perChunk = chunkInstances(encoding);
+    _out << "  " << InstanceRenderer::encodingName(encoding) << " " << _instances << " instances : " << numChunks(_instances, encoding) << " chunk(s) of up to "
+         << perChunk << " (" << static_cast<GLint64>(perChunk) * InstanceRenderer::stride(encoding) / (1024 * 1024) << "MB, one TBO holds "
+         << tboInstances(encoding) << ", one UBO batch " << uboInstances(encoding) << ")\n";
+  }
+}
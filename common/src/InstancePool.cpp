@@ -0,0 +1,108 @@
+#include "InstancePool.h"
+#include <cassert>
+
+InstancePool::InstancePool(float _fullUploadFraction) : m_store(_fullUploadFraction)
+{
+}
+
+InstancePool::Handle InstancePool::allocate()
+{
+  Handle handle;
+  if (!m_freeSlots.empty())
+  {
+    handle.slot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+  }
+  else
+  {
+    handle.slot = static_cast<uint32_t>(m_slotToIndex.size());
+    m_slotToIndex.push_back(0);
+    m_generations.push_back(0);
+  }
+  handle.generation = m_generations[handle.slot];
+  m_slotToIndex[handle.slot] = static_cast<uint32_t>(m_indexToSlot.size());
+  m_indexToSlot.push_back(handle.slot);
+  return handle;
+}
+
+InstancePool::Handle InstancePool::add(const ngl::Mat4 &_tx)
+{
+  Handle handle = allocate();
+  m_store.push_back(_tx);
+  return handle;
+}
+
+ngl::Mat4 *InstancePool::append(size_t _count, Handle *o_handles)
+{
+  for (size_t i = 0; i < _count; ++i)
+  {
+    o_handles[i] = allocate();
+  }
+  return m_store.append(_count);
+}
+
+bool InstancePool::valid(Handle _handle) const
+{
+  return _handle.slot < m_generations.size() && m_generations[_handle.slot] == _handle.generation;
+}
+
+bool InstancePool::remove(Handle _handle)
+{
+  if (!valid(_handle))
+  {
+    return false;
+  }
+  uint32_t index = m_slotToIndex[_handle.slot];
+  uint32_t last = static_cast<uint32_t>(m_store.size() - 1);
+  if (index != last)
+  {
+    // move the last instance into the hole, only this slot needs uploading
+    uint32_t movedSlot = m_indexToSlot[last];
+    m_store.set(index, m_store[last]);
+    m_indexToSlot[index] = movedSlot;
+    m_slotToIndex[movedSlot] = index;
+  }
+  m_store.pop_back();
+  m_indexToSlot.pop_back();
+  // bump the generation so any copies of this handle are now invalid
+  ++m_generations[_handle.slot];
+  m_freeSlots.push_back(_handle.slot);
+  return true;
+}
+
+bool InstancePool::set(Handle _handle, const ngl::Mat4 &_tx)
+{
+  // a stale handle's slot index now belongs to another instance (or is past the end)
+  if (!valid(_handle))
+  {
+    return false;
+  }
+  m_store.set(m_slotToIndex[_handle.slot], _tx);
+  return true;
+}
+
+const ngl::Mat4 &InstancePool::get(Handle _handle) const
+{
+  assert(valid(_handle));
+  return m_store[m_slotToIndex[_handle.slot]];
+}
+
+void InstancePool::reserve(size_t _count)
+{
+  m_store.reserve(_count);
+  m_indexToSlot.reserve(_count);
+  m_slotToIndex.reserve(_count);
+  m_generations.reserve(_count);
+}
+
+void InstancePool::clear()
+{
+  // invalidate every live handle
+  for (auto slot : m_indexToSlot)
+  {
+    ++m_generations[slot];
+    m_freeSlots.push_back(slot);
+  }
+  m_indexToSlot.clear();
+  m_store.resize(0);
+}
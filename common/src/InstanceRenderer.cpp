@@ -0,0 +1,155 @@
+#include "InstanceRenderer.h"
+#include "DivisorInstanceRenderer.h"
+#include "ProgramCache.h"
+#include "TBOInstanceRenderer.h"
+#include "UBOInstanceRenderer.h"
+#include "ViewSet.h"
+#include <ngl/ShaderLib.h>
+#include <algorithm>
+#include <cctype>
+#include <string>
+
+std::unique_ptr<InstanceRenderer> InstanceRenderer::create(Backend _backend)
+{
+  switch (_backend)
+  {
+  case Backend::TBO:
+    return std::make_unique<TBOInstanceRenderer>();
+  case Backend::UBO:
+    return std::make_unique<UBOInstanceRenderer>();
+  case Backend::Divisor:
+    return std::make_unique<DivisorInstanceRenderer>();
+  }
+  return nullptr;
+}
+
+const char *InstanceRenderer::backendName(Backend _backend)
+{
+  switch (_backend)
+  {
+  case Backend::TBO:
+    return "TBO";
+  case Backend::UBO:
+    return "UBO";
+  case Backend::Divisor:
+    return "Divisor";
+  }
+  return "TBO";
+}
+
+InstanceRenderer::Backend InstanceRenderer::backendFromName(std::string_view _name)
+{
+  if (_name == "ubo" || _name == "UBO")
+  {
+    return Backend::UBO;
+  }
+  else if (_name == "divisor" || _name == "Divisor")
+  {
+    return Backend::Divisor;
+  }
+  return Backend::TBO;
+}
+
+const char *InstanceRenderer::encodingName(Encoding _encoding)
+{
+  return _encoding == Encoding::Affine ? "Affine" : "Mat4";
+}
+
+InstanceRenderer::Encoding InstanceRenderer::encodingFromName(std::string_view _name)
+{
+  if (_name == "affine" || _name == "Affine")
+  {
+    return Encoding::Affine;
+  }
+  return Encoding::Mat4;
+}
+
+std::string InstanceRenderer::programName(std::string_view _name, Encoding _encoding, Pass _pass, bool _multiView)
+{
+  std::string name(_name);
+  if (_encoding == Encoding::Affine)
+  {
+    name += "Affine";
+  }
+  if (_pass == Pass::Depth)
+  {
+    name += "Depth";
+  }
+  if (_multiView)
+  {
+    name += "MultiView";
+  }
+  return name;
+}
+
+ShaderDefines InstanceRenderer::shaderDefines(Encoding _encoding, Pass _pass, bool _multiView)
+{
+  ShaderDefines defines;
+  if (_encoding == Encoding::Affine)
+  {
+    defines.set("MATRIX_AFFINE");
+  }
+  if (_pass == Pass::Depth)
+  {
+    defines.set("DEPTH_ONLY");
+  }
+  if (_multiView)
+  {
+    defines.set("MULTI_VIEW").set("MAX_VIEWS", ViewSet::c_maxViews);
+  }
+  else if (bakesProjection(_encoding, _multiView))
+  {
+    defines.set("MATRIX_PROJECTED");
+  }
+  return defines;
+}
+
+std::string InstanceRenderer::shaderSource(std::string_view _file, Encoding _encoding, Pass _pass, bool _multiView)
+{
+  return ProgramCache::readSource(_file, shaderDefines(_encoding, _pass, _multiView));
+}
+
+void InstanceRenderer::createProgram(std::string_view _name, std::string_view _vertex, Encoding _encoding, Pass _pass, bool _multiView) const
+{
+  auto defines = shaderDefines(_encoding, _pass, _multiView);
+  std::string backendDefine = std::string("BACKEND_") + backendName(backend());
+  std::transform(backendDefine.begin(), backendDefine.end(), backendDefine.begin(), [](unsigned char _c) { return std::toupper(_c); });
+  defines.set(backendDefine);
+  addDefines(defines, _encoding);
+  ProgramCache::Program program;
+  program.name = programName(_name, _encoding, _pass, _multiView);
+  program.stages.push_back({ngl::ShaderType::VERTEX, ProgramCache::readSource(_vertex, defines)});
+  program.stages.push_back(
+      {ngl::ShaderType::FRAGMENT, ProgramCache::readSource(_pass == Pass::Depth ? "shaders/DepthFragment.glsl" : "shaders/Fragment.glsl")});
+  if (_multiView)
+  {
+    // the geometry shader sends each triangle to the viewport / layer of its view
+    program.stages.push_back({ngl::ShaderType::GEOMETRY, ProgramCache::readSource("shaders/MultiViewGeometry.glsl", defines)});
+  }
+  // loads the cached binary or compiles, either way the program is in use with its uniforms registered
+  ProgramCache::shared().build(program);
+  if (_pass == Pass::Colour)
+  {
+    ngl::ShaderLib::setUniform("tex", c_textureUnit);
+  }
+  if (_multiView)
+  {
+    GLuint id = ngl::ShaderLib::getProgramID(program.name);
+    glUniformBlockBinding(id, glGetUniformBlockIndex(id, "Views"), ViewSet::c_binding);
+  }
+}
+
+std::string InstanceRenderer::useProgram(std::string_view _name, const InstanceData &_data, const ngl::Mat4 &_project, Pass _pass) const
+{
+  auto name = programName(_name, _data.encoding, _pass, m_views > 0);
+  ngl::ShaderLib::use(name);
+  if (m_views > 0)
+  {
+    ngl::ShaderLib::setUniform("numViews", static_cast<int>(m_views));
+  }
+  else if (!bakesProjection(_data.encoding, false))
+  {
+    ngl::ShaderLib::setUniform("Projection", _project);
+  }
+  return name;
+}
@@ -0,0 +1,167 @@
+#include "InstanceStore.h"
+#include "MemoryRegistry.h"
+#include <algorithm>
+#include <iomanip>
+
+InstanceStore::InstanceStore(float _fullUploadFraction)
+    : m_fullUploadFraction(_fullUploadFraction), m_buffer(GL_DYNAMIC_STORAGE_BIT, GL_DYNAMIC_DRAW)
+{
+}
+
+InstanceStore::~InstanceStore()
+{
+  MemoryRegistry::shared().release(this);
+}
+
+void InstanceStore::resize(size_t _count)
+{
+  m_data.resize(_count);
+  markAllDirty();
+}
+
+void InstanceStore::push_back(const ngl::Mat4 &_tx)
+{
+  m_data.push_back(_tx);
+  markDirty(m_data.size() - 1, 1);
+}
+
+ngl::Mat4 *InstanceStore::append(size_t _count)
+{
+  size_t first = m_data.size();
+  m_data.resize(first + _count);
+  markDirty(first, _count);
+  return m_data.data() + first;
+}
+
+void InstanceStore::pop_back()
+{
+  // dirty ranges past the end are clipped in upload
+  m_data.pop_back();
+}
+
+void InstanceStore::set(size_t _index, const ngl::Mat4 &_tx)
+{
+  m_data[_index] = _tx;
+  markDirty(_index, 1);
+}
+
+ngl::Mat4 *InstanceStore::modify(size_t _first, size_t _count)
+{
+  markDirty(_first, _count);
+  return m_data.data() + _first;
+}
+
+void InstanceStore::markDirty(size_t _first, size_t _count)
+{
+  if (m_allDirty || _count == 0)
+  {
+    return;
+  }
+  size_t end = _first + _count;
+  // cheap merge with the last range, the common case of walking forwards through the data
+  if (!m_dirty.empty() && _first >= m_dirty.back().first && _first <= m_dirty.back().second)
+  {
+    m_dirty.back().second = std::max(m_dirty.back().second, end);
+    return;
+  }
+  m_dirty.emplace_back(_first, end);
+}
+
+void InstanceStore::markAllDirty()
+{
+  m_allDirty = true;
+  m_dirty.clear();
+}
+
+bool InstanceStore::upload()
+{
+  if (!m_allDirty && m_dirty.empty())
+  {
+    m_stats.lastRanges = 0;
+    m_stats.lastBytes = 0;
+    m_stats.lastFull = false;
+    return false;
+  }
+  if (m_data.empty())
+  {
+    m_dirty.clear();
+    m_allDirty = false;
+    return false;
+  }
+  // the CPU copy is counted here as it only changes size between uploads
+  MemoryRegistry::shared().set(MemoryRegistry::Category::CpuStaging, this, static_cast<int64_t>(m_data.capacity() * sizeof(ngl::Mat4)));
+  // a re-allocation loses the contents so has to be a full upload
+  if (m_buffer.resize(static_cast<GLsizeiptr>(m_data.size() * sizeof(ngl::Mat4))))
+  {
+    m_allDirty = true;
+  }
+  size_t dirtyCount = 0;
+  if (!m_allDirty)
+  {
+    // clip anything left past the end by pop_back then sort and coalesce, merging anything
+    // closer than c_mergeGap
+    size_t count = m_data.size();
+    for (auto &range : m_dirty)
+    {
+      range.second = std::min(range.second, count);
+      range.first = std::min(range.first, range.second);
+    }
+    m_dirty.erase(std::remove_if(m_dirty.begin(), m_dirty.end(), [](const auto &_r) { return _r.first == _r.second; }), m_dirty.end());
+    std::sort(m_dirty.begin(), m_dirty.end());
+    size_t out = 0;
+    for (size_t i = 1; i < m_dirty.size(); ++i)
+    {
+      if (m_dirty[i].first <= m_dirty[out].second + c_mergeGap)
+      {
+        m_dirty[out].second = std::max(m_dirty[out].second, m_dirty[i].second);
+      }
+      else
+      {
+        m_dirty[++out] = m_dirty[i];
+      }
+    }
+    m_dirty.resize(m_dirty.empty() ? 0 : out + 1);
+    for (const auto &range : m_dirty)
+    {
+      dirtyCount += range.second - range.first;
+    }
+    if (dirtyCount > m_fullUploadFraction * m_data.size())
+    {
+      m_allDirty = true;
+    }
+  }
+  if (m_allDirty)
+  {
+    m_dirty.assign(1, {0, m_data.size()});
+    dirtyCount = m_data.size();
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_buffer.id());
+  for (const auto &range : m_dirty)
+  {
+    glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(range.first * sizeof(ngl::Mat4)),
+                    static_cast<GLsizeiptr>((range.second - range.first) * sizeof(ngl::Mat4)), &m_data[range.first]);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  ++m_stats.uploads;
+  m_stats.fullUploads += m_allDirty ? 1 : 0;
+  m_stats.lastFull = m_allDirty;
+  m_stats.lastRanges = m_dirty.size();
+  m_stats.lastBytes = dirtyCount * sizeof(ngl::Mat4);
+  m_stats.ranges += m_stats.lastRanges;
+  m_stats.bytes += m_stats.lastBytes;
+  m_dirty.clear();
+  m_allDirty = false;
+  return true;
+}
+
+void InstanceStore::printSummary(std::ostream &_out) const
+{
+  auto flags = _out.flags();
+  _out << std::fixed << std::setprecision(1);
+  _out << "Instance store " << m_data.size() << " instances, " << m_stats.uploads << " uploads (" << m_stats.fullUploads << " full) "
+       << m_stats.ranges << " ranges " << m_stats.bytes / (1024.0 * 1024.0) << "MB, full upload above "
+       << m_fullUploadFraction * 100.0f << "% dirty\n";
+  _out.flags(flags);
+}
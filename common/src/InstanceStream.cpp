@@ -0,0 +1,183 @@
+#include "InstanceStream.h"
+#include "InstanceBuffer.h"
+#include "MemoryRegistry.h"
+#include <algorithm>
+#include <iomanip>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief regions start on this boundary, it is the largest GL_TEXTURE_BUFFER_OFFSET_ALIGNMENT /
+/// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT seen in practice so every backend can bind a region
+//----------------------------------------------------------------------------------------------------------------------
+constexpr GLsizeiptr c_regionAlignment = 256;
+
+namespace
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief a GL sync object for FenceWaitStats
+//----------------------------------------------------------------------------------------------------------------------
+class SyncFence : public FenceWaitStats::Fence
+{
+public:
+  explicit SyncFence(GLsync _sync) : m_sync(_sync) {}
+  bool signalled() override { return glClientWaitSync(m_sync, 0, 0) != GL_TIMEOUT_EXPIRED; }
+  void block() override
+  {
+    // the first wait flushes so the fence is guaranteed to be submitted
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (glClientWaitSync(m_sync, flags, 1000000) == GL_TIMEOUT_EXPIRED)
+    {
+      flags = 0;
+    }
+  }
+
+private:
+  GLsync m_sync;
+};
+} // end anonymous namespace
+
+InstanceStream::InstanceStream(GLuint _regions) : m_regions(std::clamp(_regions, 1u, c_maxRegions))
+{
+}
+
+InstanceStream::~InstanceStream()
+{
+  release();
+}
+
+void InstanceStream::setRegions(GLuint _regions)
+{
+  _regions = std::clamp(_regions, 1u, c_maxRegions);
+  if (_regions != m_regions)
+  {
+    m_regions = _regions;
+    m_reallocate = true;
+  }
+}
+
+void InstanceStream::release()
+{
+  for (GLuint i = 0; i < c_maxRegions; ++i)
+  {
+    if (m_fences[i] != nullptr)
+    {
+      glDeleteSync(m_fences[i]);
+      m_fences[i] = nullptr;
+    }
+  }
+  if (m_mapped != nullptr)
+  {
+    glBindBuffer(GL_ARRAY_BUFFER, m_id);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_mapped = nullptr;
+  }
+  glDeleteBuffers(1, &m_id);
+  m_id = 0;
+  MemoryRegistry::shared().release(this);
+}
+
+void InstanceStream::allocate(GLsizeiptr _bytes)
+{
+  // the GPU may still be reading any of the regions
+  for (GLuint i = 0; i < c_maxRegions; ++i)
+  {
+    wait(i);
+  }
+  release();
+  GLint alignment = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  GLsizeiptr align = std::max<GLsizeiptr>(c_regionAlignment, alignment);
+  glGetIntegerv(GL_TEXTURE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  align = std::max<GLsizeiptr>(align, alignment);
+  // grow geometrically like InstanceBuffer so a slowly growing count doesn't re-create every frame
+  _bytes = std::max(_bytes, static_cast<GLsizeiptr>(m_regionSize * InstanceBuffer::c_growth));
+  m_regionSize = (std::max<GLsizeiptr>(_bytes, 1) + align - 1) / align * align;
+
+  m_persistent = InstanceBuffer::immutableStorageSupported();
+  glGenBuffers(1, &m_id);
+  glBindBuffer(GL_ARRAY_BUFFER, m_id);
+  if (m_persistent)
+  {
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLsizeiptr size = m_regionSize * m_regions;
+    glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+    m_mapped = static_cast<char *>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+  }
+  else
+  {
+    glBufferData(GL_ARRAY_BUFFER, m_regionSize, nullptr, GL_STREAM_DRAW);
+    m_staging.resize(static_cast<size_t>(m_regionSize));
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  // the orphaned fallback only holds one region (the driver keeps the old stores while in use)
+  MemoryRegistry::shared().set(MemoryRegistry::Category::Stream, this, m_regionSize * (m_persistent ? m_regions : 1));
+  MemoryRegistry::shared().set(MemoryRegistry::Category::CpuStaging, this, static_cast<int64_t>(m_staging.capacity()));
+  m_current = 0;
+  m_reallocate = false;
+  ++m_generation;
+}
+
+void InstanceStream::wait(GLuint _region)
+{
+  GLsync sync = m_fences[_region];
+  if (sync == nullptr)
+  {
+    return;
+  }
+  SyncFence fence(sync);
+  m_waits.wait(_region, fence);
+  glDeleteSync(sync);
+  m_fences[_region] = nullptr;
+}
+
+void *InstanceStream::map(GLsizeiptr _bytes)
+{
+  m_waits.frame();
+  m_writeSize = _bytes;
+  if (m_id == 0 || m_reallocate || _bytes > m_regionSize)
+  {
+    allocate(_bytes);
+  }
+  else if (m_persistent)
+  {
+    m_current = (m_current + 1) % m_regions;
+  }
+  if (!m_persistent)
+  {
+    return m_staging.data();
+  }
+  wait(m_current);
+  return m_mapped + offset();
+}
+
+void InstanceStream::unmap()
+{
+  if (!m_persistent)
+  {
+    // orphan the old store so we don't wait for the GPU to finish with it
+    glBindBuffer(GL_ARRAY_BUFFER, m_id);
+    glBufferData(GL_ARRAY_BUFFER, m_regionSize, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, m_writeSize, m_staging.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+}
+
+void InstanceStream::fence()
+{
+  if (m_persistent)
+  {
+    m_fences[m_current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+}
+
+void InstanceStream::printSummary(std::ostream &_out) const
+{
+  auto flags = _out.flags();
+  _out << std::fixed << std::setprecision(3);
+  _out << "Instance stream " << (m_persistent ? "persistent mapped " : "orphaned ") << m_regions << " regions of "
+       << m_regionSize / 1024 << "KB\n";
+  const auto &stats = m_waits.stats();
+  _out << "  frames " << stats.frames << " fence waits " << stats.waits << " total " << stats.totalWaitMs << "ms max " << stats.maxWaitMs
+       << "ms mean " << (stats.waits > 0 ? stats.totalWaitMs / stats.waits : 0.0) << "ms\n";
+  _out.flags(flags);
+}
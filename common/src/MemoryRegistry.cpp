@@ -0,0 +1,222 @@
+#include "MemoryRegistry.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+
+namespace
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the memory info tokens, not in the core headers
+//----------------------------------------------------------------------------------------------------------------------
+constexpr GLenum c_gpuMemoryInfoTotalAvailableNVX = 0x9048;
+constexpr GLenum c_gpuMemoryInfoCurrentAvailableNVX = 0x9049;
+constexpr GLenum c_textureFreeMemoryATI = 0x87FC;
+
+bool hasExtension(const char *_name)
+{
+  GLint numExtensions = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+  for (GLint i = 0; i < numExtensions; ++i)
+  {
+    auto name = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+    if (name != nullptr && std::strcmp(name, _name) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+double toMB(int64_t _bytes)
+{
+  return static_cast<double>(_bytes) / (1024.0 * 1024.0);
+}
+} // namespace
+
+MemoryRegistry &MemoryRegistry::shared()
+{
+  static MemoryRegistry registry;
+  return registry;
+}
+
+void MemoryRegistry::apply(Category _category, int64_t _delta)
+{
+  auto &category = m_categories[static_cast<size_t>(_category)];
+  category.current += _delta;
+  category.peak = std::max(category.peak, category.current);
+  auto &pool = m_pools[static_cast<size_t>(MemoryRegistry::pool(_category))];
+  pool.current += _delta;
+  pool.peak = std::max(pool.peak, pool.current);
+}
+
+void MemoryRegistry::set(Category _category, const void *_owner, int64_t _bytes)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto key = std::make_pair(_owner, _category);
+  auto entry = m_entries.find(key);
+  int64_t previous = entry != m_entries.end() ? entry->second : 0;
+  if (_bytes > 0)
+  {
+    m_entries[key] = _bytes;
+  }
+  else if (entry != m_entries.end())
+  {
+    m_entries.erase(entry);
+  }
+  apply(_category, _bytes - previous);
+}
+
+void MemoryRegistry::release(const void *_owner)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  // the entries are ordered by owner first so they are together
+  auto entry = m_entries.lower_bound(std::make_pair(_owner, Category::Points));
+  while (entry != m_entries.end() && entry->first.first == _owner)
+  {
+    apply(entry->first.second, -entry->second);
+    entry = m_entries.erase(entry);
+  }
+}
+
+MemoryRegistry::Usage MemoryRegistry::usage(Category _category) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_categories[static_cast<size_t>(_category)];
+}
+
+MemoryRegistry::Usage MemoryRegistry::usage(Pool _pool) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_pools[static_cast<size_t>(_pool)];
+}
+
+MemoryRegistry::DriverMemory MemoryRegistry::driverMemory()
+{
+  static const bool nvx = hasExtension("GL_NVX_gpu_memory_info");
+  static const bool ati = !nvx && hasExtension("GL_ATI_meminfo");
+  DriverMemory memory;
+  if (nvx)
+  {
+    GLint total = 0, available = 0;
+    glGetIntegerv(c_gpuMemoryInfoTotalAvailableNVX, &total);
+    glGetIntegerv(c_gpuMemoryInfoCurrentAvailableNVX, &available);
+    memory.source = "GL_NVX_gpu_memory_info";
+    memory.totalKB = total;
+    memory.availableKB = available;
+  }
+  else if (ati)
+  {
+    // total free, largest free block, total auxiliary free, largest auxiliary free block
+    GLint info[4] = {0, 0, 0, 0};
+    glGetIntegerv(c_textureFreeMemoryATI, info);
+    memory.source = "GL_ATI_meminfo";
+    memory.availableKB = info[0];
+  }
+  return memory;
+}
+
+int64_t MemoryRegistry::textureBytes(GLsizei _width, GLsizei _height, int _bytesPerTexel, int _levels)
+{
+  int64_t bytes = 0;
+  for (int level = 0; _levels <= 0 || level < _levels; ++level)
+  {
+    bytes += static_cast<int64_t>(_width) * _height * _bytesPerTexel;
+    if (_width == 1 && _height == 1)
+    {
+      break;
+    }
+    _width = std::max(_width / 2, 1);
+    _height = std::max(_height / 2, 1);
+  }
+  return bytes;
+}
+
+int64_t MemoryRegistry::textBytes(int _fontSize)
+{
+  constexpr int64_t printable = 95;
+  GLsizei size = 1;
+  while (size < _fontSize)
+  {
+    size *= 2;
+  }
+  return printable * textureBytes(size, size, 4);
+}
+
+const char *MemoryRegistry::categoryName(Category _category)
+{
+  switch (_category)
+  {
+  case Category::Points:
+    return "Points";
+  case Category::Matrices:
+    return "Matrices";
+  case Category::Stream:
+    return "Stream";
+  case Category::Culling:
+    return "Culling";
+  case Category::Textures:
+    return "Textures";
+  case Category::Meshes:
+    return "Meshes";
+  case Category::Text:
+    return "Text";
+  case Category::Uniforms:
+    return "Uniforms";
+  case Category::CpuStaging:
+    return "CpuStaging";
+  }
+  return "Unknown";
+}
+
+void MemoryRegistry::printSummary(std::ostream &_out) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto flags = _out.flags();
+  _out << std::fixed << std::setprecision(2);
+  _out << "Memory (MB current / peak)\n";
+  for (size_t i = 0; i < c_numCategories; ++i)
+  {
+    const auto &usage = m_categories[i];
+    if (usage.peak > 0)
+    {
+      _out << "  " << std::left << std::setw(12) << categoryName(static_cast<Category>(i)) << std::right << toMB(usage.current) << " / " << toMB(usage.peak) << "\n";
+    }
+  }
+  _out << "  GPU total   " << toMB(m_pools[0].current) << " / " << toMB(m_pools[0].peak) << "\n";
+  _out << "  CPU total   " << toMB(m_pools[1].current) << " / " << toMB(m_pools[1].peak) << "\n";
+  _out.flags(flags);
+}
+
+void MemoryRegistry::writeJson(std::ostream &_out, const DriverMemory *_driver) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  _out << "{\n  \"categories\": {\n";
+  for (size_t i = 0; i < c_numCategories; ++i)
+  {
+    auto category = static_cast<Category>(i);
+    const auto &usage = m_categories[i];
+    _out << "    \"" << categoryName(category) << "\": {\"pool\": \"" << (pool(category) == Pool::GPU ? "gpu" : "cpu") << "\", \"current\": " << usage.current
+         << ", \"peak\": " << usage.peak << "}" << (i + 1 < c_numCategories ? "," : "") << "\n";
+  }
+  _out << "  },\n";
+  _out << "  \"gpu\": {\"current\": " << m_pools[0].current << ", \"peak\": " << m_pools[0].peak << "},\n";
+  _out << "  \"cpu\": {\"current\": " << m_pools[1].current << ", \"peak\": " << m_pools[1].peak << "}";
+  if (_driver != nullptr)
+  {
+    _out << ",\n  \"driver\": {\"source\": \"" << _driver->source << "\", \"totalKB\": " << _driver->totalKB << ", \"availableKB\": " << _driver->availableKB << "}";
+  }
+  _out << "\n}\n";
+}
+
+bool MemoryRegistry::writeJson(const std::string &_fileName, const DriverMemory *_driver) const
+{
+  std::ofstream file(_fileName);
+  if (!file.is_open())
+  {
+    return false;
+  }
+  writeJson(file, _driver);
+  return true;
+}
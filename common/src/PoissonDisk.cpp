@@ -0,0 +1,424 @@
+#include "PoissonDisk.h"
+#include "BatchTransform.h"
+#include "CounterRandom.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <random>
+
+namespace
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief points per r * r area the dart throwing reaches with a fully packed density map, a
+/// little under what is measured so the first radius nearly always gives a surplus to thin
+//----------------------------------------------------------------------------------------------------------------------
+constexpr float c_packing = 0.6f;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief each retry shrinks the radius by this, a pass with too few points is thrown away
+//----------------------------------------------------------------------------------------------------------------------
+constexpr float c_shrink = 0.85f;
+constexpr unsigned c_maxPasses = 6;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the CounterRandom streams for the dart throwing and the thinning (indexed by tile) and
+/// the clearings noise (indexed by lattice point)
+//----------------------------------------------------------------------------------------------------------------------
+constexpr uint32_t c_sampleStream = 1;
+constexpr uint32_t c_thinStream = 2;
+constexpr uint32_t c_clearingStream = 3;
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the background grid for one radius, empty cells have an infinite x so the distance test
+/// always passes without a branch
+//----------------------------------------------------------------------------------------------------------------------
+struct Grid
+{
+  struct Point
+  {
+    float x;
+    float z;
+  };
+  float radius = 0.0f;
+  float cell = 0.0f;
+  float origin = 0.0f;
+  size_t cells = 0;
+  size_t tileCells = 0;
+  size_t tiles = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief cells either side of a cell that can hold a point within the radius
+  //----------------------------------------------------------------------------------------------------------------------
+  size_t reach = 0;
+  std::vector<Point> points;
+};
+
+float sampleDensity(const PoissonDisk::Settings &_settings, float _x, float _z)
+{
+  if (_settings.density.empty())
+  {
+    return 1.0f;
+  }
+  float u = std::clamp((_x + _settings.extent) / (2.0f * _settings.extent), 0.0f, 1.0f) * float(_settings.densityWidth - 1);
+  float v = std::clamp((_z + _settings.extent) / (2.0f * _settings.extent), 0.0f, 1.0f) * float(_settings.densityHeight - 1);
+  size_t x0 = std::min(static_cast<size_t>(u), _settings.densityWidth - 1);
+  size_t z0 = std::min(static_cast<size_t>(v), _settings.densityHeight - 1);
+  size_t x1 = std::min(x0 + 1, _settings.densityWidth - 1);
+  size_t z1 = std::min(z0 + 1, _settings.densityHeight - 1);
+  float fx = u - float(x0);
+  float fz = v - float(z0);
+  const float *row0 = &_settings.density[z0 * _settings.densityWidth];
+  const float *row1 = &_settings.density[z1 * _settings.densityWidth];
+  float top = row0[x0] + (row0[x1] - row0[x0]) * fx;
+  float bottom = row1[x0] + (row1[x1] - row1[x0]) * fx;
+  return top + (bottom - top) * fz;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief throw darts into the cells of one tile, only this tile's cells are written and only the
+/// neighbouring tiles' cells are read
+//----------------------------------------------------------------------------------------------------------------------
+void sampleTile(const PoissonDisk::Settings &_settings, Grid &io_grid, size_t _tileX, size_t _tileZ)
+{
+  size_t beginX = _tileX * io_grid.tileCells;
+  size_t beginZ = _tileZ * io_grid.tileCells;
+  size_t endX = std::min(beginX + io_grid.tileCells, io_grid.cells);
+  size_t endZ = std::min(beginZ + io_grid.tileCells, io_grid.cells);
+  size_t width = endX - beginX;
+  // each tile has its own sequence, the index is the tile so it doesn't matter which thread runs it
+  CounterRandom random(_settings.seed, c_sampleStream, static_cast<uint32_t>(_tileZ * io_grid.tiles + _tileX));
+  // visit the cells in a random order so the tile doesn't fill in rows
+  thread_local std::vector<uint32_t> order;
+  order.resize(width * (endZ - beginZ));
+  for (uint32_t i = 0; i < order.size(); ++i)
+  {
+    order[i] = i;
+  }
+  for (size_t i = order.size(); i > 1; --i)
+  {
+    std::swap(order[i - 1], order[random.below(static_cast<uint32_t>(i))]);
+  }
+  float radius2 = io_grid.radius * io_grid.radius;
+  for (auto local : order)
+  {
+    size_t cx = beginX + local % width;
+    size_t cz = beginZ + local / width;
+    float x0 = io_grid.origin + float(cx) * io_grid.cell;
+    float z0 = io_grid.origin + float(cz) * io_grid.cell;
+    float density = sampleDensity(_settings, x0 + 0.5f * io_grid.cell, z0 + 0.5f * io_grid.cell);
+    if (density < 1.0f && random.uniform() >= density)
+    {
+      continue;
+    }
+    size_t nx0 = cx > io_grid.reach ? cx - io_grid.reach : 0;
+    size_t nz0 = cz > io_grid.reach ? cz - io_grid.reach : 0;
+    size_t nx1 = std::min(cx + io_grid.reach, io_grid.cells - 1);
+    size_t nz1 = std::min(cz + io_grid.reach, io_grid.cells - 1);
+    for (unsigned attempt = 0; attempt < _settings.attempts; ++attempt)
+    {
+      float x = x0 + random.uniform() * io_grid.cell;
+      float z = z0 + random.uniform() * io_grid.cell;
+      bool clear = true;
+      for (size_t nz = nz0; nz <= nz1 && clear; ++nz)
+      {
+        const Grid::Point *row = &io_grid.points[nz * io_grid.cells];
+        for (size_t nx = nx0; nx <= nx1; ++nx)
+        {
+          float dx = row[nx].x - x;
+          float dz = row[nx].z - z;
+          if (dx * dx + dz * dz < radius2)
+          {
+            clear = false;
+            break;
+          }
+        }
+      }
+      if (clear)
+      {
+        io_grid.points[cz * io_grid.cells + cx] = {x, z};
+        break;
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief run _task(tileX, tileZ) over every tile on the pool, _phased splits them into four
+/// passes by parity so no two neighbouring tiles ever run together
+//----------------------------------------------------------------------------------------------------------------------
+template <typename Task>
+void forEachTile(size_t _tiles, bool _phased, const Task &_task)
+{
+  auto &pool = WorkerPool::shared();
+  if (!_phased)
+  {
+    pool.run(_tiles * _tiles, [&](size_t _index) { _task(_index % _tiles, _index / _tiles); });
+    return;
+  }
+  for (size_t phase = 0; phase < 4; ++phase)
+  {
+    size_t offsetX = phase & 1;
+    size_t offsetZ = phase >> 1;
+    size_t across = (_tiles - offsetX + 1) / 2;
+    size_t down = (_tiles - offsetZ + 1) / 2;
+    if (across == 0 || down == 0)
+    {
+      continue;
+    }
+    pool.run(across * down, [&](size_t _index)
+             { _task(offsetX + 2 * (_index % across), offsetZ + 2 * (_index / across)); });
+  }
+}
+
+size_t tileCount(const Grid &_grid, size_t _tileX, size_t _tileZ)
+{
+  size_t beginX = _tileX * _grid.tileCells;
+  size_t beginZ = _tileZ * _grid.tileCells;
+  size_t endX = std::min(beginX + _grid.tileCells, _grid.cells);
+  size_t endZ = std::min(beginZ + _grid.tileCells, _grid.cells);
+  size_t count = 0;
+  for (size_t z = beginZ; z < endZ; ++z)
+  {
+    for (size_t x = beginX; x < endX; ++x)
+    {
+      count += std::isfinite(_grid.points[z * _grid.cells + x].x) ? 1 : 0;
+    }
+  }
+  return count;
+}
+
+double msSince(std::chrono::steady_clock::time_point _start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the closest pair in 16 floats per instance matrices, using a grid of _cell sized cells
+/// so only neighbouring cells are compared, pairs further apart than _cell are not found
+//----------------------------------------------------------------------------------------------------------------------
+float closestPair(const std::vector<float> &_matrices, float _extent, float _cell)
+{
+  size_t count = _matrices.size() / 16;
+  size_t cells = static_cast<size_t>(std::ceil(2.0f * _extent / _cell)) + 1;
+  std::vector<std::vector<uint32_t>> grid(cells * cells);
+  auto cellOf = [&](float _v) { return std::min(static_cast<size_t>((_v + _extent) / _cell), cells - 1); };
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    grid[cellOf(_matrices[i * 16 + 14]) * cells + cellOf(_matrices[i * 16 + 12])].push_back(i);
+  }
+  float best = std::numeric_limits<float>::infinity();
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    float x = _matrices[i * 16 + 12];
+    float z = _matrices[i * 16 + 14];
+    size_t cx = cellOf(x);
+    size_t cz = cellOf(z);
+    for (size_t nz = cz > 0 ? cz - 1 : 0; nz <= std::min(cz + 1, cells - 1); ++nz)
+    {
+      for (size_t nx = cx > 0 ? cx - 1 : 0; nx <= std::min(cx + 1, cells - 1); ++nx)
+      {
+        for (auto j : grid[nz * cells + nx])
+        {
+          if (j > i)
+          {
+            float dx = _matrices[j * 16 + 12] - x;
+            float dz = _matrices[j * 16 + 14] - z;
+            best = std::min(best, std::sqrt(dx * dx + dz * dz));
+          }
+        }
+      }
+    }
+  }
+  return best;
+}
+} // end anonymous namespace
+
+PoissonDisk::Stats PoissonDisk::generate(const Settings &_settings, float *o_matrices)
+{
+  Stats stats;
+  if (_settings.count == 0)
+  {
+    return stats;
+  }
+  auto start = std::chrono::steady_clock::now();
+  // the radius that packs count points into the area left once the density map has thinned it
+  float meanDensity = 1.0f;
+  if (!_settings.density.empty())
+  {
+    double sum = 0.0;
+    for (auto d : _settings.density)
+    {
+      sum += std::clamp(d, 0.0f, 1.0f);
+    }
+    meanDensity = std::max(static_cast<float>(sum / _settings.density.size()), 1e-3f);
+  }
+  float side = 2.0f * _settings.extent;
+  float radius = std::sqrt(c_packing * side * side * meanDensity / float(_settings.count));
+
+  Grid grid;
+  std::vector<size_t> counts;
+  size_t total = 0;
+  for (stats.passes = 1; stats.passes <= c_maxPasses; ++stats.passes, radius *= c_shrink)
+  {
+    grid.radius = radius;
+    grid.cells = std::max<size_t>(1, static_cast<size_t>(std::ceil(side / (radius / std::sqrt(2.0f)))));
+    grid.cell = side / float(grid.cells);
+    grid.origin = -_settings.extent;
+    grid.reach = static_cast<size_t>(std::ceil(radius / grid.cell));
+    grid.tileCells = std::max<size_t>({_settings.tileCells, grid.reach, 2});
+    grid.tiles = (grid.cells + grid.tileCells - 1) / grid.tileCells;
+    grid.points.assign(grid.cells * grid.cells, {std::numeric_limits<float>::infinity(), 0.0f});
+    forEachTile(grid.tiles, true, [&](size_t _x, size_t _z) { sampleTile(_settings, grid, _x, _z); });
+    counts.assign(grid.tiles * grid.tiles, 0);
+    forEachTile(grid.tiles, false, [&](size_t _x, size_t _z) { counts[_z * grid.tiles + _x] = tileCount(grid, _x, _z); });
+    total = 0;
+    for (auto c : counts)
+    {
+      total += c;
+    }
+    if (total >= _settings.count)
+    {
+      break;
+    }
+  }
+  stats.passes = std::min(stats.passes, c_maxPasses);
+  stats.radius = grid.radius;
+  stats.sampled = total;
+  stats.tiles = grid.tiles * grid.tiles;
+  stats.placed = std::min(total, _settings.count);
+  stats.sampleMs = msSince(start);
+
+  // each tile keeps its share of the count, rounding the running total so the shares add up
+  // exactly and a tile never keeps more than it has, then writes them at its own offset
+  start = std::chrono::steady_clock::now();
+  std::vector<size_t> offsets(counts.size() + 1, 0);
+  size_t running = 0;
+  for (size_t t = 0; t < counts.size(); ++t)
+  {
+    running += counts[t];
+    offsets[t + 1] = total == 0 ? 0 : static_cast<size_t>(static_cast<unsigned long long>(running) * stats.placed / total);
+  }
+  float scaleRange = _settings.maxScale - _settings.minScale;
+  forEachTile(grid.tiles, false,
+              [&](size_t _tileX, size_t _tileZ)
+              {
+                size_t tile = _tileZ * grid.tiles + _tileX;
+                size_t keep = offsets[tile + 1] - offsets[tile];
+                if (keep == 0)
+                {
+                  return;
+                }
+                thread_local std::vector<float> px, py, pz, scale;
+                px.clear();
+                pz.clear();
+                scale.clear();
+                py.assign(keep, 0.0f);
+                CounterRandom random(_settings.seed, c_thinStream, static_cast<uint32_t>(tile));
+                size_t left = counts[tile];
+                size_t beginX = _tileX * grid.tileCells;
+                size_t beginZ = _tileZ * grid.tileCells;
+                size_t endX = std::min(beginX + grid.tileCells, grid.cells);
+                size_t endZ = std::min(beginZ + grid.tileCells, grid.cells);
+                for (size_t z = beginZ; z < endZ && px.size() < keep; ++z)
+                {
+                  for (size_t x = beginX; x < endX && px.size() < keep; ++x)
+                  {
+                    const auto &point = grid.points[z * grid.cells + x];
+                    if (!std::isfinite(point.x))
+                    {
+                      continue;
+                    }
+                    // selection sampling, each point is kept with probability wanted / left so
+                    // exactly keep are chosen and they stay in grid order
+                    if (random.below(static_cast<uint32_t>(left--)) < keep - px.size())
+                    {
+                      px.push_back(point.x);
+                      pz.push_back(point.z);
+                      scale.push_back(_settings.minScale + random.uniform() * scaleRange);
+                    }
+                  }
+                }
+                BatchTransform::Transforms transforms;
+                transforms.px = px.data();
+                transforms.py = py.data();
+                transforms.pz = pz.data();
+                transforms.sx = transforms.sy = transforms.sz = scale.data();
+                transforms.count = keep;
+                BatchTransform::compose(transforms, o_matrices + offsets[tile] * 16);
+              });
+  stats.writeMs = msSince(start);
+  return stats;
+}
+
+std::vector<float> PoissonDisk::clearings(size_t _size, uint32_t _seed)
+{
+  // two octaves of value noise on a coarse lattice, smoothstepped so the low parts become
+  // clearings and the rest is near fully packed
+  constexpr size_t c_lattice = 17;
+  std::vector<float> lattice(c_lattice * c_lattice);
+  for (size_t i = 0; i < lattice.size(); ++i)
+  {
+    lattice[i] = CounterRandom::unit(CounterRandom::block(_seed, c_clearingStream, static_cast<uint32_t>(i))[0]);
+  }
+  auto smooth = [](float _t) { return _t * _t * (3.0f - 2.0f * _t); };
+  auto noise = [&](float _x, float _z)
+  {
+    size_t x0 = static_cast<size_t>(_x) % (c_lattice - 1);
+    size_t z0 = static_cast<size_t>(_z) % (c_lattice - 1);
+    float fx = smooth(_x - std::floor(_x));
+    float fz = smooth(_z - std::floor(_z));
+    float a = lattice[z0 * c_lattice + x0];
+    float b = lattice[z0 * c_lattice + x0 + 1];
+    float c = lattice[(z0 + 1) * c_lattice + x0];
+    float d = lattice[(z0 + 1) * c_lattice + x0 + 1];
+    return (a + (b - a) * fx) + ((c + (d - c) * fx) - (a + (b - a) * fx)) * fz;
+  };
+  std::vector<float> density(_size * _size);
+  float step = _size > 1 ? 4.0f / float(_size - 1) : 0.0f;
+  for (size_t z = 0; z < _size; ++z)
+  {
+    for (size_t x = 0; x < _size; ++x)
+    {
+      float n = 0.7f * noise(float(x) * step, float(z) * step) + 0.3f * noise(float(x) * step * 3.0f + 5.0f, float(z) * step * 3.0f + 5.0f);
+      density[z * _size + x] = smooth(std::clamp((n - 0.3f) / 0.25f, 0.0f, 1.0f));
+    }
+  }
+  return density;
+}
+
+void PoissonDisk::benchmark(std::ostream &_out, size_t _count)
+{
+  Settings settings;
+  settings.count = _count;
+  std::vector<float> matrices(_count * 16);
+  auto report = [&](const char *_name)
+  {
+    // a warm up so the pool threads and pages are in place, then the timed run
+    generate(settings, matrices.data());
+    Stats stats = generate(settings, matrices.data());
+    double ms = stats.sampleMs + stats.writeMs;
+    _out << std::left << std::setw(10) << _name << std::right << std::fixed << std::setprecision(2) << std::setw(9) << ms
+         << " ms (sample " << stats.sampleMs << " write " << stats.writeMs << ") " << std::setprecision(1)
+         << stats.placed / (ms * 1e3) << " M/s placed " << stats.placed << " of " << stats.sampled << " in " << stats.tiles
+         << " tiles, radius " << std::setprecision(3) << stats.radius << " closest " << closestPair(matrices, settings.extent, stats.radius * 2.0f)
+         << " passes " << stats.passes << '\n';
+  };
+  _out << "Poisson-disk placement of " << _count << " instances on " << WorkerPool::shared().size() << " threads\n";
+  report("uniform");
+  settings.density = clearings(256, settings.seed);
+  settings.densityWidth = settings.densityHeight = 256;
+  report("clearings");
+
+  // the old uniform random placement at the same count for comparison
+  std::mt19937 generator(settings.seed);
+  std::uniform_real_distribution<float> position(-settings.extent, settings.extent);
+  for (size_t i = 0; i < _count; ++i)
+  {
+    matrices[i * 16 + 12] = position(generator);
+    matrices[i * 16 + 14] = position(generator);
+  }
+  float spacing = 2.0f * settings.extent / std::sqrt(float(_count));
+  _out << "random closest pair " << std::setprecision(4) << closestPair(matrices, settings.extent, spacing) << " (mean spacing "
+       << spacing << ")\n";
+}
@@ -0,0 +1,339 @@
+#include "ProgramCache.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the start of every cache file, the key guards against hash collisions in the name
+//----------------------------------------------------------------------------------------------------------------------
+struct Header
+{
+  char magic[8] = {'N', 'G', 'L', 'P', 'B', 'I', 'N', '1'};
+  uint64_t key = 0;
+  GLenum format = 0;
+  uint32_t length = 0;
+  float compileMs = 0.0f;
+};
+
+const char *stageName(ngl::ShaderType _type)
+{
+  switch (_type)
+  {
+  case ngl::ShaderType::VERTEX:
+    return "Vertex";
+  case ngl::ShaderType::FRAGMENT:
+    return "Fragment";
+  case ngl::ShaderType::GEOMETRY:
+    return "Geometry";
+  case ngl::ShaderType::TESSCONTROL:
+    return "TessControl";
+  case ngl::ShaderType::TESSEVAL:
+    return "TessEval";
+  case ngl::ShaderType::COMPUTE:
+    return "Compute";
+  default:
+    return "Shader";
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief 64 bit FNV-1a, the strings are terminated so "ab"+"c" and "a"+"bc" differ
+//----------------------------------------------------------------------------------------------------------------------
+void fnv1a(uint64_t &io_hash, std::string_view _data)
+{
+  for (unsigned char c : _data)
+  {
+    io_hash = (io_hash ^ c) * 1099511628211ull;
+  }
+  io_hash = (io_hash ^ 0xff) * 1099511628211ull;
+}
+
+std::string glString(GLenum _name)
+{
+  auto str = glGetString(_name);
+  return str != nullptr ? reinterpret_cast<const char *>(str) : "unknown";
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point _start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+}
+} // namespace
+
+ProgramCache &ProgramCache::shared()
+{
+  static ProgramCache cache;
+  return cache;
+}
+
+bool ProgramCache::binariesSupported()
+{
+  static const bool supported = []()
+  {
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+  }();
+  return supported;
+}
+
+std::string ProgramCache::readSource(std::string_view _file, const std::string &_defines)
+{
+  std::ifstream file{std::string(_file)};
+  if (!file.is_open())
+  {
+    std::cerr << "unable to open shader source " << _file << "\n";
+    return {};
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  std::string source = buffer.str();
+  // splice in the includes, they are part of the source text so they are part of the cache key
+  constexpr std::string_view c_include = "#include \"";
+  for (auto pos = source.find(c_include); pos != std::string::npos; pos = source.find(c_include, pos))
+  {
+    // only at the start of a line, not in a comment
+    if (pos != 0 && source[pos - 1] != '\n')
+    {
+      pos += c_include.size();
+      continue;
+    }
+    auto close = source.find('"', pos + c_include.size());
+    auto end = source.find('\n', pos);
+    if (close == std::string::npos || close > end)
+    {
+      break;
+    }
+    auto name = source.substr(pos + c_include.size(), close - pos - c_include.size());
+    auto included = readSource((std::filesystem::path(std::string(_file)).parent_path() / name).string());
+    source.replace(pos, (end == std::string::npos ? source.size() : end) - pos, included);
+    pos += included.size();
+  }
+  if (!_defines.empty())
+  {
+    // #version must stay the first line so the defines go straight after it
+    auto pos = source.find("#version");
+    pos = pos == std::string::npos ? 0 : source.find('\n', pos) + 1;
+    source.insert(pos, _defines);
+  }
+  return source;
+}
+
+const std::string &ProgramCache::driverString()
+{
+  static const std::string driver = glString(GL_VENDOR) + "\n" + glString(GL_RENDERER) + "\n" + glString(GL_VERSION);
+  return driver;
+}
+
+uint64_t ProgramCache::hash(const Program &_program)
+{
+  uint64_t key = 14695981039346656037ull;
+  fnv1a(key, driverString());
+  fnv1a(key, _program.name);
+  for (const auto &stage : _program.stages)
+  {
+    fnv1a(key, stageName(stage.type));
+    fnv1a(key, stage.source);
+  }
+  for (const auto &varying : _program.varyings)
+  {
+    fnv1a(key, varying);
+  }
+  for (const auto &attribute : _program.attributes)
+  {
+    fnv1a(key, std::to_string(attribute.first));
+    fnv1a(key, attribute.second);
+  }
+  return key;
+}
+
+std::string ProgramCache::fileName(const Program &_program, uint64_t _key) const
+{
+  std::stringstream name;
+  name << m_directory << "/" << _program.name << "-" << std::hex << std::setw(16) << std::setfill('0') << _key << ".bin";
+  return name.str();
+}
+
+void ProgramCache::compile(const Program &_program, GLuint _id, bool _retrievable)
+{
+  for (const auto &stage : _program.stages)
+  {
+    std::string shader = _program.name + stageName(stage.type);
+    ngl::ShaderLib::attachShader(shader, stage.type);
+    ngl::ShaderLib::loadShaderSourceFromString(shader, stage.source);
+    ngl::ShaderLib::compileShader(shader);
+    ngl::ShaderLib::attachShaderToProgram(_program.name, shader);
+  }
+  for (const auto &attribute : _program.attributes)
+  {
+    ngl::ShaderLib::bindAttribute(_program.name, attribute.first, attribute.second);
+  }
+  if (!_program.varyings.empty())
+  {
+    std::vector<const char *> names;
+    for (const auto &varying : _program.varyings)
+    {
+      names.push_back(varying.c_str());
+    }
+    glTransformFeedbackVaryings(_id, static_cast<GLsizei>(names.size()), names.data(), GL_INTERLEAVED_ATTRIBS);
+  }
+  if (_retrievable)
+  {
+    glProgramParameteri(_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
+  ngl::ShaderLib::linkProgramObject(_program.name);
+}
+
+bool ProgramCache::load(GLuint _id, const std::string &_file, uint64_t _key)
+{
+  std::ifstream file(_file, std::ios::binary);
+  if (!file.is_open())
+  {
+    return false;
+  }
+  Header header, expected;
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!file || std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.key != _key)
+  {
+    return false;
+  }
+  std::vector<char> binary(header.length);
+  file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+  if (!file)
+  {
+    return false;
+  }
+  glProgramBinary(_id, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+  // a driver can reject a binary it wrote (e.g. after an update that didn't change the version string)
+  GLint linked = GL_FALSE;
+  glGetProgramiv(_id, GL_LINK_STATUS, &linked);
+  if (linked != GL_TRUE)
+  {
+    ++m_stats.rejected;
+    return false;
+  }
+  m_stats.hitCompileMs += header.compileMs;
+  return true;
+}
+
+bool ProgramCache::binary(GLuint _id, Variant &o_variant)
+{
+  GLint length = 0;
+  glGetProgramiv(_id, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+  {
+    return false;
+  }
+  o_variant.binary.resize(static_cast<size_t>(length));
+  GLsizei written = 0;
+  glGetProgramBinary(_id, length, &written, &o_variant.format, o_variant.binary.data());
+  o_variant.binary.resize(static_cast<size_t>(written));
+  return written > 0;
+}
+
+bool ProgramCache::restore(GLuint _id, const Variant &_variant)
+{
+  if (_variant.binary.empty())
+  {
+    return false;
+  }
+  glProgramBinary(_id, _variant.format, _variant.binary.data(), static_cast<GLsizei>(_variant.binary.size()));
+  GLint linked = GL_FALSE;
+  glGetProgramiv(_id, GL_LINK_STATUS, &linked);
+  return linked == GL_TRUE;
+}
+
+void ProgramCache::save(const Variant &_variant, const std::string &_file, uint64_t _key, float _compileMs) const
+{
+  Header header;
+  header.key = _key;
+  header.compileMs = _compileMs;
+  header.format = _variant.format;
+  header.length = static_cast<uint32_t>(_variant.binary.size());
+  std::error_code error;
+  std::filesystem::create_directories(m_directory, error);
+  std::ofstream file(_file, std::ios::binary);
+  if (!file.is_open())
+  {
+    std::cerr << "unable to write program cache " << _file << "\n";
+    return;
+  }
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(_variant.binary.data(), static_cast<std::streamsize>(_variant.binary.size()));
+}
+
+bool ProgramCache::build(const Program &_program)
+{
+  // the define set is part of the stage sources so it is part of the key, each name + key is its
+  // own variant and switching between the define sets of one name doesn't lose either of them
+  uint64_t key = hash(_program);
+  auto current = m_current.find(_program.name);
+  if (current != m_current.end() && current->second == key)
+  {
+    ++m_stats.reused;
+    ngl::ShaderLib::use(_program.name);
+    return false;
+  }
+  m_current[_program.name] = key;
+  auto start = std::chrono::steady_clock::now();
+  ngl::ShaderLib::createShaderProgram(_program.name);
+  GLuint id = ngl::ShaderLib::getProgramID(_program.name);
+  bool cached = m_enabled && binariesSupported();
+  auto &variant = m_variants[{_program.name, key}];
+  // ShaderLib holds one program per name so a variant built earlier this run is put back from
+  // the binary kept in memory
+  if (cached && restore(id, variant))
+  {
+    ++m_stats.reused;
+  }
+  else
+  {
+    std::string file = cached ? fileName(_program, key) : std::string();
+    // the ShaderLib program is used as normal once the binary is loaded, the shaders are never
+    // attached so there is nothing to compile
+    if (cached && load(id, file, key))
+    {
+      ++m_stats.hits;
+      m_stats.loadMs += elapsedMs(start);
+      binary(id, variant);
+    }
+    else
+    {
+      compile(_program, id, cached);
+      double ms = elapsedMs(start);
+      ++m_stats.misses;
+      m_stats.compileMs += ms;
+      if (cached && binary(id, variant))
+      {
+        save(variant, file, key, static_cast<float>(ms));
+      }
+    }
+  }
+  ngl::ShaderLib::use(_program.name);
+  ngl::ShaderLib::autoRegisterUniforms(_program.name);
+  return true;
+}
+
+void ProgramCache::printSummary(std::ostream &_out) const
+{
+  auto flags = _out.flags();
+  _out << std::fixed << std::setprecision(2);
+  _out << "Program cache " << (m_enabled && binariesSupported() ? m_directory : std::string("off")) << " : " << m_stats.hits << " loaded in " << m_stats.loadMs
+       << "ms, " << m_stats.misses << " compiled in " << m_stats.compileMs << "ms";
+  if (m_stats.reused > 0)
+  {
+    _out << ", " << m_stats.reused << " variants reused";
+  }
+  if (m_stats.rejected > 0)
+  {
+    _out << " (" << m_stats.rejected << " binaries rejected)";
+  }
+  _out << ", saved " << m_stats.hitCompileMs - m_stats.loadMs << "ms\n";
+  _out.flags(flags);
+}
@@ -0,0 +1,87 @@
+#include "RadixSort.h"
+#include <algorithm>
+#include <cstring>
+
+uint32_t RadixSort::floatKey(float _value)
+{
+  // the bits of a positive IEEE float sort the same as the value
+  uint32_t key;
+  _value = std::max(_value, 0.0f);
+  std::memcpy(&key, &_value, sizeof(key));
+  return key;
+}
+
+void RadixSort::sort(std::vector<uint32_t> &io_keys, std::vector<uint32_t> &io_values, WorkerPool &_pool)
+{
+  size_t count = io_keys.size();
+  m_keys.resize(count);
+  m_values.resize(count);
+  size_t tasks = std::clamp<size_t>(count / c_minPerTask, 1, _pool.size());
+  m_histograms.resize(tasks);
+  auto chunk = [count, tasks](size_t _task, size_t &o_begin, size_t &o_end)
+  {
+    o_begin = count * _task / tasks;
+    o_end = count * (_task + 1) / tasks;
+  };
+
+  uint32_t *srcKeys = io_keys.data();
+  uint32_t *srcValues = io_values.data();
+  uint32_t *dstKeys = m_keys.data();
+  uint32_t *dstValues = m_values.data();
+  bool inScratch = false;
+  for (uint32_t shift = 0; shift < 32; shift += 8)
+  {
+    _pool.run(tasks,
+              [&](size_t _task)
+              {
+                size_t begin, end;
+                chunk(_task, begin, end);
+                auto &histogram = m_histograms[_task];
+                histogram.fill(0);
+                for (size_t i = begin; i < end; ++i)
+                {
+                  ++histogram[(srcKeys[i] >> shift) & 0xff];
+                }
+              });
+    // digit major then chunk order keeps the sort stable
+    uint32_t offset = 0;
+    bool skip = false;
+    for (size_t digit = 0; digit < 256 && !skip; ++digit)
+    {
+      uint32_t digitCount = 0;
+      for (auto &histogram : m_histograms)
+      {
+        uint32_t c = histogram[digit];
+        histogram[digit] = offset + digitCount;
+        digitCount += c;
+      }
+      offset += digitCount;
+      skip = digitCount == count;
+    }
+    if (skip)
+    {
+      continue;
+    }
+    _pool.run(tasks,
+              [&](size_t _task)
+              {
+                size_t begin, end;
+                chunk(_task, begin, end);
+                auto &histogram = m_histograms[_task];
+                for (size_t i = begin; i < end; ++i)
+                {
+                  uint32_t position = histogram[(srcKeys[i] >> shift) & 0xff]++;
+                  dstKeys[position] = srcKeys[i];
+                  dstValues[position] = srcValues[i];
+                }
+              });
+    std::swap(srcKeys, dstKeys);
+    std::swap(srcValues, dstValues);
+    inScratch = !inScratch;
+  }
+  if (inScratch)
+  {
+    io_keys.swap(m_keys);
+    io_values.swap(m_values);
+  }
+}
@@ -0,0 +1,157 @@
+#include "RenderScheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+RenderScheduler::RenderScheduler(QOpenGLWindow *_window, FrameStats *_stats, Mode _mode)
+    : m_window(_window), m_stats(_stats), m_mode(_mode), m_resumeMode(_mode == Mode::OnDemand ? Mode::Continuous : _mode)
+{
+  m_runStart = m_windowStart = m_lastSwap = Clock::now();
+  m_runCPU = m_windowCPU = std::clock();
+  m_connection = QObject::connect(m_window, &QOpenGLWindow::frameSwapped, [this]()
+                                  { frameSwapped(); });
+}
+
+RenderScheduler::~RenderScheduler()
+{
+  QObject::disconnect(m_connection);
+}
+
+void RenderScheduler::setMode(Mode _mode)
+{
+  m_mode = _mode;
+  if (_mode != Mode::OnDemand)
+  {
+    m_resumeMode = _mode;
+  }
+  // restart the measurements as the numbers are not comparable
+  m_windowStart = m_lastSwap = Clock::now();
+  m_windowCPU = std::clock();
+  m_windowFrames = 0;
+  m_intervalSum = m_intervalSumSq = 0.0;
+  m_idle = true;
+  markDirty();
+}
+
+void RenderScheduler::toggleOnDemand()
+{
+  setMode(m_mode == Mode::OnDemand ? m_resumeMode : Mode::OnDemand);
+}
+
+void RenderScheduler::markDirty()
+{
+  m_dirty = true;
+  // Qt will merge multiple requests into one paint
+  m_window->update();
+}
+
+void RenderScheduler::setAnimating(bool _animating)
+{
+  m_animating = _animating;
+  if (m_animating)
+  {
+    markDirty();
+  }
+}
+
+void RenderScheduler::beginFrame()
+{
+  m_dirty = false;
+  if (m_idle)
+  {
+    // don't count the time we were waiting for input as a frame, or as a swap interval
+    m_stats->resetTick();
+    m_lastSwap = Clock::now();
+    m_idle = false;
+  }
+  m_stats->tick();
+}
+
+void RenderScheduler::frameSwapped()
+{
+  auto now = Clock::now();
+  ++m_presented;
+  if (!m_idle)
+  {
+    double interval = std::chrono::duration<double, std::milli>(now - m_lastSwap).count();
+    m_intervalSum += interval;
+    m_intervalSumSq += interval * interval;
+    ++m_windowFrames;
+  }
+  m_lastSwap = now;
+
+  double elapsed = std::chrono::duration<double>(now - m_windowStart).count();
+  if (elapsed >= 1.0)
+  {
+    auto cpu = std::clock();
+    m_report.cpuPercent = static_cast<float>(100.0 * (cpu - m_windowCPU) / CLOCKS_PER_SEC / elapsed);
+    m_report.fps = static_cast<float>(m_windowFrames / elapsed);
+    if (m_windowFrames > 0)
+    {
+      double mean = m_intervalSum / m_windowFrames;
+      m_report.intervalMs = static_cast<float>(mean);
+      m_report.jitterMs = static_cast<float>(std::sqrt(std::max(0.0, m_intervalSumSq / m_windowFrames - mean * mean)));
+    }
+    m_windowStart = now;
+    m_windowCPU = cpu;
+    m_windowFrames = 0;
+    m_intervalSum = m_intervalSumSq = 0.0;
+  }
+
+  switch (m_mode)
+  {
+  case Mode::Continuous:
+  case Mode::Benchmark:
+    m_window->update();
+    break;
+  case Mode::OnDemand:
+    if (m_animating)
+    {
+      markDirty();
+    }
+    // nothing has asked for another frame so we go idle until input arrives
+    m_idle = !m_dirty;
+    break;
+  }
+}
+
+void RenderScheduler::printSummary(std::ostream &_out) const
+{
+  double wall = std::chrono::duration<double>(Clock::now() - m_runStart).count();
+  double cpu = static_cast<double>(std::clock() - m_runCPU) / CLOCKS_PER_SEC;
+  _out << "Render mode " << modeName(m_mode) << " presented " << m_presented << " frames in "
+       << std::fixed << std::setprecision(2) << wall << "s CPU " << cpu << "s ("
+       << (wall > 0.0 ? 100.0 * cpu / wall : 0.0) << "% of a core)\n";
+}
+
+const char *RenderScheduler::modeName(Mode _mode)
+{
+  switch (_mode)
+  {
+  case Mode::Continuous:
+    return "continuous";
+  case Mode::OnDemand:
+    return "ondemand";
+  case Mode::Benchmark:
+    return "benchmark";
+  }
+  return "continuous";
+}
+
+RenderScheduler::Mode RenderScheduler::modeFromName(std::string_view _name)
+{
+  if (_name == "ondemand")
+  {
+    return Mode::OnDemand;
+  }
+  else if (_name == "benchmark")
+  {
+    return Mode::Benchmark;
+  }
+  return Mode::Continuous;
+}
+
+int RenderScheduler::swapInterval(Mode _mode)
+{
+  return _mode == Mode::Benchmark ? 0 : 1;
+}
@@ -0,0 +1,27 @@
+#include "ShaderDefines.h"
+
+ShaderDefines &ShaderDefines::set(std::string_view _name, std::string_view _value)
+{
+  m_defines[std::string(_name)] = std::string(_value);
+  return *this;
+}
+
+ShaderDefines &ShaderDefines::set(std::string_view _name, long long _value)
+{
+  return set(_name, std::to_string(_value));
+}
+
+std::string ShaderDefines::text() const
+{
+  std::string text;
+  for (const auto &define : m_defines)
+  {
+    text += "#define " + define.first;
+    if (!define.second.empty())
+    {
+      text += " " + define.second;
+    }
+    text += "\n";
+  }
+  return text;
+}
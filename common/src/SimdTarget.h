@@ -0,0 +1,52 @@
+#ifndef SIMDTARGET_H_
+#define SIMDTARGET_H_
+#include <algorithm>
+#include <chrono>
+//----------------------------------------------------------------------------------------------------------------------
+/// @file SimdTarget.h
+/// @brief private to common/src, what the hand vectorised kernel sets (BatchTransform,
+/// CounterRandom) share so they are built the same way
+/// @author Jonathan Macey
+/// @version 1.0
+/// @date 19/10/26
+/// SIMD_X86 is defined on x86 / x64 with the intrinsics included, TARGET_SSE2 / TARGET_AVX2 mark a
+/// kernel as built for that instruction set without raising the baseline of the whole file, which
+/// kernel runs is picked at run time by BatchTransform::isa(). AVX2 kernels may use FMA as isa()
+/// only reports AVX2 when both are there.
+//----------------------------------------------------------------------------------------------------------------------
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC lets any function use the intrinsics, the dispatch makes sure they are only run if supported
+#define TARGET_SSE2
+#define TARGET_AVX2
+#else
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+namespace simd
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the best of a few runs in ms, the first run also faults the output pages in
+//----------------------------------------------------------------------------------------------------------------------
+template <typename Function>
+double bestOf(Function &&_function)
+{
+  double best = 0.0;
+  for (int run = 0; run < 5; ++run)
+  {
+    auto start = std::chrono::steady_clock::now();
+    _function();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    best = run == 0 ? ms : std::min(best, ms);
+  }
+  return best;
+}
+} // namespace simd
+
+#endif
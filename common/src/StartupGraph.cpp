@@ -0,0 +1,189 @@
+#include "StartupGraph.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+StartupGraph::StartupGraph() : m_start(Clock::now())
+{
+}
+
+StartupGraph::~StartupGraph()
+{
+  cancel();
+}
+
+void StartupGraph::cancel()
+{
+  for (auto &stage : m_stages)
+  {
+    if (stage->thread.joinable())
+    {
+      stage->thread.join();
+    }
+  }
+  m_cancelled = true;
+}
+
+float StartupGraph::elapsedMs() const
+{
+  return std::chrono::duration<float, std::milli>(Clock::now() - m_start).count();
+}
+
+size_t StartupGraph::add(const std::string &_name, Kind _kind, const std::vector<size_t> &_needs, Job _job)
+{
+  auto stage = std::make_unique<Stage>();
+  stage->name = _name;
+  stage->kind = _kind;
+  stage->needs = _needs;
+  stage->job = std::move(_job);
+  m_stages.push_back(std::move(stage));
+  return m_stages.size() - 1;
+}
+
+bool StartupGraph::ready(const Stage &_stage) const
+{
+  return std::all_of(_stage.needs.begin(), _stage.needs.end(), [this](size_t _need) { return m_stages[_need]->state == State::Done; });
+}
+
+void StartupGraph::schedule()
+{
+  for (auto &stage : m_stages)
+  {
+    if (stage->state == State::Running && stage->kind == Kind::Cpu && stage->complete.load(std::memory_order_acquire))
+    {
+      stage->thread.join();
+      stage->state = State::Done;
+      ++m_finished;
+    }
+  }
+  for (auto &stage : m_stages)
+  {
+    if (stage->state != State::Waiting || !ready(*stage))
+    {
+      continue;
+    }
+    if (stage->readyMs < 0.0f)
+    {
+      stage->readyMs = elapsedMs();
+    }
+    if (stage->kind != Kind::Cpu)
+    {
+      continue;
+    }
+    stage->startMs = elapsedMs();
+    stage->state = State::Running;
+    Stage *running = stage.get();
+    stage->thread = std::thread(
+        [this, running]()
+        {
+          running->job();
+          running->endMs = elapsedMs();
+          running->complete.store(true, std::memory_order_release);
+        });
+  }
+}
+
+bool StartupGraph::pump(float _budgetMs)
+{
+  if (m_cancelled)
+  {
+    return finished();
+  }
+  float start = elapsedMs();
+  schedule();
+  bool ranOne = false;
+  while (!finished() && (!ranOne || elapsedMs() - start < _budgetMs))
+  {
+    // GL stages run in the order they were added
+    auto next = std::find_if(m_stages.begin(), m_stages.end(),
+                             [this](const std::unique_ptr<Stage> &_stage)
+                             { return _stage->state == State::Waiting && _stage->kind == Kind::Gl && ready(*_stage); });
+    if (next == m_stages.end())
+    {
+      break;
+    }
+    auto &stage = **next;
+    stage.startMs = elapsedMs();
+    stage.state = State::Running;
+    stage.job();
+    stage.endMs = elapsedMs();
+    stage.state = State::Done;
+    ++m_finished;
+    ranOne = true;
+    // anything waiting on this can start now rather than next frame
+    schedule();
+  }
+  return finished();
+}
+
+void StartupGraph::finish()
+{
+  while (!pump(1.0e9f) && !m_cancelled)
+  {
+    // only CPU stages left, give them the core rather than spinning
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+std::string StartupGraph::running() const
+{
+  std::string names;
+  for (const auto &stage : m_stages)
+  {
+    if (stage->state == State::Running)
+    {
+      names += (names.empty() ? "" : ", ") + stage->name;
+    }
+  }
+  return names;
+}
+
+void StartupGraph::markFirstFrame()
+{
+  if (m_firstFrameMs < 0.0f)
+  {
+    m_firstFrameMs = elapsedMs();
+  }
+}
+
+void StartupGraph::printTrace(std::ostream &_out) const
+{
+  auto flags = _out.flags();
+  _out << std::fixed << std::setprecision(1);
+  _out << "Startup trace (ms from start)\n";
+  _out << std::left << std::setw(24) << "stage" << std::right << std::setw(6) << "kind" << std::setw(10) << "ready" << std::setw(10) << "start"
+       << std::setw(10) << "end" << std::setw(10) << "took" << '\n';
+  float serial = 0.0f;
+  float end = 0.0f;
+  for (const auto &stage : m_stages)
+  {
+    float took = stage->endMs - stage->startMs;
+    serial += took;
+    end = std::max(end, stage->endMs);
+    _out << std::left << std::setw(24) << stage->name << std::right << std::setw(6) << (stage->kind == Kind::Gl ? "GL" : "CPU") << std::setw(10)
+         << stage->readyMs << std::setw(10) << stage->startMs << std::setw(10) << stage->endMs << std::setw(10) << took << '\n';
+  }
+  _out << "first frame " << m_firstFrameMs << "ms, ready " << end << "ms, the stages one after another would take " << serial << "ms\n";
+  _out.flags(flags);
+}
+
+bool StartupGraph::writeTrace(const std::string &_fileName) const
+{
+  std::ofstream file(_fileName);
+  if (!file.is_open())
+  {
+    return false;
+  }
+  // complete ("X") events in microseconds, GL stages on one track and each CPU stage on its own
+  file << "{\"traceEvents\":[\n";
+  for (size_t i = 0; i < m_stages.size(); ++i)
+  {
+    const auto &stage = *m_stages[i];
+    file << "  {\"name\":\"" << stage.name << "\",\"cat\":\"" << (stage.kind == Kind::Gl ? "gl" : "cpu") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+         << (stage.kind == Kind::Gl ? 0 : i + 1) << ",\"ts\":" << static_cast<int64_t>(stage.startMs * 1000.0f)
+         << ",\"dur\":" << static_cast<int64_t>((stage.endMs - stage.startMs) * 1000.0f) << "},\n";
+  }
+  file << "  {\"name\":\"first frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":" << static_cast<int64_t>(m_firstFrameMs * 1000.0f)
+       << "}\n]}\n";
+  return static_cast<bool>(file);
+}
@@ -0,0 +1,81 @@
+#include "TBOInstanceRenderer.h"
+#include "InstanceLimits.h"
+#include <ngl/ShaderLib.h>
+#include <algorithm>
+
+constexpr auto c_program = "TBOInstancing";
+
+TBOInstanceRenderer::~TBOInstanceRenderer()
+{
+  for (auto &attachment : m_attachments)
+  {
+    glDeleteTextures(1, &attachment.texture);
+  }
+}
+
+void TBOInstanceRenderer::initialize()
+{
+  for (auto encoding : {Encoding::Mat4, Encoding::Affine})
+  {
+    for (auto pass : c_passes)
+    {
+      for (auto multiView : c_viewModes)
+      {
+        createProgram(c_program, "shaders/TBOVertex.glsl", encoding, pass, multiView);
+        // the TBO is always on texture unit 0 and the colour texture on unit 1
+        ngl::ShaderLib::setUniform("TBO", 0);
+      }
+    }
+  }
+}
+
+GLuint TBOInstanceRenderer::attach(GLuint _buffer, uint32_t _generation, GLintptr _offset, GLsizeiptr _maxBytes)
+{
+  auto found = std::find_if(m_attachments.begin(), m_attachments.end(), [&](const Attachment &_a)
+                            { return _a.buffer == _buffer && _a.generation == _generation && _a.offset == _offset; });
+  if (found == m_attachments.end())
+  {
+    // only re-attach when the buffer storage has been re-allocated or we are reading from a different
+    // offset (e.g. the next region of an InstanceStream), re-use the least recently used texture
+    if (m_attachments.size() < c_maxAttachments)
+    {
+      Attachment attachment;
+      glGenTextures(1, &attachment.texture);
+      m_attachments.push_back(attachment);
+    }
+    found = m_attachments.end() - 1;
+    // Note GL_RGBA32F as each matrix is 4 (or 3 for affine) vec4 in size, we attach from the offset
+    // to the end of the store (up to the texel limit) so changes in the count don't need a re-attach,
+    // the 64 bit query as the store can be over 2GB
+    GLint64 bufferSize = 0;
+    glBindBuffer(GL_TEXTURE_BUFFER, _buffer);
+    glGetBufferParameteri64v(GL_TEXTURE_BUFFER, GL_BUFFER_SIZE, &bufferSize);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_BUFFER, found->texture);
+    glTexBufferRange(GL_TEXTURE_BUFFER, GL_RGBA32F, _buffer, _offset, std::min<GLint64>(bufferSize - _offset, _maxBytes));
+    found->buffer = _buffer;
+    found->generation = _generation;
+    found->offset = _offset;
+  }
+  std::rotate(m_attachments.begin(), found, found + 1);
+  return m_attachments.front().texture;
+}
+
+void TBOInstanceRenderer::draw(const Mesh &_mesh, const InstanceData &_data, const ngl::Mat4 &_project, Pass _pass)
+{
+  useProgram(c_program, _data, _project, _pass);
+  glActiveTexture(GL_TEXTURE0);
+  GLuint stride = InstanceRenderer::stride(_data.encoding);
+  GLuint perDraw = InstanceLimits::get().tboInstances(_data.encoding);
+  // in multi view each instance is drawn once per view, the shader divides gl_InstanceID back down
+  GLuint views = std::max(m_views, 1u);
+  glBindVertexArray(_mesh.vao);
+  for (GLuint first = 0; first < _data.count; first += perDraw)
+  {
+    GLuint count = std::min(perDraw, _data.count - first);
+    GLintptr offset = _data.offset + static_cast<GLintptr>(first) * stride;
+    glBindTexture(GL_TEXTURE_BUFFER, attach(_data.buffer, _data.generation, offset, static_cast<GLsizeiptr>(perDraw) * stride));
+    glDrawArraysInstanced(GL_TRIANGLES, 0, _mesh.numVerts, count * views);
+  }
+  glBindVertexArray(0);
+}
@@ -0,0 +1,393 @@
+#include "TileStreamer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+
+namespace
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the manifest starts with this, followed by a ManifestEntry per tile
+//----------------------------------------------------------------------------------------------------------------------
+struct ManifestHeader
+{
+  char magic[8] = {'N', 'G', 'L', 'T', 'I', 'L', 'E', '2'};
+  uint64_t count = 0;
+  uint32_t seed = 0;
+  float tileSize = 0.0f;
+  uint32_t tiles = 0;
+};
+
+struct ManifestEntry
+{
+  int32_t x = 0;
+  int32_t z = 0;
+  uint32_t count = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief each tile file starts with this, followed by count matrices
+//----------------------------------------------------------------------------------------------------------------------
+struct TileHeader
+{
+  char magic[8] = {'N', 'G', 'L', 'T', 'D', 'A', 'T', '1'};
+  int64_t key = 0;
+  uint32_t count = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief resident tiles are kept until they are this much further than the load radius
+//----------------------------------------------------------------------------------------------------------------------
+constexpr float c_keepFactor = 1.25f;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief how long a tile that couldn't be read waits before it is tried again
+//----------------------------------------------------------------------------------------------------------------------
+constexpr auto c_retryDelay = std::chrono::seconds(1);
+
+std::string manifestFile(const std::string &_dir)
+{
+  return (std::filesystem::path(_dir) / "manifest.bin").string();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief read and check the manifest header
+/// @returns false if there isn't one or it is from another version
+//----------------------------------------------------------------------------------------------------------------------
+bool readManifest(std::ifstream &_file, ManifestHeader &o_header)
+{
+  ManifestHeader expected;
+  _file.read(reinterpret_cast<char *>(&o_header), sizeof(o_header));
+  return _file && std::memcmp(o_header.magic, expected.magic, sizeof(o_header.magic)) == 0 && o_header.tileSize > 0.0f;
+}
+
+int32_t tileX(int64_t _key)
+{
+  return static_cast<int32_t>(_key >> 32);
+}
+
+int32_t tileZ(int64_t _key)
+{
+  return static_cast<int32_t>(static_cast<uint32_t>(_key));
+}
+} // end anonymous namespace
+
+TileStreamer::~TileStreamer()
+{
+  stop();
+}
+
+std::string TileStreamer::tileFile(const std::string &_dir, int64_t _key)
+{
+  return (std::filesystem::path(_dir) / ("tile_" + std::to_string(tileX(_key)) + "_" + std::to_string(tileZ(_key)) + ".bin")).string();
+}
+
+bool TileStreamer::bake(const std::string &_dir, const ngl::Mat4 *_matrices, size_t _count, const Generation &_generation)
+{
+  std::unordered_map<int64_t, std::vector<ngl::Mat4>> tiles;
+  for (size_t i = 0; i < _count; ++i)
+  {
+    auto x = static_cast<int32_t>(std::floor(_matrices[i].m_m[3][0] / _generation.tileSize));
+    auto z = static_cast<int32_t>(std::floor(_matrices[i].m_m[3][2] / _generation.tileSize));
+    tiles[key(x, z)].push_back(_matrices[i]);
+  }
+  std::error_code error;
+  std::filesystem::create_directories(_dir, error);
+  // the old manifest goes first so a failed bake isn't mistaken for the old one, then the old
+  // tiles as another tile size leaves files this bake won't overwrite
+  std::filesystem::remove(manifestFile(_dir), error);
+  for (const auto &entry : std::filesystem::directory_iterator(_dir, error))
+  {
+    auto name = entry.path().filename().string();
+    if (name.rfind("tile_", 0) == 0 && entry.path().extension() == ".bin")
+    {
+      std::filesystem::remove(entry.path(), error);
+    }
+  }
+  std::vector<ManifestEntry> entries;
+  entries.reserve(tiles.size());
+  for (const auto &tile : tiles)
+  {
+    auto name = tileFile(_dir, tile.first);
+    std::ofstream file(name, std::ios::binary);
+    if (!file.is_open())
+    {
+      std::cerr << "unable to write tile " << name << "\n";
+      return false;
+    }
+    TileHeader header;
+    header.key = tile.first;
+    header.count = static_cast<uint32_t>(tile.second.size());
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(tile.second.data()), static_cast<std::streamsize>(tile.second.size() * sizeof(ngl::Mat4)));
+    entries.push_back({tileX(tile.first), tileZ(tile.first), header.count});
+  }
+  // the manifest is written last so a partly baked directory isn't used
+  std::ofstream file(manifestFile(_dir), std::ios::binary);
+  if (!file.is_open())
+  {
+    std::cerr << "unable to write tile manifest in " << _dir << "\n";
+    return false;
+  }
+  ManifestHeader header;
+  header.count = _generation.count;
+  header.seed = _generation.seed;
+  header.tileSize = _generation.tileSize;
+  header.tiles = static_cast<uint32_t>(entries.size());
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(ManifestEntry)));
+  return static_cast<bool>(file);
+}
+
+bool TileStreamer::baked(const std::string &_dir, const Generation &_generation)
+{
+  std::ifstream file(manifestFile(_dir), std::ios::binary);
+  ManifestHeader header;
+  return readManifest(file, header) && header.count == _generation.count && header.seed == _generation.seed &&
+         header.tileSize == _generation.tileSize;
+}
+
+bool TileStreamer::start(const std::string &_dir, float _radius, int64_t _budgetBytes)
+{
+  stop();
+  std::ifstream file(manifestFile(_dir), std::ios::binary);
+  ManifestHeader header;
+  if (!readManifest(file, header))
+  {
+    std::cerr << "no tile manifest in " << _dir << "\n";
+    return false;
+  }
+  std::vector<ManifestEntry> entries(header.tiles);
+  file.read(reinterpret_cast<char *>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(ManifestEntry)));
+  if (!file)
+  {
+    std::cerr << "truncated tile manifest in " << _dir << "\n";
+    return false;
+  }
+  m_dir = _dir;
+  m_tileSize = header.tileSize;
+  m_radius = _radius;
+  m_budget = _budgetBytes;
+  m_counts.clear();
+  m_failed.clear();
+  for (const auto &entry : entries)
+  {
+    m_counts[key(entry.x, entry.z)] = entry.count;
+  }
+  m_stats = Stats();
+  m_stats.tiles = m_counts.size();
+  m_stop = false;
+  m_thread = std::thread(&TileStreamer::loop, this);
+  return true;
+}
+
+void TileStreamer::stop()
+{
+  if (!m_thread.joinable())
+  {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  m_thread.join();
+  m_queue.clear();
+  m_loading.clear();
+  m_loaded.clear();
+}
+
+void TileStreamer::loop()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true)
+  {
+    m_wake.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+    if (m_stop)
+    {
+      return;
+    }
+    int64_t tile = m_queue.front();
+    m_queue.erase(m_queue.begin());
+    m_loading.insert(tile);
+    lock.unlock();
+    // the read is the slow part so it happens outside the lock, m_counts isn't changed while the
+    // thread runs
+    Loaded loaded{tile, {}, true};
+    std::ifstream file(tileFile(m_dir, tile), std::ios::binary);
+    TileHeader header, expected;
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    // the count has to match the manifest as the budget was worked out from it
+    if (file && std::memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0 && header.key == tile && header.count == m_counts.at(tile))
+    {
+      loaded.matrices.resize(header.count);
+      file.read(reinterpret_cast<char *>(loaded.matrices.data()), static_cast<std::streamsize>(header.count * sizeof(ngl::Mat4)));
+      loaded.failed = !file;
+      if (loaded.failed)
+      {
+        loaded.matrices.clear();
+      }
+    }
+    lock.lock();
+    m_loading.erase(tile);
+    m_loaded.push_back(std::move(loaded));
+  }
+}
+
+void TileStreamer::evict(int64_t _key, InstancePool &io_pool)
+{
+  auto resident = m_resident.find(_key);
+  // the tiles are removed in reverse so the most recently added instances go first, they are
+  // the most likely to still be at the end where a removal doesn't move anything
+  for (auto handle = resident->second.rbegin(); handle != resident->second.rend(); ++handle)
+  {
+    io_pool.remove(*handle);
+  }
+  m_stats.residentInstances -= resident->second.size();
+  m_stats.residentBytes -= static_cast<int64_t>(resident->second.size() * sizeof(ngl::Mat4));
+  m_resident.erase(resident);
+  ++m_stats.evictions;
+}
+
+bool TileStreamer::update(const ngl::Vec3 &_eye, InstancePool &io_pool)
+{
+  if (!active())
+  {
+    return false;
+  }
+  auto now = Clock::now();
+  // the tiles near enough to the eye, nearest first, measured to the closest point of the tile
+  float keepRadius = m_radius * c_keepFactor;
+  auto x0 = static_cast<int32_t>(std::floor((_eye.m_x - keepRadius) / m_tileSize));
+  auto x1 = static_cast<int32_t>(std::floor((_eye.m_x + keepRadius) / m_tileSize));
+  auto z0 = static_cast<int32_t>(std::floor((_eye.m_z - keepRadius) / m_tileSize));
+  auto z1 = static_cast<int32_t>(std::floor((_eye.m_z + keepRadius) / m_tileSize));
+  std::vector<std::pair<float, int64_t>> nearby;
+  for (int32_t z = z0; z <= z1; ++z)
+  {
+    for (int32_t x = x0; x <= x1; ++x)
+    {
+      int64_t tile = key(x, z);
+      if (m_counts.count(tile) == 0)
+      {
+        continue;
+      }
+      float dx = std::max({x * m_tileSize - _eye.m_x, 0.0f, _eye.m_x - (x + 1) * m_tileSize});
+      float dz = std::max({z * m_tileSize - _eye.m_z, 0.0f, _eye.m_z - (z + 1) * m_tileSize});
+      float distance = std::sqrt(dx * dx + dz * dz);
+      // past the load radius only the tiles already resident are kept
+      if (distance <= m_radius || (distance <= keepRadius && m_resident.count(tile) != 0))
+      {
+        nearby.emplace_back(distance, tile);
+      }
+    }
+  }
+  std::sort(nearby.begin(), nearby.end());
+  // take them in order until the budget is used, the rest are evicted / not loaded
+  std::unordered_set<int64_t> chosen;
+  int64_t bytes = 0;
+  for (const auto &tile : nearby)
+  {
+    int64_t tileBytes = static_cast<int64_t>(m_counts[tile.second]) * static_cast<int64_t>(sizeof(ngl::Mat4));
+    if (bytes + tileBytes > m_budget)
+    {
+      break;
+    }
+    bytes += tileBytes;
+    chosen.insert(tile.second);
+  }
+  bool changed = false;
+  for (auto resident = m_resident.begin(); resident != m_resident.end();)
+  {
+    auto tile = (resident++)->first;
+    if (chosen.count(tile) == 0)
+    {
+      evict(tile, io_pool);
+      changed = true;
+    }
+  }
+  for (auto wanted = m_wanted.begin(); wanted != m_wanted.end();)
+  {
+    wanted = chosen.count(wanted->first) == 0 ? m_wanted.erase(wanted) : std::next(wanted);
+  }
+
+  std::vector<Loaded> loaded;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    loaded.swap(m_loaded);
+  }
+  for (auto &tile : loaded)
+  {
+    // leave it out of the pool, it is asked for again once the retry delay has passed
+    if (tile.failed)
+    {
+      if (m_failed.count(tile.key) == 0)
+      {
+        std::cerr << "unable to read tile " << tileFile(m_dir, tile.key) << ", will retry\n";
+      }
+      m_failed[tile.key] = now;
+      m_wanted.erase(tile.key);
+      ++m_stats.failures;
+      continue;
+    }
+    m_failed.erase(tile.key);
+    // the eye may have moved on while it was being read
+    if (chosen.count(tile.key) == 0 || m_resident.count(tile.key) != 0)
+    {
+      ++m_stats.discarded;
+      continue;
+    }
+    auto &handles = m_resident[tile.key];
+    handles.resize(tile.matrices.size());
+    std::copy(tile.matrices.begin(), tile.matrices.end(), io_pool.append(tile.matrices.size(), handles.data()));
+    m_stats.residentInstances += tile.matrices.size();
+    m_stats.residentBytes += static_cast<int64_t>(tile.matrices.size() * sizeof(ngl::Mat4));
+    ++m_stats.loads;
+    auto wanted = m_wanted.find(tile.key);
+    if (wanted != m_wanted.end())
+    {
+      m_stats.lastLatencyMs = std::chrono::duration<float, std::milli>(Clock::now() - wanted->second).count();
+      m_stats.maxLatencyMs = std::max(m_stats.maxLatencyMs, m_stats.lastLatencyMs);
+      m_stats.totalLatencyMs += m_stats.lastLatencyMs;
+      m_wanted.erase(wanted);
+    }
+    changed = true;
+  }
+  m_stats.resident = m_resident.size();
+
+  // queue what is still missing, nearest first, skipping anything being read or just read
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queue.clear();
+    for (const auto &tile : nearby)
+    {
+      auto failed = m_failed.find(tile.second);
+      if (chosen.count(tile.second) == 0 || m_resident.count(tile.second) != 0 || m_loading.count(tile.second) != 0 ||
+          (failed != m_failed.end() && now - failed->second < c_retryDelay) ||
+          std::any_of(m_loaded.begin(), m_loaded.end(), [&](const Loaded &_loaded) { return _loaded.key == tile.second; }))
+      {
+        continue;
+      }
+      m_queue.push_back(tile.second);
+      m_wanted.emplace(tile.second, now);
+    }
+    m_stats.queued = m_queue.size() + m_loading.size();
+  }
+  m_wake.notify_one();
+  return changed;
+}
+
+void TileStreamer::printSummary(std::ostream &_out) const
+{
+  auto flags = _out.flags();
+  _out << std::fixed << std::setprecision(1);
+  _out << "Tile streaming " << m_stats.resident << " of " << m_stats.tiles << " tiles resident (" << m_stats.residentInstances
+       << " instances " << m_stats.residentBytes / (1024.0 * 1024.0) << "MB of " << m_budget / (1024.0 * 1024.0) << "MB), "
+       << m_stats.loads << " loads " << m_stats.evictions << " evictions " << m_stats.discarded << " discarded " << m_stats.failures << " failed, latency mean "
+       << (m_stats.loads > 0 ? m_stats.totalLatencyMs / m_stats.loads : 0.0) << "ms max " << m_stats.maxLatencyMs << "ms\n";
+  _out.flags(flags);
+}
@@ -0,0 +1,57 @@
+#include "UBOInstanceRenderer.h"
+#include "InstanceLimits.h"
+#include <ngl/ShaderLib.h>
+#include <algorithm>
+#include <iostream>
+
+constexpr auto c_program = "UBOInstancing";
+
+void UBOInstanceRenderer::initialize()
+{
+  for (auto encoding : {Encoding::Mat4, Encoding::Affine})
+  {
+    // the largest batch the driver allows, GL_MAX_UNIFORM_BLOCK_SIZE / the size of the data we want
+    // to pass into the uniform block (a series of matrices) kept to the offset alignment, the
+    // shader array is declared this size by addDefines so the two always agree
+    GLuint perBlock = InstanceLimits::get().uboInstances(encoding);
+    m_instancesPerBlock[static_cast<size_t>(encoding)] = perBlock;
+    std::cout << "Number of " << encodingName(encoding) << " instances per block is " << perBlock << "\n";
+    for (auto pass : c_passes)
+    {
+      for (auto multiView : c_viewModes)
+      {
+        createProgram(c_program, "shaders/UBOVertex.glsl", encoding, pass, multiView);
+        GLuint id = ngl::ShaderLib::getProgramID(programName(c_program, encoding, pass, multiView));
+        glUniformBlockBinding(id, glGetUniformBlockIndex(id, "UBO"), 0);
+      }
+    }
+  }
+}
+
+void UBOInstanceRenderer::addDefines(ShaderDefines &io_defines, Encoding _encoding) const
+{
+  io_defines.set("INSTANCES_PER_BLOCK", m_instancesPerBlock[static_cast<size_t>(_encoding)]);
+}
+
+void UBOInstanceRenderer::draw(const Mesh &_mesh, const InstanceData &_data, const ngl::Mat4 &_project, Pass _pass)
+{
+  useProgram(c_program, _data, _project, _pass);
+  glBindVertexArray(_mesh.vao);
+  // now draw instances in batches of m_instancesPerBlock
+  GLuint stride = InstanceRenderer::stride(_data.encoding);
+  GLuint views = std::max(m_views, 1u);
+  GLuint instancesDrawn = 0, instancesToDraw = m_instancesPerBlock[static_cast<size_t>(_data.encoding)];
+  while (instancesDrawn < _data.count)
+  {
+    if (instancesDrawn + instancesToDraw > _data.count)
+    {
+      instancesToDraw = _data.count - instancesDrawn;
+    }
+    // bind the range of the data to draw, in this case it will go in block from
+    // 0-1024, 1024-2048 etc etc until we have drawn all
+    glBindBufferRange(GL_UNIFORM_BUFFER, 0, _data.buffer, _data.offset + static_cast<GLintptr>(instancesDrawn) * stride, instancesToDraw * stride);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, _mesh.numVerts, instancesToDraw * views);
+    instancesDrawn += instancesToDraw;
+  }
+  glBindVertexArray(0);
+}
@@ -0,0 +1,58 @@
+#include "ViewSet.h"
+#include "MemoryRegistry.h"
+#include <algorithm>
+#include <cmath>
+
+ViewSet::~ViewSet()
+{
+  glDeleteBuffers(1, &m_ubo);
+  MemoryRegistry::shared().release(this);
+}
+
+void ViewSet::initialize()
+{
+  GLint maxViewports = 1;
+  glGetIntegerv(GL_MAX_VIEWPORTS, &maxViewports);
+  m_maxViews = std::min(c_maxViews, static_cast<GLuint>(maxViewports));
+  glGenBuffers(1, &m_ubo);
+  glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+  glBufferData(GL_UNIFORM_BUFFER, c_maxViews * sizeof(ngl::Mat4), nullptr, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  MemoryRegistry::shared().set(MemoryRegistry::Category::Uniforms, this, c_maxViews * sizeof(ngl::Mat4));
+}
+
+void ViewSet::layoutGrid(GLuint _count, int _x, int _y, int _width, int _height)
+{
+  m_count = std::clamp(_count, 1u, m_maxViews);
+  GLuint columns = static_cast<GLuint>(std::ceil(std::sqrt(static_cast<float>(m_count))));
+  GLuint rows = (m_count + columns - 1) / columns;
+  GLfloat width = static_cast<GLfloat>(_width) / columns;
+  GLfloat height = static_cast<GLfloat>(_height) / rows;
+  for (GLuint i = 0; i < m_count; ++i)
+  {
+    // GL has the origin bottom left so fill the rows from the top
+    m_viewports[i * 4 + 0] = _x + (i % columns) * width;
+    m_viewports[i * 4 + 1] = _y + (rows - 1 - i / columns) * height;
+    m_viewports[i * 4 + 2] = width;
+    m_viewports[i * 4 + 3] = height;
+  }
+}
+
+float ViewSet::aspect(GLuint _view) const
+{
+  return m_viewports[_view * 4 + 2] / std::max(m_viewports[_view * 4 + 3], 1.0f);
+}
+
+void ViewSet::setViewProjections(const std::vector<ngl::Mat4> &_viewProjections)
+{
+  GLuint count = std::min(static_cast<GLuint>(_viewProjections.size()), c_maxViews);
+  glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, count * sizeof(ngl::Mat4), _viewProjections.data());
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void ViewSet::bind() const
+{
+  glBindBufferBase(GL_UNIFORM_BUFFER, c_binding, m_ubo);
+  glViewportArrayv(0, static_cast<GLsizei>(m_count), m_viewports.data());
+}
@@ -0,0 +1,91 @@
+#include "WorkerPool.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool(size_t _threads)
+{
+  if (_threads == 0)
+  {
+    _threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  // the caller works too so we only need one less
+  for (size_t i = 1; i < _threads; ++i)
+  {
+    m_threads.emplace_back(&WorkerPool::loop, this);
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  for (auto &thread : m_threads)
+  {
+    thread.join();
+  }
+}
+
+WorkerPool &WorkerPool::shared()
+{
+  static WorkerPool pool;
+  return pool;
+}
+
+void WorkerPool::run(size_t _tasks, const Task &_task)
+{
+  // not worth waking anyone
+  if (_tasks <= 1 || m_threads.empty())
+  {
+    for (size_t i = 0; i < _tasks; ++i)
+    {
+      _task(i);
+    }
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_task = &_task;
+    m_count = _tasks;
+    m_next = 0;
+    m_busy = m_threads.size();
+    ++m_generation;
+  }
+  m_wake.notify_all();
+  work();
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock, [this]() { return m_busy == 0; });
+  m_task = nullptr;
+}
+
+void WorkerPool::work()
+{
+  for (size_t task = m_next++; task < m_count; task = m_next++)
+  {
+    (*m_task)(task);
+  }
+}
+
+void WorkerPool::loop()
+{
+  uint64_t seen = 0;
+  for (;;)
+  {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wake.wait(lock, [&]() { return m_stop || m_generation != seen; });
+      if (m_stop)
+      {
+        return;
+      }
+      seen = m_generation;
+    }
+    work();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_busy == 0)
+    {
+      m_done.notify_one();
+    }
+  }
+}
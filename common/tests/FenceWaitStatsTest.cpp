@@ -0,0 +1,105 @@
+#include "FenceWaitStats.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief a fence the GPU is past after _pendingMs, 0 for one that has already completed
+//----------------------------------------------------------------------------------------------------------------------
+class FakeFence : public FenceWaitStats::Fence
+{
+public:
+  explicit FakeFence(int _pendingMs) : m_pendingMs(_pendingMs) {}
+  bool signalled() override { return m_pendingMs == 0; }
+  void block() override
+  {
+    ++m_blocks;
+    std::this_thread::sleep_for(std::chrono::milliseconds(m_pendingMs));
+    m_pendingMs = 0;
+  }
+  int blocks() const { return m_blocks; }
+
+private:
+  int m_pendingMs;
+  int m_blocks = 0;
+};
+
+int g_failures = 0;
+
+void check(bool _condition, const char *_what)
+{
+  if (!_condition)
+  {
+    std::cerr << "FAILED : " << _what << "\n";
+    ++g_failures;
+  }
+}
+} // end anonymous namespace
+
+int main()
+{
+  // completed fences are never waited on and leave the counts alone
+  {
+    FenceWaitStats waits;
+    for (unsigned region = 0; region < 3; ++region)
+    {
+      FakeFence done(0);
+      waits.frame();
+      check(waits.wait(region, done) == 0.0f, "a completed fence returns no wait");
+      check(done.blocks() == 0, "a completed fence isn't blocked on");
+    }
+    const auto &stats = waits.stats();
+    check(stats.frames == 3, "completed : frames counted");
+    check(stats.waits == 0, "completed : no waits");
+    check(stats.totalWaitMs == 0.0 && stats.maxWaitMs == 0.0f, "completed : no wait time");
+    check(stats.lastWaitRegion == -1, "completed : no waited region");
+  }
+  // under load with 1 region every frame waits on the same region
+  {
+    FenceWaitStats waits;
+    for (int frame = 0; frame < 4; ++frame)
+    {
+      FakeFence pending(5);
+      waits.frame();
+      check(waits.wait(0, pending) >= 5.0f, "1 region : the wait covers the pending time");
+      check(pending.blocks() == 1, "1 region : a pending fence is blocked on once");
+    }
+    const auto &stats = waits.stats();
+    check(stats.waits == 4, "1 region : every frame waits");
+    check(stats.totalWaitMs >= 20.0, "1 region : total covers every wait");
+    check(stats.maxWaitMs >= 5.0f && stats.maxWaitMs <= stats.totalWaitMs, "1 region : max is one of the waits");
+    check(stats.lastWaitRegion == 0 && stats.regionWaits.size() == 1 && stats.regionWaits[0] == 4, "1 region : all on region 0");
+  }
+  // with N regions only the one still in use waits, the max is the longest and the last wait is kept
+  // when a later fence has completed
+  {
+    constexpr unsigned c_regions = 3;
+    FenceWaitStats waits;
+    const int pendingMs[] = {0, 0, 2, 0, 0, 15, 0, 0, 0};
+    for (unsigned frame = 0; frame < 9; ++frame)
+    {
+      FakeFence fence(pendingMs[frame]);
+      waits.frame();
+      waits.wait(frame % c_regions, fence);
+    }
+    const auto &stats = waits.stats();
+    check(stats.frames == 9, "N regions : frames counted");
+    check(stats.waits == 2, "N regions : only the pending fences wait");
+    check(stats.maxWaitMs >= 15.0f, "N regions : max is the longest wait");
+    check(stats.totalWaitMs >= 17.0 && stats.totalWaitMs >= stats.maxWaitMs, "N regions : total covers both waits");
+    check(stats.lastWaitRegion == 2, "N regions : the region waited on is recorded");
+    check(stats.regionWaits.size() == c_regions && stats.regionWaits[0] == 0 && stats.regionWaits[1] == 0 && stats.regionWaits[2] == 2,
+          "N regions : waits counted per region");
+    check(stats.lastWaitMs == 0.0f, "N regions : the last fence had completed");
+    waits.reset();
+    check(waits.stats().waits == 0 && waits.stats().frames == 0 && waits.stats().lastWaitRegion == -1, "reset clears everything");
+  }
+  if (g_failures == 0)
+  {
+    std::cout << "FenceWaitStats tests passed\n";
+  }
+  return g_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}